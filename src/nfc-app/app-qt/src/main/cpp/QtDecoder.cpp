@@ -31,9 +31,11 @@
 
 #include <rt/Event.h>
 #include <rt/Subject.h>
+#include <rt/Latency.h>
 
 #include <sdr/SignalBuffer.h>
 
+#include <nfc/Nfc.h>
 #include <nfc/NfcFrame.h>
 
 #include <nfc/FrameDecoderTask.h>
@@ -354,7 +356,12 @@ struct QtDecoder::Impl
     */
    void frameEvent(const nfc::NfcFrame &frame)
    {
-      QtApplication::post(new StreamFrameEvent(frame), Qt::HighEventPriority);
+      // trace times are copied on write, view hop is not seen by other frame subscribers
+      nfc::NfcFrame traced = frame;
+
+      traced.setTraceTime(nfc::TraceHop::ViewPost, rt::Latency::now());
+
+      QtApplication::post(new StreamFrameEvent(traced), Qt::HighEventPriority);
    }
 
    /*
@@ -559,7 +566,7 @@ struct QtDecoder::Impl
             });
          });
       }
-      else if (fileName.endsWith(".xml") || fileName.endsWith(".json"))
+      else if (fileName.endsWith(".nfcd") || fileName.endsWith(".xml") || fileName.endsWith(".json"))
       {
          // clear storage queue
          taskStorageClear([=] {
@@ -583,7 +590,7 @@ struct QtDecoder::Impl
       if (fileName.endsWith(".wav"))
       {
       }
-      else if (fileName.endsWith(".xml") || fileName.endsWith(".json"))
+      else if (fileName.endsWith(".nfcd") || fileName.endsWith(".xml") || fileName.endsWith(".json"))
       {
          // start XML file write
          taskStorageWrite(json);
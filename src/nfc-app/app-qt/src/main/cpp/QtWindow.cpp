@@ -1119,7 +1119,7 @@ void QtWindow::clearView()
 
 void QtWindow::openFile()
 {
-   QString fileName = QFileDialog::getOpenFileName(this, tr("Open capture file"), "", tr("Capture (*.wav *.xml *.json);;All Files (*)"));
+   QString fileName = QFileDialog::getOpenFileName(this, tr("Open capture file"), "", tr("Capture (*.wav *.nfcd *.xml *.json);;All Files (*)"));
 
    if (!fileName.isEmpty())
    {
@@ -1143,9 +1143,9 @@ void QtWindow::openFile()
 void QtWindow::saveFile()
 {
    QString date = QDateTime::currentDateTime().toString("yyyyMMddHHmmss");
-   QString name = QString("record-%2.json").arg(date);
+   QString name = QString("record-%2.nfcd").arg(date);
 
-   QString fileName = QFileDialog::getSaveFileName(this, tr("Save record file"), name, tr("Capture (*.xml *.json);;All Files (*)"));
+   QString fileName = QFileDialog::getSaveFileName(this, tr("Save record file"), name, tr("Capture (*.nfcd);;JSON export (*.json);;All Files (*)"));
 
    if (!fileName.isEmpty())
    {
@@ -30,11 +30,17 @@
 #include <QDateTime>
 #include <QReadLocker>
 
+#include <rt/Logger.h>
+#include <rt/Latency.h>
+
 #include <nfc/Nfc.h>
 #include <nfc/NfcFrame.h>
 
 #include "StreamModel.h"
 
+// interval between frame latency reports, in milliseconds
+#define LATENCY_REPORT_INTERVAL 10000
+
 static QMap<int, QString> NfcACmd = {
       {0x1A, "AUTH"}, // MIFARE Ultralight C authentication
       {0x1B, "PWD_AUTH"}, // MIFARE Ultralight EV1
@@ -101,6 +107,8 @@ static QMap<int, QString> NfcVCmd = {
 
 struct StreamModel::Impl
 {
+   rt::Logger log {"StreamModel"};
+
    // time format
    int timeFormat = StreamModel::ElapsedTimeFormat;
 
@@ -121,6 +129,14 @@ struct StreamModel::Impl
    // stream lock
    QReadWriteLock lock;
 
+   // time from decoder emit to view post, from view post to model insert and from device capture to model insert
+   rt::Latency postLatency;
+   rt::Latency insertLatency;
+   rt::Latency totalLatency;
+
+   // last latency report
+   long long latencyReport = 0;
+
    explicit Impl()
    {
       headers << "#" << "Time" << "Delta" << "Rate" << "Type" << "Event" << "" << "Frame";
@@ -137,6 +153,32 @@ struct StreamModel::Impl
       qDeleteAll(frames);
    }
 
+   /*
+    * trace model insertion, last hop of frame latency
+    */
+   void traceInsert(nfc::NfcFrame *frame)
+   {
+      long long insertTime = rt::Latency::now();
+
+      frame->setTraceTime(nfc::TraceHop::ModelInsert, insertTime);
+
+      postLatency.update(frame->traceTime(nfc::TraceHop::FrameEmit), frame->traceTime(nfc::TraceHop::ViewPost));
+      insertLatency.update(frame->traceTime(nfc::TraceHop::ViewPost), insertTime);
+      totalLatency.update(frame->traceTime(nfc::TraceHop::DeviceCapture), insertTime);
+
+      if (totalLatency.count() > 0 && insertTime - latencyReport > LATENCY_REPORT_INTERVAL * 1000000LL)
+      {
+         log.info("frame latency post: {} insert: {} total: {}", {latencySummary(postLatency), latencySummary(insertLatency), latencySummary(totalLatency)});
+
+         latencyReport = insertTime;
+      }
+   }
+
+   static std::string latencySummary(const rt::Latency &latency)
+   {
+      return "p50 " + std::to_string(latency.percentile(0.50) / 1000) + "us p99 " + std::to_string(latency.percentile(0.99) / 1000) + "us max " + std::to_string(latency.maximum() / 1000) + "us";
+   }
+
    inline QString frameTime(const nfc::NfcFrame *frame)
    {
       switch (timeFormat)
@@ -574,7 +616,11 @@ void StreamModel::fetchMore(const QModelIndex &parent)
 
    while (!impl->stream.isEmpty())
    {
-      impl->frames.append(new nfc::NfcFrame(impl->stream.dequeue()));
+      auto frame = new nfc::NfcFrame(impl->stream.dequeue());
+
+      impl->traceInsert(frame);
+
+      impl->frames.append(frame);
    }
 
    endInsertRows();
@@ -587,6 +633,9 @@ void StreamModel::resetModel()
    beginResetModel();
    qDeleteAll(impl->frames);
    impl->frames.clear();
+   impl->postLatency.clear();
+   impl->insertLatency.clear();
+   impl->totalLatency.clear();
    endResetModel();
 }
 
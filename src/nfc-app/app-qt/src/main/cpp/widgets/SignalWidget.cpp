@@ -177,20 +177,18 @@ struct SignalWidget::Impl
             double sampleStep = 1 / sampleRate;
             double startTime = buffer.offset() / sampleRate;
 
-            for (int i = 0; i < buffer.elements(); i++)
-            {
-               double value = buffer[i];
-               double range = fma(sampleStep, i, startTime); // range = sampleStep * i + startTime
+            auto samples = buffer.readable();
 
-//               if (minimumScale > value * 0.75)
-//                  minimumScale = value * 0.75;
-//
-//               if (maximumScale < value * 1.25)
-//                  maximumScale = value * 1.25;
+            QVector<QCPGraphData> points(samples.size());
 
-               graphData->add({range, value});
+            for (int i = 0; i < samples.size(); i++)
+            {
+               points[i].key = fma(sampleStep, i, startTime); // range = sampleStep * i + startTime
+               points[i].value = samples[i];
             }
 
+            graphData->add(points, true);
+
             // update signal range
             if (graphData->size() > 0)
             {
@@ -207,21 +205,18 @@ struct SignalWidget::Impl
             double sampleStep = 1 / sampleRate;
             double startTime = buffer.offset() / sampleRate;
 
-            for (int i = 0; i < buffer.limit(); i += 2)
-            {
-               double value = buffer[i + 0];
-               double range = fma(sampleStep, buffer[i + 1], startTime); // range = sampleStep * buffer[i + 1] + startTime
+            auto samples = buffer.readable();
 
-               // update signal scale
-//               if (minimumScale > value * 0.75)
-//                  minimumScale = value * 0.75;
-//
-//               if (maximumScale < value * 1.25)
-//                  maximumScale = value * 1.25;
+            QVector<QCPGraphData> points(samples.size() / 2);
 
-               graphData->add({range, value});
+            for (int i = 0; i < points.size(); i++)
+            {
+               points[i].key = fma(sampleStep, samples[i * 2 + 1], startTime); // range = sampleStep * samples[i * 2 + 1] + startTime
+               points[i].value = samples[i * 2 + 0];
             }
 
+            graphData->add(points, true);
+
             // update signal range
             if (graphData->size() > 0)
             {
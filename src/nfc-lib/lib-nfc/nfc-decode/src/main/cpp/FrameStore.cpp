@@ -0,0 +1,670 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#define USE_POSIX_IO
+#endif
+
+#include <vector>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+#include <rt/Logger.h>
+
+#include <nfc/FrameStore.h>
+
+// maximum frames in each segment
+#define SEGMENT_FRAMES 4096
+
+// file format version
+#define FILE_VERSION 1
+
+// column alignment inside segments
+#define ALIGN(size) (((size) + 7) & ~7)
+
+namespace nfc {
+
+struct FileHeader
+{
+   char id[4]; // 4 bytes, "NFCD"
+   unsigned int version; // 4 bytes
+   unsigned int segmentFrames; // 4 bytes
+   unsigned int segmentCount; // 4 bytes
+   long long frameCount; // 8 bytes
+   long long indexOffset; // 8 bytes, zero while file is open for writing
+   double timeStart; // 8 bytes
+   double timeEnd; // 8 bytes
+   long long reserved[2]; // 16 bytes
+};
+
+struct SegmentHeader
+{
+   char id[4]; // 4 bytes, "SEGM"
+   unsigned int count; // 4 bytes, number of frames
+   unsigned int heapSize; // 4 bytes, payload bytes
+   unsigned int size; // 4 bytes, total segment size including header
+   double timeStart; // 8 bytes
+   double timeEnd; // 8 bytes
+};
+
+struct SegmentEntry
+{
+   long long offset; // 8 bytes, segment header file offset
+   unsigned int count; // 4 bytes
+   unsigned int heapSize; // 4 bytes
+   long long firstFrame; // 8 bytes
+   double timeStart; // 8 bytes
+   double timeEnd; // 8 bytes
+};
+
+/*
+ * Column pointers for one segment, all point inside file data
+ */
+struct Segment
+{
+   long long firstFrame;
+   unsigned int count;
+   double timeFirst;
+
+   const double *timeStart;
+   const double *timeEnd;
+   const double *dateTime;
+   const unsigned long long *sampleStart;
+   const unsigned long long *sampleEnd;
+   const unsigned int *frameFlags;
+   const unsigned int *frameRate;
+   const unsigned int *payload;
+   const unsigned short *techType;
+   const unsigned short *frameType;
+   const unsigned short *framePhase;
+   const unsigned char *heap;
+};
+
+/*
+ * Segment size for given frame and payload count, in 64 bits so sizes read from file can not wrap around
+ */
+inline unsigned long long segmentSize(unsigned long long count, unsigned long long heapSize)
+{
+   unsigned long long size = sizeof(SegmentHeader);
+
+   size += count * sizeof(double) * 3; // timeStart, timeEnd, dateTime
+   size += count * sizeof(unsigned long long) * 2; // sampleStart, sampleEnd
+   size += count * sizeof(unsigned int) * 2; // frameFlags, frameRate
+   size += (count + 1) * sizeof(unsigned int); // payload offsets
+   size += count * sizeof(unsigned short) * 3; // techType, frameType, framePhase
+   size = ALIGN(size);
+   size += ALIGN(heapSize);
+
+   return size;
+}
+
+struct FrameStore::Impl
+{
+   rt::Logger log {"FrameStore"};
+
+   std::string path;
+
+   int mode = 0;
+
+   // write mode columns for current segment
+   std::vector<double> timeStart;
+   std::vector<double> timeEnd;
+   std::vector<double> dateTime;
+   std::vector<unsigned long long> sampleStart;
+   std::vector<unsigned long long> sampleEnd;
+   std::vector<unsigned int> frameFlags;
+   std::vector<unsigned int> frameRate;
+   std::vector<unsigned int> payload;
+   std::vector<unsigned short> techType;
+   std::vector<unsigned short> frameType;
+   std::vector<unsigned short> framePhase;
+   std::vector<unsigned char> heap;
+
+   // segment serialization buffer
+   std::vector<unsigned char> block;
+
+   // written segments, stored as index at end of file
+   std::vector<SegmentEntry> index;
+
+   long long frameCount = 0;
+   long long fileOffset = 0;
+
+   std::ofstream output;
+
+   // read mode file contents, memory mapped or loaded
+   const unsigned char *fileData = nullptr;
+   size_t fileSize = 0;
+   bool mapped = false;
+   std::vector<unsigned char> fileBuffer;
+
+   std::vector<Segment> segments;
+
+   explicit Impl(std::string path) : path(std::move(path))
+   {
+   }
+
+   ~Impl()
+   {
+      close();
+   }
+
+   bool open(Mode openMode)
+   {
+      close();
+
+      mode = openMode;
+
+      if (mode == Write)
+         return openWrite();
+
+      if (mode == Read)
+         return openRead();
+
+      return false;
+   }
+
+   void close()
+   {
+      if (output.is_open())
+      {
+         writeSegment();
+         writeIndex();
+
+         output.close();
+      }
+
+      if (fileData)
+      {
+#ifdef USE_POSIX_IO
+         if (mapped)
+            munmap(const_cast<unsigned char *>(fileData), fileSize);
+#endif
+         fileData = nullptr;
+         fileSize = 0;
+         mapped = false;
+      }
+
+      fileBuffer.clear();
+      fileBuffer.shrink_to_fit();
+      segments.clear();
+      index.clear();
+      frameCount = 0;
+      mode = 0;
+   }
+
+   bool isOpen() const
+   {
+      return output.is_open() || fileData;
+   }
+
+   bool openWrite()
+   {
+      output.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+
+      if (!output.is_open())
+      {
+         log.warn("unable to create file [{}]", {path});
+         return false;
+      }
+
+      frameCount = 0;
+      fileOffset = sizeof(FileHeader);
+
+      reserve();
+
+      return writeHeader(0);
+   }
+
+   void reserve()
+   {
+      timeStart.reserve(SEGMENT_FRAMES);
+      timeEnd.reserve(SEGMENT_FRAMES);
+      dateTime.reserve(SEGMENT_FRAMES);
+      sampleStart.reserve(SEGMENT_FRAMES);
+      sampleEnd.reserve(SEGMENT_FRAMES);
+      frameFlags.reserve(SEGMENT_FRAMES);
+      frameRate.reserve(SEGMENT_FRAMES);
+      payload.reserve(SEGMENT_FRAMES + 1);
+      techType.reserve(SEGMENT_FRAMES);
+      frameType.reserve(SEGMENT_FRAMES);
+      framePhase.reserve(SEGMENT_FRAMES);
+   }
+
+   bool append(const NfcFrame &frame)
+   {
+      if (!output.is_open())
+         return false;
+
+      auto data = frame.readable();
+
+      if (payload.empty())
+         payload.push_back(0);
+
+      timeStart.push_back(frame.timeStart());
+      timeEnd.push_back(frame.timeEnd());
+      dateTime.push_back(frame.dateTime());
+      sampleStart.push_back(frame.sampleStart());
+      sampleEnd.push_back(frame.sampleEnd());
+      frameFlags.push_back(frame.frameFlags());
+      frameRate.push_back(frame.frameRate());
+      techType.push_back(frame.techType());
+      frameType.push_back(frame.frameType());
+      framePhase.push_back(frame.framePhase());
+
+      heap.insert(heap.end(), data.begin(), data.end());
+
+      payload.push_back(heap.size());
+
+      frameCount++;
+
+      if (timeStart.size() == SEGMENT_FRAMES)
+         return writeSegment();
+
+      return true;
+   }
+
+   template<typename T>
+   static unsigned char *column(unsigned char *dst, const std::vector<T> &values)
+   {
+      std::memcpy(dst, values.data(), values.size() * sizeof(T));
+
+      return dst + values.size() * sizeof(T);
+   }
+
+   bool writeSegment()
+   {
+      unsigned int count = timeStart.size();
+
+      if (!count)
+         return true;
+
+      auto size = (unsigned int) segmentSize(count, heap.size());
+
+      block.assign(size, 0);
+
+      SegmentHeader header {{'S', 'E', 'G', 'M'}, count, (unsigned int) heap.size(), size, timeStart.front(), timeEnd.back()};
+
+      unsigned char *dst = block.data();
+
+      std::memcpy(dst, &header, sizeof(header));
+
+      dst += sizeof(header);
+
+      // attribute columns
+      dst = column(dst, timeStart);
+      dst = column(dst, timeEnd);
+      dst = column(dst, dateTime);
+      dst = column(dst, sampleStart);
+      dst = column(dst, sampleEnd);
+      dst = column(dst, frameFlags);
+      dst = column(dst, frameRate);
+      dst = column(dst, payload);
+      dst = column(dst, techType);
+      dst = column(dst, frameType);
+      dst = column(dst, framePhase);
+
+      // payload heap
+      dst = block.data() + ALIGN(dst - block.data());
+
+      column(dst, heap);
+
+      index.push_back({fileOffset, count, (unsigned int) heap.size(), frameCount - count, header.timeStart, header.timeEnd});
+
+      output.write(reinterpret_cast<const char *>(block.data()), size);
+
+      fileOffset += size;
+
+      timeStart.clear();
+      timeEnd.clear();
+      dateTime.clear();
+      sampleStart.clear();
+      sampleEnd.clear();
+      frameFlags.clear();
+      frameRate.clear();
+      payload.clear();
+      techType.clear();
+      frameType.clear();
+      framePhase.clear();
+      heap.clear();
+
+      return output.good();
+   }
+
+   bool flush()
+   {
+      if (!output.is_open() || !writeSegment())
+         return false;
+
+      output.flush();
+
+      return output.good();
+   }
+
+   bool writeIndex()
+   {
+      output.seekp(fileOffset);
+      output.write(reinterpret_cast<const char *>(index.data()), index.size() * sizeof(SegmentEntry));
+
+      return writeHeader(fileOffset);
+   }
+
+   bool writeHeader(long long indexOffset)
+   {
+      FileHeader header {{'N', 'F', 'C', 'D'}, FILE_VERSION, SEGMENT_FRAMES};
+
+      header.segmentCount = index.size();
+      header.frameCount = frameCount;
+      header.indexOffset = indexOffset;
+      header.timeStart = index.empty() ? 0 : index.front().timeStart;
+      header.timeEnd = index.empty() ? 0 : index.back().timeEnd;
+
+      output.seekp(0);
+      output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+      output.seekp(fileOffset);
+
+      return output.good();
+   }
+
+   bool openRead()
+   {
+      if (!load())
+      {
+         log.warn("unable to read file [{}]", {path});
+         return false;
+      }
+
+      FileHeader header {};
+
+      if (fileSize < sizeof(header))
+         return fail("file too short");
+
+      std::memcpy(&header, fileData, sizeof(header));
+
+      if (std::memcmp(header.id, "NFCD", 4) != 0 || header.version != FILE_VERSION)
+         return fail("invalid file header");
+
+      if (header.indexOffset > 0)
+      {
+         // segment index written on close
+         if (header.indexOffset + header.segmentCount * sizeof(SegmentEntry) > fileSize)
+            return fail("invalid segment index");
+
+         auto entries = reinterpret_cast<const SegmentEntry *>(fileData + header.indexOffset);
+
+         long long first = 0;
+
+         for (unsigned int i = 0; i < header.segmentCount; i++)
+         {
+            if (entries[i].firstFrame != first || !addSegment(entries[i].offset, first))
+               return fail("invalid segment");
+
+            first += segments.back().count;
+         }
+      }
+      else
+      {
+         log.warn("file [{}] was not closed, scanning segments", {path});
+
+         // recover all complete segments
+         long long offset = sizeof(FileHeader);
+         long long first = 0;
+
+         while (addSegment(offset, first))
+         {
+            offset += reinterpret_cast<const SegmentHeader *>(fileData + offset)->size;
+            first += segments.back().count;
+         }
+      }
+
+      frameCount = segments.empty() ? 0 : segments.back().firstFrame + segments.back().count;
+
+      log.debug("opened file [{}] with {} frames in {} segments", {path, frameCount, segments.size()});
+
+      return true;
+   }
+
+   bool addSegment(long long offset, long long firstFrame)
+   {
+      if (offset < (long long) sizeof(FileHeader) || (unsigned long long) offset + sizeof(SegmentHeader) > fileSize)
+         return false;
+
+      auto header = reinterpret_cast<const SegmentHeader *>(fileData + offset);
+
+      if (std::memcmp(header->id, "SEGM", 4) != 0 || header->count == 0 || header->count > SEGMENT_FRAMES)
+         return false;
+
+      if (header->size != segmentSize(header->count, header->heapSize) || (unsigned long long) offset + header->size > fileSize)
+         return false;
+
+      unsigned int count = header->count;
+
+      const unsigned char *src = fileData + offset + sizeof(SegmentHeader);
+
+      Segment segment {firstFrame, count, header->timeStart};
+
+      segment.timeStart = reinterpret_cast<const double *>(src);
+      segment.timeEnd = segment.timeStart + count;
+      segment.dateTime = segment.timeEnd + count;
+      segment.sampleStart = reinterpret_cast<const unsigned long long *>(segment.dateTime + count);
+      segment.sampleEnd = segment.sampleStart + count;
+      segment.frameFlags = reinterpret_cast<const unsigned int *>(segment.sampleEnd + count);
+      segment.frameRate = segment.frameFlags + count;
+      segment.payload = segment.frameRate + count;
+      segment.techType = reinterpret_cast<const unsigned short *>(segment.payload + count + 1);
+      segment.frameType = segment.techType + count;
+      segment.framePhase = segment.frameType + count;
+      segment.heap = fileData + offset + ALIGN(reinterpret_cast<const unsigned char *>(segment.framePhase + count) - (fileData + offset));
+
+      // payload offsets must start at heap begin, never decrease and end at heap size, frame() trusts them
+      if (segment.payload[0] != 0 || segment.payload[count] != header->heapSize)
+         return false;
+
+      for (unsigned int i = 0; i < count; i++)
+      {
+         if (segment.payload[i + 1] < segment.payload[i])
+            return false;
+      }
+
+      segments.push_back(segment);
+
+      return true;
+   }
+
+   bool load()
+   {
+#ifdef USE_POSIX_IO
+      int fd = ::open(path.c_str(), O_RDONLY);
+
+      if (fd < 0)
+         return false;
+
+      struct stat st {};
+
+      if (fstat(fd, &st) == 0 && st.st_size > 0)
+      {
+         void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+         if (data != MAP_FAILED)
+         {
+            fileData = static_cast<const unsigned char *>(data);
+            fileSize = st.st_size;
+            mapped = true;
+         }
+      }
+
+      ::close(fd);
+#else
+      std::ifstream input(path, std::ios::in | std::ios::binary | std::ios::ate);
+
+      if (input.is_open())
+      {
+         fileBuffer.resize(input.tellg());
+
+         input.seekg(0);
+
+         if (input.read(reinterpret_cast<char *>(fileBuffer.data()), fileBuffer.size()))
+         {
+            fileData = fileBuffer.data();
+            fileSize = fileBuffer.size();
+         }
+      }
+#endif
+
+      return fileData;
+   }
+
+   bool fail(const char *message)
+   {
+      log.warn("{} in file [{}]", {message, path});
+
+      close();
+
+      return false;
+   }
+
+   NfcFrame frame(long index) const
+   {
+      if (index < 0 || index >= frameCount)
+         return NfcFrame::Nil;
+
+      auto it = std::upper_bound(segments.begin(), segments.end(), index, [](long value, const Segment &segment) {
+         return value < segment.firstFrame;
+      });
+
+      const Segment &segment = *(it - 1);
+
+      unsigned int i = index - segment.firstFrame;
+      unsigned int size = segment.payload[i + 1] - segment.payload[i];
+
+      NfcFrame frame(std::max(size, 256u));
+
+      frame.setTechType(segment.techType[i]);
+      frame.setFrameType(segment.frameType[i]);
+      frame.setFramePhase(segment.framePhase[i]);
+      frame.setFrameFlags(segment.frameFlags[i]);
+      frame.setFrameRate(segment.frameRate[i]);
+      frame.setTimeStart(segment.timeStart[i]);
+      frame.setTimeEnd(segment.timeEnd[i]);
+      frame.setDateTime(segment.dateTime[i]);
+      frame.setSampleStart(segment.sampleStart[i]);
+      frame.setSampleEnd(segment.sampleEnd[i]);
+
+      frame.put(segment.heap + segment.payload[i], size);
+
+      frame.flip();
+
+      return frame;
+   }
+
+   long find(double time) const
+   {
+      if (segments.empty())
+         return 0;
+
+      // last segment starting before requested time
+      auto it = std::upper_bound(segments.begin(), segments.end(), time, [](double value, const Segment &segment) {
+         return value < segment.timeFirst;
+      });
+
+      if (it != segments.begin())
+         it--;
+
+      for (; it != segments.end(); it++)
+      {
+         auto entry = std::lower_bound(it->timeStart, it->timeStart + it->count, time);
+
+         if (entry != it->timeStart + it->count)
+            return it->firstFrame + (entry - it->timeStart);
+      }
+
+      return frameCount;
+   }
+};
+
+FrameStore::FrameStore(const std::string &path) : impl(std::make_shared<Impl>(path))
+{
+}
+
+const std::string &FrameStore::path() const
+{
+   return impl->path;
+}
+
+bool FrameStore::open(Mode mode)
+{
+   return impl->open(mode);
+}
+
+void FrameStore::close()
+{
+   impl->close();
+}
+
+bool FrameStore::isOpen() const
+{
+   return impl->isOpen();
+}
+
+bool FrameStore::append(const NfcFrame &frame)
+{
+   return impl->append(frame);
+}
+
+bool FrameStore::flush()
+{
+   return impl->flush();
+}
+
+long FrameStore::count() const
+{
+   return impl->frameCount;
+}
+
+NfcFrame FrameStore::frame(long index) const
+{
+   return impl->frame(index);
+}
+
+long FrameStore::find(double time) const
+{
+   return impl->find(time);
+}
+
+bool FrameStore::isFrameFile(const std::string &path)
+{
+   char id[4] {};
+
+   std::ifstream input(path, std::ios::in | std::ios::binary);
+
+   return input.read(id, sizeof(id)) && std::memcmp(id, "NFCD", 4) == 0;
+}
+
+}
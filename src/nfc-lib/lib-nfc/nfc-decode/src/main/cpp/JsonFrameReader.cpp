@@ -0,0 +1,369 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <fstream>
+#include <cstring>
+
+#include <nlohmann/json.hpp>
+
+#include <rt/Logger.h>
+
+#include <nfc/JsonFrameReader.h>
+
+// input stream buffer size
+#define BUFFER_SIZE (256 * 1024)
+
+namespace nfc {
+
+using json = nlohmann::json;
+
+/*
+ * SAX event handler, builds one frame at a time from objects found in "frames" array
+ */
+struct FrameParser : nlohmann::json_sax<json>
+{
+   enum Field
+   {
+      None,
+      TechType,
+      FrameType,
+      FramePhase,
+      FrameFlags,
+      FrameRate,
+      TimeStart,
+      TimeEnd,
+      DateTime,
+      SampleStart,
+      SampleEnd,
+      FrameData
+   };
+
+   const JsonFrameReader::FrameHandler &handler;
+
+   // nesting level, 1 is root object
+   int depth = 0;
+
+   // "frames" array is open at depth 2
+   bool inFrames = false;
+
+   // current key inside frame object
+   Field field = None;
+
+   // pending key at root level
+   bool framesKey = false;
+
+   // stop requested by handler
+   bool stopped = false;
+
+   long count = 0;
+
+   NfcFrame frame;
+
+   explicit FrameParser(const JsonFrameReader::FrameHandler &handler) : handler(handler)
+   {
+   }
+
+   bool inFrame() const
+   {
+      return inFrames && depth == 3;
+   }
+
+   bool null() override
+   {
+      return true;
+   }
+
+   bool boolean(bool value) override
+   {
+      return true;
+   }
+
+   bool number_integer(number_integer_t value) override
+   {
+      return number((double) value, (unsigned long) value);
+   }
+
+   bool number_unsigned(number_unsigned_t value) override
+   {
+      return number((double) value, (unsigned long) value);
+   }
+
+   bool number_float(number_float_t value, const string_t &) override
+   {
+      return number(value, (unsigned long) value);
+   }
+
+   bool number(double value, unsigned long integer)
+   {
+      if (!inFrame())
+         return true;
+
+      switch (field)
+      {
+         case TechType:
+            frame.setTechType(integer);
+            break;
+         case FrameType:
+            frame.setFrameType(integer);
+            break;
+         case FramePhase:
+            frame.setFramePhase(integer);
+            break;
+         case FrameFlags:
+            frame.setFrameFlags(integer);
+            break;
+         case FrameRate:
+            frame.setFrameRate(integer);
+            break;
+         case TimeStart:
+            frame.setTimeStart(value);
+            break;
+         case TimeEnd:
+            frame.setTimeEnd(value);
+            break;
+         case DateTime:
+            frame.setDateTime(value);
+            break;
+         case SampleStart:
+            frame.setSampleStart(integer);
+            break;
+         case SampleEnd:
+            frame.setSampleEnd(integer);
+            break;
+         default:
+            break;
+      }
+
+      return true;
+   }
+
+   bool string(string_t &value) override
+   {
+      if (inFrame() && field == FrameData)
+      {
+         // decode hex bytes separated by ':'
+         const char *ptr = value.data();
+         const char *end = ptr + value.size();
+
+         while (ptr < end)
+         {
+            int byte = 0, digits = 0;
+
+            for (; ptr < end && *ptr != ':'; ptr++, digits++)
+            {
+               int nibble = hex(*ptr);
+
+               if (nibble < 0)
+                  return false;
+
+               byte = byte << 4 | nibble;
+            }
+
+            if (digits)
+               frame.put((unsigned char) byte);
+
+            if (ptr < end)
+               ptr++;
+         }
+      }
+
+      return true;
+   }
+
+   static inline int hex(char c)
+   {
+      if (c >= '0' && c <= '9')
+         return c - '0';
+
+      if (c >= 'A' && c <= 'F')
+         return c - 'A' + 10;
+
+      if (c >= 'a' && c <= 'f')
+         return c - 'a' + 10;
+
+      return -1;
+   }
+
+   bool binary(binary_t &) override
+   {
+      return true;
+   }
+
+   bool start_object(std::size_t) override
+   {
+      depth++;
+
+      // new frame, payload is never larger than frame buffer
+      if (inFrame())
+         frame = NfcFrame(256);
+
+      return true;
+   }
+
+   bool key(string_t &value) override
+   {
+      if (depth == 1)
+         framesKey = value == "frames";
+      else if (inFrame())
+         field = lookup(value);
+
+      return true;
+   }
+
+   bool end_object() override
+   {
+      if (inFrame())
+      {
+         frame.flip();
+
+         count++;
+
+         if (!handler(frame))
+         {
+            stopped = true;
+
+            return false;
+         }
+
+         frame = NfcFrame::Nil;
+         field = None;
+      }
+
+      depth--;
+
+      return true;
+   }
+
+   bool start_array(std::size_t) override
+   {
+      depth++;
+
+      if (depth == 2 && framesKey)
+         inFrames = true;
+
+      return true;
+   }
+
+   bool end_array() override
+   {
+      if (depth == 2)
+         inFrames = false;
+
+      depth--;
+
+      return true;
+   }
+
+   bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &) override
+   {
+      return false;
+   }
+
+   static Field lookup(const std::string &name)
+   {
+      static const std::pair<const char *, Field> fields[] = {
+            {"techType",    TechType},
+            {"frameType",   FrameType},
+            {"framePhase",  FramePhase},
+            {"frameFlags",  FrameFlags},
+            {"frameRate",   FrameRate},
+            {"timeStart",   TimeStart},
+            {"timeEnd",     TimeEnd},
+            {"dateTime",    DateTime},
+            {"sampleStart", SampleStart},
+            {"sampleEnd",   SampleEnd},
+            {"frameData",   FrameData}
+      };
+
+      for (const auto &entry: fields)
+      {
+         if (name == entry.first)
+            return entry.second;
+      }
+
+      return None;
+   }
+};
+
+struct JsonFrameReader::Impl
+{
+   rt::Logger log {"JsonFrameReader"};
+
+   std::string path;
+
+   long count = 0;
+
+   explicit Impl(std::string path) : path(std::move(path))
+   {
+   }
+
+   bool read(const FrameHandler &handler)
+   {
+      std::vector<char> buffer(BUFFER_SIZE);
+
+      std::ifstream input;
+
+      input.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+
+      input.open(path, std::ios::in | std::ios::binary);
+
+      count = 0;
+
+      if (!input.is_open())
+      {
+         log.warn("unable to open file [{}]", {path});
+         return false;
+      }
+
+      FrameParser parser(handler);
+
+      bool result = json::sax_parse(input, &parser);
+
+      count = parser.count;
+
+      if (!result && !parser.stopped)
+      {
+         log.warn("invalid frame file [{}], {} frames readed", {path, count});
+         return false;
+      }
+
+      return true;
+   }
+};
+
+JsonFrameReader::JsonFrameReader(const std::string &path) : impl(std::make_shared<Impl>(path))
+{
+}
+
+bool JsonFrameReader::read(const FrameHandler &handler)
+{
+   return impl->read(handler);
+}
+
+long JsonFrameReader::count() const
+{
+   return impl->count;
+}
+
+}
@@ -0,0 +1,202 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <fstream>
+#include <charconv>
+#include <type_traits>
+
+#include <rt/Logger.h>
+
+#include <nlohmann/json.hpp>
+
+#include <nfc/JsonFrameWriter.h>
+
+// pending output flushed to file when exceeds this size
+#define FLUSH_SIZE (64 * 1024)
+
+namespace nfc {
+
+struct JsonFrameWriter::Impl
+{
+   rt::Logger log {"JsonFrameWriter"};
+
+   std::string path;
+
+   std::string text;
+
+   std::ofstream output;
+
+   long count = 0;
+
+   explicit Impl(std::string path) : path(std::move(path))
+   {
+   }
+
+   ~Impl()
+   {
+      close();
+   }
+
+   bool open()
+   {
+      close();
+
+      output.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+
+      if (!output.is_open())
+      {
+         log.warn("unable to create file [{}]", {path});
+         return false;
+      }
+
+      count = 0;
+
+      text = "{\n   \"frames\": [";
+
+      return true;
+   }
+
+   void close()
+   {
+      if (!output.is_open())
+         return;
+
+      text += count ? "\n   ]\n}\n" : "]\n}\n";
+
+      flush();
+
+      output.close();
+   }
+
+   bool append(const NfcFrame &frame)
+   {
+      if (!output.is_open())
+         return false;
+
+      text += count++ ? ",\n      {\n" : "\n      {\n";
+
+      // members in same order as sorted JSON objects
+      text += "         \"frameData\": \"";
+      hex(frame);
+      text += "\",\n";
+
+      field("frameFlags", frame.frameFlags());
+      field("framePhase", frame.framePhase());
+      field("frameRate", frame.frameRate());
+      field("frameType", frame.frameType());
+      field("sampleEnd", frame.sampleEnd());
+      field("sampleStart", frame.sampleStart());
+      field("techType", frame.techType());
+      field("timeEnd", frame.timeEnd());
+      field("timeStart", frame.timeStart(), true);
+
+      text += "      }";
+
+      if (text.size() > FLUSH_SIZE)
+         return flush();
+
+      return true;
+   }
+
+   void hex(const NfcFrame &frame)
+   {
+      static const char digits[] = "0123456789ABCDEF";
+
+      auto data = frame.readable();
+
+      for (unsigned int i = 0; i < data.size(); i++)
+      {
+         if (i > 0)
+            text += ':';
+
+         text += digits[data[i] >> 4];
+         text += digits[data[i] & 0xf];
+      }
+   }
+
+   template<typename T>
+   void field(const char *name, T value, bool last = false)
+   {
+      text += "         \"";
+      text += name;
+      text += "\": ";
+
+      // floating point values use json serializer, shortest round trip form with ".0" for integral values and
+      // null for nan or infinite, std::to_chars for doubles is not available in older toolchains
+      if constexpr (std::is_floating_point_v<T>)
+      {
+         text += nlohmann::json(value).dump();
+      }
+      else
+      {
+         char buffer[32];
+
+         auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+
+         text.append(buffer, result.ptr);
+      }
+
+      text += last ? "\n" : ",\n";
+   }
+
+   bool flush()
+   {
+      output.write(text.data(), text.size());
+
+      text.clear();
+
+      return output.good();
+   }
+};
+
+JsonFrameWriter::JsonFrameWriter(const std::string &path) : impl(std::make_shared<Impl>(path))
+{
+}
+
+bool JsonFrameWriter::open()
+{
+   return impl->open();
+}
+
+void JsonFrameWriter::close()
+{
+   impl->close();
+}
+
+bool JsonFrameWriter::isOpen() const
+{
+   return impl->output.is_open();
+}
+
+bool JsonFrameWriter::append(const NfcFrame &frame)
+{
+   return impl->append(frame);
+}
+
+long JsonFrameWriter::count() const
+{
+   return impl->count;
+}
+
+}
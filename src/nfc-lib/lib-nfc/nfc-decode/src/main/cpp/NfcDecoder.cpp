@@ -24,6 +24,9 @@
 
 #include <rt/Logger.h>
 
+#include <sdr/SignalType.h>
+#include <sdr/SignalKernel.h>
+
 #include <nfc/Nfc.h>
 #include <nfc/NfcDecoder.h>
 
@@ -45,6 +48,9 @@ struct NfcDecoder::Impl
    static constexpr int ENABLED_NFCF = 1 << 2;
    static constexpr int ENABLED_NFCV = 1 << 3;
 
+   // I/Q samples converted to magnitude per block, small enough to stay in cache
+   static constexpr int FRONTEND_BLOCK = 4096;
+
    // debug disabled by default
    int debugEnabled = false;
 
@@ -66,6 +72,9 @@ struct NfcDecoder::Impl
    // global decoder status
    struct DecoderStatus decoder;
 
+   // magnitude block for I/Q sample buffers
+   sdr::SignalBuffer frontend;
+
    Impl();
 
    inline void cleanup();
@@ -74,6 +83,8 @@ struct NfcDecoder::Impl
 
    inline std::list<NfcFrame> nextFrames(sdr::SignalBuffer &samples);
 
+   inline std::list<NfcFrame> nextFramesIq(sdr::SignalBuffer &samples);
+
    inline void detectCarrier(std::list<NfcFrame> &frames);
 };
 
@@ -291,6 +302,10 @@ void NfcDecoder::Impl::cleanup()
  */
 std::list<NfcFrame> NfcDecoder::Impl::nextFrames(sdr::SignalBuffer &samples)
 {
+   // I/Q samples are demodulated here, without intermediate magnitude buffer
+   if (samples.isValid() && samples.type() == sdr::SignalType::SAMPLE_IQ)
+      return nextFramesIq(samples);
+
    // detected frames
    std::list<NfcFrame> frames;
 
@@ -383,6 +398,41 @@ std::list<NfcFrame> NfcDecoder::Impl::nextFrames(sdr::SignalBuffer &samples)
    return frames;
 }
 
+/**
+ * Extract next frames from I/Q signal buffer, computing magnitude block by block
+ */
+std::list<NfcFrame> NfcDecoder::Impl::nextFramesIq(sdr::SignalBuffer &samples)
+{
+   // detected frames
+   std::list<NfcFrame> frames;
+
+   while (!samples.isEmpty())
+   {
+      auto input = samples.readable();
+
+      unsigned int count = std::min<unsigned int>(input.size() / 2, FRONTEND_BLOCK);
+
+      if (count == 0)
+         break;
+
+      // reuse same block while sample rate does not change
+      if (!frontend.isValid() || frontend.sampleRate() != samples.sampleRate())
+         frontend = sdr::SignalBuffer(FRONTEND_BLOCK, 1, samples.sampleRate(), 0, 0, sdr::SignalType::SAMPLE_REAL);
+
+      frontend.clear();
+
+      sdr::SignalKernel::magnitude(input.data(), frontend.pull(count), count);
+
+      frontend.flip();
+
+      samples.advance(count * 2);
+
+      frames.splice(frames.end(), nextFrames(frontend));
+   }
+
+   return frames;
+}
+
 /**
  * Detect carrier from signal buffer
  */
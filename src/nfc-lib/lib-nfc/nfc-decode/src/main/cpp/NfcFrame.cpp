@@ -34,6 +34,7 @@ struct NfcFrame::Impl
    unsigned int frameFlags = 0;
    unsigned int framePhase = 0;
    unsigned int frameRate = 0;
+   unsigned int frameSource = 0;
    unsigned long sampleStart = 0;
    unsigned long sampleEnd = 0;
    double timeStart = 0;
@@ -41,6 +42,11 @@ struct NfcFrame::Impl
    double dateTime = 0;
 };
 
+struct NfcFrame::Trace
+{
+   long long time[TraceHop::ModelInsert + 1] {};
+};
+
 const NfcFrame NfcFrame::Nil;
 
 NfcFrame::NfcFrame() : rt::ByteBuffer(), impl(std::make_shared<Impl>())
@@ -68,6 +74,7 @@ NfcFrame::NfcFrame(int techType, int frameType, double timeStart, double timeEnd
 NfcFrame::NfcFrame(const NfcFrame &other) : rt::ByteBuffer(other)
 {
    impl = other.impl;
+   trace = other.trace;
 }
 
 NfcFrame &NfcFrame::operator=(const NfcFrame &other)
@@ -78,6 +85,7 @@ NfcFrame &NfcFrame::operator=(const NfcFrame &other)
    rt::ByteBuffer::operator=(other);
 
    impl = other.impl;
+   trace = other.trace;
 
    return *this;
 }
@@ -239,6 +247,16 @@ void NfcFrame::setFrameRate(unsigned int rate)
    impl->frameRate = rate;
 }
 
+unsigned int NfcFrame::frameSource() const
+{
+   return impl->frameSource;
+}
+
+void NfcFrame::setFrameSource(unsigned int source)
+{
+   impl->frameSource = source;
+}
+
 double NfcFrame::timeStart() const
 {
    return impl->timeStart;
@@ -289,4 +307,23 @@ void NfcFrame::setSampleEnd(unsigned long sampleEnd)
    impl->sampleEnd = sampleEnd;
 }
 
-}
\ No newline at end of file
+long long NfcFrame::traceTime(unsigned int hop) const
+{
+   return trace && hop <= TraceHop::ModelInsert ? trace->time[hop] : 0;
+}
+
+void NfcFrame::setTraceTime(unsigned int hop, long long time)
+{
+   if (hop > TraceHop::ModelInsert)
+      return;
+
+   // frames are delivered to several streams, a copy still referenced elsewhere must not see later hops
+   if (!trace)
+      trace = std::make_shared<Trace>();
+   else if (trace.use_count() > 1)
+      trace = std::make_shared<Trace>(*trace);
+
+   trace->time[hop] = time;
+}
+
+}
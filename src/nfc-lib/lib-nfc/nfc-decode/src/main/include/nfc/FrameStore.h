@@ -0,0 +1,87 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef NFC_FRAMESTORE_H
+#define NFC_FRAMESTORE_H
+
+#include <string>
+#include <memory>
+
+#include <nfc/NfcFrame.h>
+
+namespace nfc {
+
+/*
+ * Binary frame file, frames are stored in segments with one column per attribute and a payload heap,
+ * segments are indexed by time at end of file and can be appended while capture is running
+ */
+class FrameStore
+{
+      struct Impl;
+
+   public:
+
+      enum Mode
+      {
+         Read = 1,
+         Write = 2
+      };
+
+   public:
+
+      explicit FrameStore(const std::string &path);
+
+      const std::string &path() const;
+
+      bool open(Mode mode);
+
+      void close();
+
+      bool isOpen() const;
+
+      // append frame to current segment, full segments are written immediately
+      bool append(const NfcFrame &frame);
+
+      // write current partial segment so file is readable while still open
+      bool flush();
+
+      long count() const;
+
+      // read frame by position in file
+      NfcFrame frame(long index) const;
+
+      // position of first frame starting at or after given time, count() if none
+      long find(double time) const;
+
+      // check file signature
+      static bool isFrameFile(const std::string &path);
+
+   private:
+
+      std::shared_ptr<Impl> impl;
+};
+
+}
+
+#endif
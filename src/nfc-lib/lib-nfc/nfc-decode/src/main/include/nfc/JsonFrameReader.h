@@ -0,0 +1,65 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef NFC_JSONFRAMEREADER_H
+#define NFC_JSONFRAMEREADER_H
+
+#include <string>
+#include <memory>
+#include <functional>
+
+#include <nfc/NfcFrame.h>
+
+namespace nfc {
+
+/*
+ * Streaming reader for {"frames": [...]} trace files, frames are delivered while the document is parsed
+ */
+class JsonFrameReader
+{
+      struct Impl;
+
+   public:
+
+      // handler returns false to stop reading
+      typedef std::function<bool(const NfcFrame &frame)> FrameHandler;
+
+   public:
+
+      explicit JsonFrameReader(const std::string &path);
+
+      // parse whole file, returns false if file can't be opened or is not valid
+      bool read(const FrameHandler &handler);
+
+      // number of frames delivered by last read
+      long count() const;
+
+   private:
+
+      std::shared_ptr<Impl> impl;
+};
+
+}
+
+#endif
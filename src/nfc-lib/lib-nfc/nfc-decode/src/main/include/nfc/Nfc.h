@@ -69,6 +69,16 @@ enum FramePhase
    ApplicationFrame = 2
 };
 
+enum TraceHop
+{
+   DeviceCapture = 0,
+   ReceiverPublish = 1,
+   DecoderDequeue = 2,
+   FrameEmit = 3,
+   ViewPost = 4,
+   ModelInsert = 5
+};
+
 // Frequency of operating field (carrier frequency) in Hz
 constexpr float NFC_FC = 13.56E6;
 
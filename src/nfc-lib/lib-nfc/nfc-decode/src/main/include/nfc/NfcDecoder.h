@@ -48,6 +48,7 @@ class NfcDecoder
 
       void cleanup();
 
+      // decode real (magnitude) or I/Q sample buffers
       std::list<NfcFrame> nextFrames(sdr::SignalBuffer samples);
 
       bool isDebugEnabled() const;
@@ -34,6 +34,7 @@ namespace nfc {
 class NfcFrame : public rt::ByteBuffer
 {
       struct Impl;
+      struct Trace;
 
    public:
 
@@ -111,6 +112,11 @@ class NfcFrame : public rt::ByteBuffer
 
       void setFrameRate(unsigned int frameRate);
 
+      // index of the receiver that captured this frame, 0 for single receiver
+      unsigned int frameSource() const;
+
+      void setFrameSource(unsigned int frameSource);
+
       double timeStart() const;
 
       void setTimeStart(double timeStart);
@@ -131,9 +137,17 @@ class NfcFrame : public rt::ByteBuffer
 
       void setSampleEnd(unsigned long sampleEnd);
 
+      // monotonic time in nanoseconds when frame passed each TraceHop, 0 if not traced
+      long long traceTime(unsigned int hop) const;
+
+      // trace times are copied on write, unlike other frame fields they are not shared with previous copies
+      void setTraceTime(unsigned int hop, long long time);
+
    private:
 
       std::shared_ptr<Impl> impl;
+
+      std::shared_ptr<Trace> trace;
 };
 
 }
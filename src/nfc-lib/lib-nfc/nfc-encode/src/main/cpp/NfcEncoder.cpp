@@ -0,0 +1,874 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cmath>
+#include <deque>
+#include <random>
+#include <vector>
+#include <limits>
+
+#include <rt/Logger.h>
+
+#include <sdr/SignalType.h>
+
+#include <nfc/Nfc.h>
+#include <nfc/NfcEncoder.h>
+
+// gaussian noise table, must be power of 2^n
+#define NOISE_TABLE_SIZE (1 << 20)
+
+// NFC-A pause width at 106 kbps, in 1/FC units
+#define NFCA_PAUSE_WIDTH 44
+
+// NFC-A BPSK preamble, 32 subcarrier clocks
+#define NFCA_BPSK_PREAMBLE 512
+
+// NFC-A frame delay time, poll to listen
+#define NFCA_FDT_DEF 1172
+
+// NFC-B TR1 unmodulated subcarrier before SOF
+#define NFCB_TR1_DEF 1600
+
+// NFC-B SOF and EOF lengths, in ETU
+#define NFCB_SOF_LOW 10.5f
+#define NFCB_SOF_HIGH 2.5f
+#define NFCB_EOF_LOW 10.5f
+
+// NFC-F number of preamble symbols
+#define NFCF_PREAMBLE_BITS 48
+
+// NFC-V poll pulse unit (9.44us)
+#define NFCV_PULSE_UNIT 128
+
+// NFC-V listen response delay (t1 nominal)
+#define NFCV_FDT_DEF 4352
+
+// NFC-V listen subcarriers, fc/32 and fc/28
+#define NFCV_SUBCARRIER_1 32
+#define NFCV_SUBCARRIER_2 28
+
+namespace nfc {
+
+/*
+ * modulated interval of a frame, time in 1/FC units from frame start
+ */
+struct Segment
+{
+   float start;
+   float end;
+
+   // subcarrier period for load modulation, 0 for plain carrier modulation
+   float period;
+
+   // subcarrier phase, 0 or 1 (BPSK)
+   int phase;
+};
+
+/*
+ * frame waiting to be synthesized
+ */
+struct PendingFrame
+{
+   long sampleStart;
+   long sampleEnd;
+   float depth;
+   std::vector<Segment> segments;
+};
+
+struct NfcEncoder::Impl
+{
+   rt::Logger log {"NfcEncoder"};
+
+   // signal parameters
+   long sampleRate = 10000000;
+   int sampleType = sdr::SignalType::SAMPLE_REAL;
+   float carrierLevel = 0.5f;
+   float signalNoiseRatio = std::numeric_limits<float>::infinity();
+   float carrierDrift = 0;
+
+   // modulation depth for each tech, [tech][0 = poll, 1 = listen]
+   float modulationDepth[5][2] = {
+         {0.00f, 0.00f},
+         {0.98f, 0.10f}, // NFC-A, 100% ASK
+         {0.50f, 0.20f}, // NFC-B, 10% ASK (with margin for decoder threshold)
+         {0.30f, 0.10f}, // NFC-F
+         {0.98f, 0.10f}  // NFC-V, 100% ASK
+   };
+
+   // stream status
+   long streamOffset = 0;
+   double carrierPhase = 0;
+
+   // end of last queued frame and time until next frame can start
+   long queueEnd = 0;
+   long queueBusy = 0;
+   int queueTech = 0;
+   int queueType = 0;
+
+   // pending frames and carrier switch events
+   std::deque<PendingFrame> pendingFrames;
+   std::deque<std::pair<long, bool>> carrierEvents;
+   bool carrierOn = true;
+
+   // envelope for rendered frames, starting at current stream offset
+   std::vector<float> envelope;
+
+   // noise generator
+   std::vector<float> noiseTable;
+   std::mt19937 random {0x4e4643};
+
+   void initialize()
+   {
+      streamOffset = 0;
+      carrierPhase = 0;
+      queueEnd = 0;
+      queueBusy = 0;
+      queueTech = 0;
+      queueType = 0;
+      carrierOn = true;
+
+      pendingFrames.clear();
+      carrierEvents.clear();
+      envelope.clear();
+   }
+
+   NfcFrame encode(const NfcFrame &frame)
+   {
+      NfcFrame result = frame;
+      PendingFrame pending {0, 0, 0};
+
+      int techType = frame.techType();
+      int frameType = frame.frameType();
+
+      float length = 0; // frame length reported in timing, in 1/FC
+      float busy = 0; // time until end of modulation, in 1/FC
+
+      if (frameType == FrameType::PollFrame || frameType == FrameType::ListenFrame)
+      {
+         bool listen = frameType == FrameType::ListenFrame;
+
+         switch (techType)
+         {
+            case TechType::NfcA:
+               busy = listen ? encodeListenA(frame, pending.segments, length) : encodePollA(frame, pending.segments, length);
+               break;
+
+            case TechType::NfcB:
+               busy = listen ? encodeListenB(frame, pending.segments, length) : encodePollB(frame, pending.segments, length);
+               break;
+
+            case TechType::NfcF:
+               busy = encodeFrameF(frame, pending.segments, length);
+               break;
+
+            case TechType::NfcV:
+               busy = listen ? encodeListenV(frame, pending.segments, length) : encodePollV(frame, pending.segments, length);
+               break;
+
+            default:
+               log.warn("unsupported tech type {}", {techType});
+               return NfcFrame::Nil;
+         }
+
+         pending.depth = modulationDepth[techType][listen ? 1 : 0];
+      }
+      else if (frameType != FrameType::CarrierOn && frameType != FrameType::CarrierOff)
+      {
+         log.warn("unsupported frame type {}", {frameType});
+         return NfcFrame::Nil;
+      }
+
+      double unit = double(sampleRate) / NFC_FC;
+
+      // use frame time if it does not overlap previous frame, otherwise place after it
+      long start = std::lround(frame.timeStart() * sampleRate);
+
+      if (frame.timeStart() <= 0 || start < queueBusy || start < streamOffset)
+         start = std::max(queueBusy, streamOffset) + std::lround(guardTime(techType, frameType) * unit);
+
+      long end = start + std::lround(length * unit);
+
+      pending.sampleStart = start;
+      pending.sampleEnd = start + std::lround(busy * unit) + 1;
+
+      if (frameType == FrameType::CarrierOn || frameType == FrameType::CarrierOff)
+         carrierEvents.emplace_back(start, frameType == FrameType::CarrierOn);
+      else
+         pendingFrames.push_back(pending);
+
+      queueEnd = end;
+      queueBusy = std::max(end, pending.sampleEnd);
+      queueTech = techType;
+      queueType = frameType;
+
+      result.setSampleStart(start);
+      result.setSampleEnd(end);
+      result.setTimeStart(double(start) / sampleRate);
+      result.setTimeEnd(double(end) / sampleRate);
+
+      return result;
+   }
+
+   // delay before frame placed without explicit time, in 1/FC units
+   float guardTime(int techType, int frameType) const
+   {
+      if (frameType == FrameType::ListenFrame && queueType == FrameType::PollFrame && queueTech == techType)
+      {
+         switch (techType)
+         {
+            case TechType::NfcA:
+               return NFCA_FDT_DEF;
+            case TechType::NfcB:
+               return NFCB_TR0_MIN + 256;
+            case TechType::NfcF:
+               return NFCF_FGT_DEF + 256;
+            case TechType::NfcV:
+               return NFCV_FDT_DEF;
+         }
+      }
+
+      if (frameType == FrameType::CarrierOn || frameType == FrameType::CarrierOff)
+         return 0;
+
+      // unanswered request, decoder keeps waiting for response until FWT expires
+      if (frameType == FrameType::PollFrame && queueType == FrameType::PollFrame)
+      {
+         switch (queueTech)
+         {
+            case TechType::NfcB:
+               return NFCB_FWT_DEF;
+            case TechType::NfcF:
+               return NFCF_FWT_DEF;
+            case TechType::NfcV:
+               return NFCV_FWT_DEF;
+         }
+      }
+
+      return NFCA_RGT_DEF;
+   }
+
+   static int rateType(const NfcFrame &frame, int defaultRate)
+   {
+      unsigned int rate = frame.frameRate();
+
+      if (rate == 0)
+         return defaultRate;
+
+      return rate > 300000 ? r424k : rate > 150000 ? r212k : r106k;
+   }
+
+   // frame bits with parity for NFC-A, optionally inverting parity of last byte
+   static std::vector<int> bitsParityA(const NfcFrame &frame, int shortBits, bool lastEven)
+   {
+      std::vector<int> bits;
+
+      int size = frame.limit();
+
+      if (frame.isShortFrame() && size == 1)
+      {
+         for (int i = 0; i < shortBits; i++)
+            bits.push_back((frame[0] >> i) & 1);
+
+         return bits;
+      }
+
+      for (int n = 0; n < size; n++)
+      {
+         int parity = 1;
+
+         for (int i = 0; i < 8; i++)
+         {
+            int bit = (frame[n] >> i) & 1;
+            bits.push_back(bit);
+            parity ^= bit;
+         }
+
+         bits.push_back(lastEven && n == size - 1 ? !parity : parity);
+      }
+
+      return bits;
+   }
+
+   /*
+    * NFC-A poll, modified Miller, SOF Z, EOF logic 0 followed by Y
+    */
+   static float encodePollA(const NfcFrame &frame, std::vector<Segment> &segments, float &length)
+   {
+      int rate = rateType(frame, r106k);
+      float symbol = float(128 >> rate);
+      float pause = float(NFCA_PAUSE_WIDTH >> rate);
+
+      std::vector<int> bits = bitsParityA(frame, 7, false);
+
+      // SOF, pattern Z
+      segments.push_back({0, pause, 0, 0});
+
+      int last = 0;
+
+      for (int i = 0; i <= (int) bits.size(); i++)
+      {
+         // last symbol is EOF logic 0
+         int bit = i < (int) bits.size() ? bits[i] : 0;
+         float time = float(i + 1) * symbol;
+
+         if (bit)
+            segments.push_back({time + symbol / 2, time + symbol / 2 + pause, 0, 0}); // pattern X
+         else if (!last)
+            segments.push_back({time, time + pause, 0, 0}); // pattern Z
+
+         last = bit;
+      }
+
+      length = float(bits.size() + 1) * symbol;
+
+      return float(bits.size() + 3) * symbol;
+   }
+
+   /*
+    * NFC-A listen, Manchester OOK subcarrier for 106 kbps, BPSK subcarrier for higher rates
+    */
+   static float encodeListenA(const NfcFrame &frame, std::vector<Segment> &segments, float &length)
+   {
+      int rate = rateType(frame, r106k);
+      float symbol = float(128 >> rate);
+      float subcarrier = NFC_FC / NFC_FS;
+
+      if (rate == r106k)
+      {
+         std::vector<int> bits = bitsParityA(frame, 4, false);
+
+         // SOF, pattern D
+         segments.push_back({0, symbol / 2, subcarrier, 0});
+
+         for (int i = 0; i < (int) bits.size(); i++)
+         {
+            float time = float(i + 1) * symbol;
+
+            if (bits[i])
+               segments.push_back({time, time + symbol / 2, subcarrier, 0}); // pattern D
+            else
+               segments.push_back({time + symbol / 2, time + symbol, subcarrier, 0}); // pattern E
+         }
+
+         length = float(bits.size() + 1) * symbol;
+
+         return length + symbol;
+      }
+
+      // last byte has even parity to mark end of frame
+      std::vector<int> bits = bitsParityA(frame, 8, true);
+
+      // preamble at reference phase followed by start bit
+      segments.push_back({0, NFCA_BPSK_PREAMBLE, subcarrier, 0});
+      segments.push_back({NFCA_BPSK_PREAMBLE, NFCA_BPSK_PREAMBLE + symbol, subcarrier, 1});
+
+      for (int i = 0; i < (int) bits.size(); i++)
+      {
+         float time = NFCA_BPSK_PREAMBLE + float(i + 1) * symbol;
+
+         segments.push_back({time, time + symbol, subcarrier, bits[i] ? 0 : 1});
+      }
+
+      length = NFCA_BPSK_PREAMBLE + float(bits.size() + 1) * symbol;
+
+      return length;
+   }
+
+   /*
+    * NFC-B poll, NRZ-L ASK, low level for logic 0
+    */
+   static float encodePollB(const NfcFrame &frame, std::vector<Segment> &segments, float &length)
+   {
+      int rate = rateType(frame, r106k);
+      float etu = float(128 >> rate);
+      float time = (NFCB_SOF_LOW + NFCB_SOF_HIGH) * etu;
+
+      // SOF
+      segments.push_back({0, NFCB_SOF_LOW * etu, 0, 0});
+
+      for (int n = 0; n < (int) frame.limit(); n++)
+      {
+         // start bit, 8 data bits and stop bit
+         int character = (frame[n] << 1) | 0x200;
+
+         for (int i = 0; i < 10; i++, time += etu)
+         {
+            if (!((character >> i) & 1))
+               segments.push_back({time, time + etu, 0, 0});
+         }
+      }
+
+      // EOF
+      segments.push_back({time, time + NFCB_EOF_LOW * etu, 0, 0});
+
+      length = time + NFCB_EOF_LOW * etu;
+
+      return length;
+   }
+
+   /*
+    * NFC-B listen, NRZ-L BPSK subcarrier, phase inversion for logic 0
+    */
+   static float encodeListenB(const NfcFrame &frame, std::vector<Segment> &segments, float &length)
+   {
+      int rate = rateType(frame, r106k);
+      float etu = float(128 >> rate);
+      float subcarrier = NFC_FC / NFC_FS;
+      float time = NFCB_TR1_DEF;
+
+      // TR1 reference phase and SOF
+      segments.push_back({0, time, subcarrier, 0});
+      segments.push_back({time, time + NFCB_SOF_LOW * etu, subcarrier, 1});
+      segments.push_back({time + NFCB_SOF_LOW * etu, time + (NFCB_SOF_LOW + NFCB_SOF_HIGH) * etu, subcarrier, 0});
+
+      time += (NFCB_SOF_LOW + NFCB_SOF_HIGH) * etu;
+
+      for (int n = 0; n < (int) frame.limit(); n++)
+      {
+         // start bit, 8 data bits and stop bit
+         int character = (frame[n] << 1) | 0x200;
+
+         for (int i = 0; i < 10; i++, time += etu)
+            segments.push_back({time, time + etu, subcarrier, (character >> i) & 1 ? 0 : 1});
+      }
+
+      // EOF
+      segments.push_back({time, time + NFCB_EOF_LOW * etu, subcarrier, 1});
+
+      length = time + NFCB_EOF_LOW * etu;
+
+      return length;
+   }
+
+   /*
+    * NFC-F poll and listen, Manchester coding with preamble and sync bytes, data MSB first
+    */
+   static float encodeFrameF(const NfcFrame &frame, std::vector<Segment> &segments, float &length)
+   {
+      int rate = rateType(frame, r212k);
+      float symbol = float(128 >> rate);
+
+      std::vector<int> bits(NFCF_PREAMBLE_BITS, 0);
+
+      for (int value: {0xB2, 0x4D})
+      {
+         for (int i = 7; i >= 0; i--)
+            bits.push_back((value >> i) & 1);
+      }
+
+      for (int n = 0; n < (int) frame.limit(); n++)
+      {
+         for (int i = 7; i >= 0; i--)
+            bits.push_back((frame[n] >> i) & 1);
+      }
+
+      for (int i = 0; i < (int) bits.size(); i++)
+      {
+         float time = float(i) * symbol;
+
+         if (bits[i])
+            segments.push_back({time, time + symbol / 2, 0, 0});
+         else
+            segments.push_back({time + symbol / 2, time + symbol, 0, 0});
+      }
+
+      length = float(bits.size()) * symbol;
+
+      return length;
+   }
+
+   /*
+    * NFC-V poll, pulse position 1 of 4 or 1 of 256
+    */
+   static float encodePollV(const NfcFrame &frame, std::vector<Segment> &segments, float &length)
+   {
+      bool code256 = frame.frameRate() > 0 && frame.frameRate() <= NfcVRate1of256;
+
+      float unit = NFCV_PULSE_UNIT;
+      float time = 8 * unit;
+
+      // SOF, second pulse selects code
+      segments.push_back({0, unit, 0, 0});
+      segments.push_back({(code256 ? 7 : 5) * unit, (code256 ? 8 : 6) * unit, 0, 0});
+
+      for (int n = 0; n < (int) frame.limit(); n++)
+      {
+         if (code256)
+         {
+            int value = frame[n];
+
+            segments.push_back({time + float(2 * value + 1) * unit, time + float(2 * value + 2) * unit, 0, 0});
+
+            time += 512 * unit;
+         }
+         else
+         {
+            for (int i = 0; i < 8; i += 2)
+            {
+               int value = (frame[n] >> i) & 3;
+
+               segments.push_back({time + float(2 * value + 1) * unit, time + float(2 * value + 2) * unit, 0, 0});
+
+               time += 8 * unit;
+            }
+         }
+      }
+
+      // EOF
+      segments.push_back({time + 2 * unit, time + 3 * unit, 0, 0});
+
+      length = time + 4 * unit;
+
+      return length;
+   }
+
+   /*
+    * NFC-V listen, Manchester with single subcarrier (fc/32 bursts) or dual subcarrier (fc/32 and fc/28)
+    */
+   static float encodeListenV(const NfcFrame &frame, std::vector<Segment> &segments, float &length)
+   {
+      bool dual = frame.frameRate() == NfcVRateDual;
+
+      // half symbol periods, 8 pulses of fc/32 and 9 pulses of fc/28
+      float half1 = 8 * NFCV_SUBCARRIER_1;
+      float half2 = dual ? 9 * NFCV_SUBCARRIER_2 : half1;
+      float time = 0;
+
+      auto burst = [&](float width, float period) {
+         if (period > 0)
+            segments.push_back({time, time + width, period, 0});
+         time += width;
+      };
+
+      float second = dual ? NFCV_SUBCARRIER_2 : 0;
+
+      // SOF, leading unmodulated part is not included in frame time, for dual subcarrier 27 pulses of fc/28
+      if (dual)
+         burst(3 * half2, second);
+
+      // SOF, 24 pulses of fc/32 and logic 1
+      burst(3 * half1, NFCV_SUBCARRIER_1);
+      burst(half2, second);
+      burst(half1, NFCV_SUBCARRIER_1);
+
+      for (int n = 0; n < (int) frame.limit(); n++)
+      {
+         for (int i = 0; i < 8; i++)
+         {
+            if ((frame[n] >> i) & 1)
+            {
+               burst(half2, second);
+               burst(half1, NFCV_SUBCARRIER_1);
+            }
+            else
+            {
+               burst(half1, NFCV_SUBCARRIER_1);
+               burst(half2, second);
+            }
+         }
+      }
+
+      // frame ends within EOF, as reported by decoder
+      length = time + 2 * half1 + 2 * half2;
+
+      // EOF, logic 0, 24 pulses of fc/32 and unmodulated (or fc/28) part
+      burst(half1, NFCV_SUBCARRIER_1);
+      burst(half2, second);
+      burst(3 * half1, NFCV_SUBCARRIER_1);
+      burst(3 * half2, second);
+
+      return time;
+   }
+
+   /*
+    * render frame modulation into envelope buffer
+    */
+   void render(const PendingFrame &frame)
+   {
+      double unit = double(sampleRate) / NFC_FC;
+
+      long last = frame.sampleEnd - streamOffset;
+
+      if (last > (long) envelope.size())
+         envelope.resize(last, 1.0f);
+
+      float level = 1.0f - frame.depth;
+
+      for (const Segment &segment: frame.segments)
+      {
+         long first = std::max(frame.sampleStart + std::lround(segment.start * unit), streamOffset);
+         long end = std::min(frame.sampleStart + std::lround(segment.end * unit), frame.sampleEnd);
+
+         if (segment.period == 0)
+         {
+            for (long n = first; n < end; n++)
+               envelope[n - streamOffset] *= level;
+         }
+         else
+         {
+            double halfPeriod = segment.period / 2.0;
+
+            for (long n = first; n < end; n++)
+            {
+               // subcarrier clock runs from frame start
+               long half = long(double(n - frame.sampleStart) / unit / halfPeriod);
+
+               if (((half + segment.phase) & 1) == 0)
+                  envelope[n - streamOffset] *= level;
+            }
+         }
+      }
+   }
+
+   sdr::SignalBuffer nextSamples(unsigned int count)
+   {
+      long blockEnd = streamOffset + count;
+
+      // render all frames starting in this block
+      while (!pendingFrames.empty() && pendingFrames.front().sampleStart < blockEnd)
+      {
+         render(pendingFrames.front());
+         pendingFrames.pop_front();
+      }
+
+      if (envelope.size() < count)
+         envelope.resize(count, 1.0f);
+
+      bool iq = sampleType == sdr::SignalType::SAMPLE_IQ;
+
+      sdr::SignalBuffer buffer(count * (iq ? 2 : 1), iq ? 2 : 1, sampleRate, streamOffset, 0, sampleType);
+
+      float *data = buffer.pull(count * (iq ? 2 : 1));
+
+      // noise for each I/Q component
+      float sigma = std::isfinite(signalNoiseRatio) ? carrierLevel * std::pow(10.0f, -signalNoiseRatio / 20) / std::sqrt(2.0f) : 0;
+
+      if (sigma > 0 && noiseTable.empty())
+      {
+         std::normal_distribution<float> gauss(0, 1);
+
+         noiseTable.resize(NOISE_TABLE_SIZE);
+
+         for (auto &value: noiseTable)
+            value = gauss(random);
+      }
+
+      unsigned int noiseIndex = sigma > 0 ? random() : 0;
+
+      double phaseStep = 2 * M_PI * carrierDrift / sampleRate;
+
+      for (unsigned int i = 0; i < count; i++)
+      {
+         long sample = streamOffset + i;
+
+         // apply carrier on / off events
+         while (!carrierEvents.empty() && carrierEvents.front().first <= sample)
+         {
+            carrierOn = carrierEvents.front().second;
+            carrierEvents.pop_front();
+         }
+
+         float amplitude = carrierOn ? carrierLevel * envelope[i] : 0;
+         float vi = amplitude;
+         float vq = 0;
+
+         if (phaseStep != 0)
+         {
+            vi = amplitude * float(std::cos(carrierPhase));
+            vq = amplitude * float(std::sin(carrierPhase));
+
+            carrierPhase += phaseStep;
+         }
+
+         if (sigma > 0)
+         {
+            vi += sigma * noiseTable[noiseIndex++ & (NOISE_TABLE_SIZE - 1)];
+            vq += sigma * noiseTable[noiseIndex++ & (NOISE_TABLE_SIZE - 1)];
+         }
+
+         if (iq)
+         {
+            data[i * 2 + 0] = vi;
+            data[i * 2 + 1] = vq;
+         }
+         else
+         {
+            data[i] = vq == 0 ? std::fabs(vi) : std::sqrt(vi * vi + vq * vq);
+         }
+      }
+
+      carrierPhase = std::fmod(carrierPhase, 2 * M_PI);
+
+      envelope.erase(envelope.begin(), envelope.begin() + count);
+
+      streamOffset = blockEnd;
+
+      buffer.flip();
+
+      return buffer;
+   }
+
+   long write(sdr::SignalDevice &device, double tail)
+   {
+      long total = 0;
+      long end = std::max(queueBusy, streamOffset) + std::lround(tail * sampleRate);
+
+      while (streamOffset < end)
+      {
+         unsigned int count = (unsigned int) std::min(end - streamOffset, 65536L);
+
+         sdr::SignalBuffer buffer = nextSamples(count);
+
+         if (device.write(buffer) < 0)
+         {
+            log.warn("failed to write samples at offset {}", {streamOffset});
+            break;
+         }
+
+         total += count;
+      }
+
+      return total;
+   }
+};
+
+NfcEncoder::NfcEncoder() : impl(std::make_shared<Impl>())
+{
+}
+
+void NfcEncoder::initialize()
+{
+   impl->initialize();
+}
+
+NfcFrame NfcEncoder::encode(const NfcFrame &frame)
+{
+   return impl->encode(frame);
+}
+
+std::list<NfcFrame> NfcEncoder::encode(const std::list<NfcFrame> &frames)
+{
+   std::list<NfcFrame> result;
+
+   for (const auto &frame: frames)
+   {
+      if (NfcFrame encoded = impl->encode(frame))
+         result.push_back(encoded);
+   }
+
+   return result;
+}
+
+sdr::SignalBuffer NfcEncoder::nextSamples(unsigned int count)
+{
+   return impl->nextSamples(count);
+}
+
+long NfcEncoder::write(sdr::SignalDevice &device, double tail)
+{
+   return impl->write(device, tail);
+}
+
+int NfcEncoder::pendingFrames() const
+{
+   return (int) impl->pendingFrames.size();
+}
+
+double NfcEncoder::queueTime() const
+{
+   return double(impl->queueEnd) / double(impl->sampleRate);
+}
+
+long NfcEncoder::sampleOffset() const
+{
+   return impl->streamOffset;
+}
+
+long NfcEncoder::sampleRate() const
+{
+   return impl->sampleRate;
+}
+
+void NfcEncoder::setSampleRate(long sampleRate)
+{
+   impl->sampleRate = sampleRate;
+}
+
+int NfcEncoder::sampleType() const
+{
+   return impl->sampleType;
+}
+
+void NfcEncoder::setSampleType(int sampleType)
+{
+   impl->sampleType = sampleType;
+}
+
+float NfcEncoder::carrierLevel() const
+{
+   return impl->carrierLevel;
+}
+
+void NfcEncoder::setCarrierLevel(float value)
+{
+   impl->carrierLevel = value;
+}
+
+float NfcEncoder::signalNoiseRatio() const
+{
+   return impl->signalNoiseRatio;
+}
+
+void NfcEncoder::setSignalNoiseRatio(float value)
+{
+   impl->signalNoiseRatio = value;
+}
+
+float NfcEncoder::carrierDrift() const
+{
+   return impl->carrierDrift;
+}
+
+void NfcEncoder::setCarrierDrift(float value)
+{
+   impl->carrierDrift = value;
+}
+
+float NfcEncoder::modulationDepth(int techType, int frameType) const
+{
+   if (techType < TechType::NfcA || techType > TechType::NfcV)
+      return 0;
+
+   return impl->modulationDepth[techType][frameType == FrameType::ListenFrame ? 1 : 0];
+}
+
+void NfcEncoder::setModulationDepth(int techType, int frameType, float value)
+{
+   if (techType < TechType::NfcA || techType > TechType::NfcV)
+      return;
+
+   impl->modulationDepth[techType][frameType == FrameType::ListenFrame ? 1 : 0] = value;
+}
+
+}
@@ -0,0 +1,124 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef NFC_NFCENCODER_H
+#define NFC_NFCENCODER_H
+
+#include <list>
+#include <memory>
+
+#include <sdr/SignalBuffer.h>
+#include <sdr/SignalDevice.h>
+
+#include <nfc/NfcFrame.h>
+
+namespace nfc {
+
+/*
+ * Synthesizes the baseband signal for a sequence of NFC frames, the inverse of NfcDecoder.
+ *
+ * Supported modulations:
+ *    NFC-A poll:   modified Miller ASK (106, 212 and 424 kbps)
+ *    NFC-A listen: Manchester OOK subcarrier (106 kbps), BPSK subcarrier (212 and 424 kbps)
+ *    NFC-B poll:   NRZ-L ASK
+ *    NFC-B listen: NRZ-L BPSK subcarrier
+ *    NFC-F:        Manchester ASK (212 and 424 kbps)
+ *    NFC-V poll:   PPM 1 of 4 or 1 of 256 (selected by frame rate)
+ *    NFC-V listen: Manchester single or dual subcarrier (selected by frame rate)
+ *
+ * Frames are placed at their timeStart, frames without time (or overlapping the previous one) are placed
+ * after the previous frame using the protocol guard times. Frame data must contain the CRC bytes, as
+ * produced by the decoder. CarrierOn / CarrierOff frames switch the carrier.
+ */
+class NfcEncoder
+{
+      struct Impl;
+
+   public:
+
+      // NFC-V frame rates for 1 of 256 poll coding and dual subcarrier listen
+      static constexpr int NfcVRate1of256 = 1655;
+      static constexpr int NfcVRateDual = 26693;
+
+   public:
+
+      NfcEncoder();
+
+      void initialize();
+
+      // queue frame for synthesis and return it with the assigned timing
+      NfcFrame encode(const NfcFrame &frame);
+
+      std::list<NfcFrame> encode(const std::list<NfcFrame> &frames);
+
+      // next block of synthesized signal, unmodulated carrier when there are no pending frames
+      sdr::SignalBuffer nextSamples(unsigned int count);
+
+      // synthesize all pending frames, plus given tail time, into output device
+      long write(sdr::SignalDevice &device, double tail = 1E-3);
+
+      // number of frames queued and not synthesized yet
+      int pendingFrames() const;
+
+      // time of the end of the last queued frame, in seconds
+      double queueTime() const;
+
+      long sampleOffset() const;
+
+      long sampleRate() const;
+
+      void setSampleRate(long sampleRate);
+
+      // SAMPLE_REAL (magnitude) or SAMPLE_IQ
+      int sampleType() const;
+
+      void setSampleType(int sampleType);
+
+      float carrierLevel() const;
+
+      void setCarrierLevel(float value);
+
+      // signal to noise ratio in dB relative to carrier power, infinite to disable noise
+      float signalNoiseRatio() const;
+
+      void setSignalNoiseRatio(float value);
+
+      // carrier frequency offset in Hz, rotates I/Q phase
+      float carrierDrift() const;
+
+      void setCarrierDrift(float value);
+
+      // modulation depth for given tech and frame type (ASK depth for poll, load modulation for listen)
+      float modulationDepth(int techType, int frameType) const;
+
+      void setModulationDepth(int techType, int frameType, float value);
+
+   private:
+
+      std::shared_ptr<Impl> impl;
+};
+
+}
+
+#endif //NFC_LAB_NFCENCODER_H
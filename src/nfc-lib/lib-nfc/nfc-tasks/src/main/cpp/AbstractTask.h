@@ -27,6 +27,7 @@
 
 #include <rt/Event.h>
 #include <rt/Logger.h>
+#include <rt/Latency.h>
 #include <rt/Map.h>
 #include <rt/BlockingQueue.h>
 #include <rt/Subject.h>
@@ -71,6 +72,28 @@ struct AbstractTask
 
       statusSubject->next({code, {{"data", data.dump()}}}, true);
    }
+
+   /*
+    * latency histogram summary for status events, times in microseconds and buckets as counts per power of two
+    */
+   static json latencyStatus(const rt::Latency &latency)
+   {
+      json data = {
+            {"count",   latency.count()},
+            {"min",     latency.minimum() / 1E3},
+            {"average", latency.average() / 1E3},
+            {"max",     latency.maximum() / 1E3},
+            {"p50",     latency.percentile(0.50) / 1E3},
+            {"p90",     latency.percentile(0.90) / 1E3},
+            {"p99",     latency.percentile(0.99) / 1E3},
+            {"buckets", json::array()}
+      };
+
+      for (int i = 0; i < rt::Latency::Buckets; i++)
+         data["buckets"].push_back(latency.bucket(i));
+
+      return data;
+   }
 };
 
 }
@@ -31,6 +31,7 @@
 
 #include <sdr/SignalType.h>
 #include <sdr/SignalBuffer.h>
+#include <sdr/SignalKernel.h>
 
 #include "AbstractTask.h"
 
@@ -92,7 +93,12 @@ struct AdaptiveSamplingTask::Impl : AdaptiveSamplingTask, AbstractTask
 
       if (auto buffer = signalQueue.get(50))
       {
-         if (buffer->isValid())
+         // I/Q samples are shown as signal magnitude
+         if (buffer->isValid() && buffer->type() == sdr::SignalType::SAMPLE_IQ)
+         {
+            process(sdr::SignalKernel::magnitude(buffer.value()));
+         }
+         else if (buffer->isValid())
          {
             process(buffer.value());
          }
@@ -105,32 +111,45 @@ struct AdaptiveSamplingTask::Impl : AdaptiveSamplingTask, AbstractTask
    {
       sdr::SignalBuffer resampled(buffer.elements() * 2, 2, buffer.sampleRate(), buffer.offset(), 0, sdr::SignalType::ADAPTIVE_REAL);
 
+      auto input = buffer.readable();
+      auto output = resampled.writable(input.size() * 2);
+
+      if (input.empty())
+         return;
+
+      const float *src = input.data();
+      float *dst = output.data();
+
       float avrg = 0;
-      float last = buffer[0];
+      float last = src[0];
       float filter = THRESHOLD;
 
       // initialize average
-      for (int i = 0; i < (WINDOW / 2); i++)
-         avrg += buffer[i];
+      for (int i = 0; i < (WINDOW / 2) && i < input.size(); i++)
+         avrg += src[i];
+
+      // index of current output value
+      int w = 0;
 
       // always store first sample
-      resampled.put(buffer[0]).put(0.0);
+      dst[w++] = src[0];
+      dst[w++] = 0.0;
 
       // index of current point and last control point
-      int i = 0, c = 0, p = -1;
+      int i = 0, c = 0, p = -1, n = (int) input.size();
 
       // adaptive resample based on maximum average deviation
-      for (int r = i - (WINDOW / 2) - 1, a = i + (WINDOW / 2); i < buffer.limit(); i++, p++, a++, r++)
+      for (int r = i - (WINDOW / 2) - 1, a = i + (WINDOW / 2); i < n; i++, p++, a++, r++)
       {
-         float value = buffer[i];
+         float value = src[i];
 
          // add new sample
-         if (a < buffer.limit())
-            avrg += buffer[a];
+         if (a < n)
+            avrg += src[a];
 
          // remove old sample
          if (r >= 0)
-            avrg -= buffer[r];
+            avrg -= src[r];
 
          // detect deviation from average
          float stdev = std::abs(value - (avrg / float(WINDOW)));
@@ -139,11 +158,18 @@ struct AdaptiveSamplingTask::Impl : AdaptiveSamplingTask, AbstractTask
          if (stdev > filter || (i - c) > 100)
          {
             // append control point
-            if (stdev > filter && c < p)
-               resampled.put(last).put(float(p));
+            if (stdev > filter && c < p && w + 2 <= output.size())
+            {
+               dst[w++] = last;
+               dst[w++] = float(p);
+            }
 
             // append new value
-            resampled.put(value).put(float(i));
+            if (w + 2 <= output.size())
+            {
+               dst[w++] = value;
+               dst[w++] = float(i);
+            }
 
             // update control point index
             c = i;
@@ -154,8 +180,13 @@ struct AdaptiveSamplingTask::Impl : AdaptiveSamplingTask, AbstractTask
       }
 
       // store last sample
-      if (c < p)
-         resampled.put(last).put(float(p));
+      if (c < p && w + 2 <= output.size())
+      {
+         dst[w++] = last;
+         dst[w++] = float(p);
+      }
+
+      resampled.commit(w);
 
       resampled.flip();
 
@@ -22,60 +22,310 @@
 
 */
 
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
 #include <memory>
 
 #include <rt/BlockingQueue.h>
 #include <rt/Throughput.h>
+#include <rt/Latency.h>
 
+#include <sdr/SignalType.h>
+#include <sdr/SignalKernel.h>
+
+#include <nfc/Nfc.h>
 #include <nfc/NfcDecoder.h>
 #include <nfc/FrameDecoderTask.h>
+#include <nfc/SignalReceiverTask.h>
 
 #include "AbstractTask.h"
 
 namespace nfc {
 
+// stream time to wait for late frames from other receivers before merging, in seconds
+#define MERGE_WINDOW 0.25
+
+// decoder statistics interval
+#define STATUS_INTERVAL 1000
+
+// overload control defaults, queued buffers and decoding lag in milliseconds
+#define OVERLOAD_QUEUE_LIMIT 256
+#define OVERLOAD_LAG_LIMIT 1000
+#define OVERLOAD_DECIMATION 2
+
+// minimum time between overload level changes, in milliseconds
+#define OVERLOAD_ESCALATE_DELAY 100
+#define OVERLOAD_RECOVER_DELAY 2000
+
+// queued buffers are dropped at any level beyond this multiple of queue limit
+#define OVERLOAD_QUEUE_HARD_FACTOR 4
+
+// lowest sample rate reached by decimation
+#define OVERLOAD_MIN_SAMPLE_RATE 3E6
+
+// stream time a source can run ahead of host clock and still be handled as live, in seconds
+#define LIVE_SOURCE_SLACK 0.5
+
+// signal sampling stride for carrier detection on idle buffers
+#define CARRIER_SAMPLE_STRIDE 64
+
+// tech bit masks for overload tech shedding
+#define TECH_NFCA (1 << TechType::NfcA)
+#define TECH_NFCB (1 << TechType::NfcB)
+#define TECH_NFCF (1 << TechType::NfcF)
+#define TECH_NFCV (1 << TechType::NfcV)
+
 struct FrameDecoderTask::Impl : FrameDecoderTask, AbstractTask
 {
-   // decoder status
-   int status;
+   /*
+    * Overload levels, each one adds to previous: low priority techs are disabled, signal is decimated,
+    * buffers without carrier are skipped and finally buffers are dropped while pressure persists
+    */
+   enum Overload
+   {
+      Normal = 0,
+      ShedTechs = 1,
+      Decimate = 2,
+      SkipIdle = 3,
+      DropBuffers = 4
+   };
+
+   // overload action for each buffer
+   enum Action
+   {
+      DecodeBuffer,
+      SkipBuffer,
+      DropBuffer
+   };
+
+   /*
+    * Overload control parameters
+    */
+   struct OverloadConfig
+   {
+      // overload control enabled for live sources
+      bool enabled = true;
+
+      // queued buffers for full pressure
+      int queueLimit = OVERLOAD_QUEUE_LIMIT;
+
+      // decoding lag for full pressure, in milliseconds
+      int lagLimit = OVERLOAD_LAG_LIMIT;
+
+      // decimation factor from Decimate level
+      int decimation = OVERLOAD_DECIMATION;
+
+      // techs disabled from ShedTechs level
+      int lowPriority = TECH_NFCF | TECH_NFCV;
+   };
+
+   /*
+    * Overload decision counters
+    */
+   struct OverloadStats
+   {
+      long escalations = 0;
+      long recoveries = 0;
+      long shedBuffers = 0;
+      long decimatedBuffers = 0;
+      long skippedBuffers = 0;
+      long droppedBuffers = 0;
+      long droppedSamples = 0;
+   };
+
+   /*
+    * Decoder state copied after each buffer, status reads it without waiting for decoding
+    */
+   struct Snapshot
+   {
+      long sampleRate = 0;
+      long streamTime = 0;
+      bool debugEnabled = false;
+      float powerLevelThreshold = 0;
+      int overloadLevel = Normal;
+      OverloadStats overloadStats;
+      rt::Latency dequeueLatency;
+   };
+
+   /*
+    * Decoder for one receiver, reads signal.raw.N and publishes decoder.frame.N from its own thread.
+    * First receiver reads signal.raw so recorded signals replayed by SignalRecorderTask are decoded too
+    */
+   struct Channel
+   {
+      // receiver index
+      int index = 0;
+
+      // decoder, guarded by mutex
+      std::shared_ptr<nfc::NfcDecoder> decoder;
+
+      // decoder mutex
+      std::mutex mutex;
+
+      // signal buffer stream subject
+      rt::Subject<sdr::SignalBuffer> *signalStream = nullptr;
+
+      // frame stream subject
+      rt::Subject<nfc::NfcFrame> *frameStream = nullptr;
+
+      // signal stream subscription
+      rt::Subject<sdr::SignalBuffer>::Subscription signalSubscription;
+
+      // signal stream queue buffer
+      rt::BlockingQueue<sdr::SignalBuffer> signalQueue;
+
+      // decoding thread
+      std::thread worker;
+
+      // samples received since start, updated from signal subscription and read for decoder status
+      std::atomic<unsigned long> samplesReceived {0};
+
+      // host time of first sample, lowest estimate from buffer arrival times
+      std::atomic<double> clockOrigin {INFINITY};
+
+      // host time of first buffer arrival
+      std::atomic<double> firstArrival {INFINITY};
+
+      // stream time processed since start including skipped and dropped buffers, in seconds
+      double streamTime = 0;
+
+      // sample rate of received stream
+      unsigned int streamRate = 0;
+
+      // difference between stream time and decoder time, changes when decoder restarts or buffers are not decoded
+      double timeOffset = 0;
+
+      // sample rate of last buffer decoded
+      unsigned int decodedRate = 0;
+
+      // carrier present in last decoded buffer
+      bool carrierOn = false;
+
+      // start of dropped signal not yet reported, NAN if none
+      double gapStart = NAN;
+
+      // overload control parameters
+      OverloadConfig overload;
+
+      // current overload level
+      int overloadLevel = Normal;
+
+      // techs enabled before shedding
+      int overloadTechs = 0;
+
+      // last overload level change
+      std::chrono::time_point<std::chrono::steady_clock> overloadChange;
+
+      // overload decision counters
+      OverloadStats overloadStats;
+
+      // time from receiver publish to decoder dequeue
+      rt::Latency dequeueLatency;
 
-   // signal buffer frame stream subject
-   rt::Subject<sdr::SignalBuffer> *signalStream = nullptr;
+      // time from decoder dequeue and from device capture to merged frame emit, only used from task thread
+      rt::Latency emitLatency;
+      rt::Latency frameLatency;
 
-   // frame stream subject
+      // throughput meter
+      rt::Throughput throughput;
+
+      // last throughput statistics
+      std::chrono::time_point<std::chrono::steady_clock> lastThroughput;
+
+      // state for decoder status, guarded by its own mutex which is never held while decoding
+      std::mutex snapshotMutex;
+      Snapshot snapshot;
+   };
+
+   /*
+    * Frames decoded from one signal buffer, with channel time alignment
+    */
+   struct Decoded
+   {
+      // receiver index
+      int index;
+
+      // decoded frames
+      std::list<nfc::NfcFrame> frames;
+
+      // host time of first sample
+      double origin;
+
+      // host time of last sample decoded
+      double horizon;
+
+      // end of stream
+      bool eof;
+   };
+
+   // decoder status, read from signal subscriptions
+   std::atomic_int status;
+
+   // decoder channels
+   Channel channels[SignalReceiverTask::MaxReceivers];
+
+   // decoding threads running
+   std::atomic_bool decoding {false};
+
+   // overload control parameters
+   OverloadConfig overloadConfig;
+
+   // merged frame stream subject
    rt::Subject<nfc::NfcFrame> *frameStream = nullptr;
 
-   // signal stream subscription
-   rt::Subject<sdr::SignalBuffer>::Subscription signalSubscription;
+   // decoded frames queue
+   rt::BlockingQueue<Decoded> decodedQueue;
+
+   // frames pending merge, ordered by aligned host time
+   std::multimap<double, nfc::NfcFrame> mergeQueue;
 
-   // signal stream queue buffer
-   rt::BlockingQueue<sdr::SignalBuffer> signalQueue;
+   // channels with data pending end of stream
+   bool mergeActive[SignalReceiverTask::MaxReceivers] {};
 
-   // throughput meter
-   rt::Throughput taskThroughput;
+   // last aligned time decoded for each channel
+   double mergeHorizon[SignalReceiverTask::MaxReceivers] {};
 
-   // decoder
-   std::shared_ptr<nfc::NfcDecoder> decoder;
+   // last aligned time merged for each channel, keeps channel frame order when clock estimate changes
+   double mergeLast[SignalReceiverTask::MaxReceivers] {};
+
+   // aligned time of first sample from any channel
+   double mergeStart = INFINITY;
 
    // last status sent
    std::chrono::time_point<std::chrono::steady_clock> lastStatus;
 
-   // last Throughput statistics
-   std::chrono::time_point<std::chrono::steady_clock> lastThroughput;
-
-   Impl() : AbstractTask("FrameDecoderTask", "decoder"), status(FrameDecoderTask::Halt), decoder(new nfc::NfcDecoder())
+   Impl() : AbstractTask("FrameDecoderTask", "decoder"), status(FrameDecoderTask::Halt)
    {
-      // access to signal subject stream
-      signalStream = rt::Subject<sdr::SignalBuffer>::name("signal.raw");
-
-      // create frame stream subject
+      // create merged frame stream subject
       frameStream = rt::Subject<nfc::NfcFrame>::name("decoder.frame");
 
-      // subscribe to signal events
-      signalSubscription = signalStream->subscribe([this](const sdr::SignalBuffer &buffer) {
-         if (status == FrameDecoderTask::Listen)
-            signalQueue.add(buffer);
-      });
+      for (int i = 0; i < SignalReceiverTask::MaxReceivers; i++)
+      {
+         Channel &channel = channels[i];
+
+         channel.index = i;
+         channel.decoder = std::make_shared<nfc::NfcDecoder>();
+
+         updateSnapshot(channel);
+
+         // access to signal subject stream
+         channel.signalStream = rt::Subject<sdr::SignalBuffer>::name(i == 0 ? "signal.raw" : "signal.raw." + std::to_string(i));
+
+         // create frame stream subject
+         channel.frameStream = rt::Subject<nfc::NfcFrame>::name("decoder.frame." + std::to_string(i));
+
+         // subscribe to signal events
+         channel.signalSubscription = channel.signalStream->subscribe([this, &channel](const sdr::SignalBuffer &buffer) {
+            if (status == FrameDecoderTask::Listen)
+            {
+               updateClock(channel, buffer);
+               channel.signalQueue.add(buffer);
+            }
+         });
+      }
    }
 
    void start() override
@@ -85,6 +335,8 @@ struct FrameDecoderTask::Impl : FrameDecoderTask, AbstractTask
 
    void stop() override
    {
+      stopChannels();
+
       updateDecoderStatus(FrameDecoderTask::Halt);
    }
 
@@ -112,11 +364,15 @@ struct FrameDecoderTask::Impl : FrameDecoderTask, AbstractTask
       }
 
       /*
-       * process signal decode
+       * process decoded frames merge
        */
       if (status == FrameDecoderTask::Listen)
       {
-         signalDecode();
+         mergeFrames(50);
+
+         // periodic status with queue and overload statistics
+         if (status == FrameDecoderTask::Listen && (std::chrono::steady_clock::now() - lastStatus) > std::chrono::milliseconds(STATUS_INTERVAL))
+            updateDecoderStatus(status, false);
       }
       else
       {
@@ -128,11 +384,50 @@ struct FrameDecoderTask::Impl : FrameDecoderTask, AbstractTask
 
    void startDecoder(rt::Event &command)
    {
-      log.info("start frame decoding with {} pending buffers!", {signalQueue.size()});
+      stopChannels();
 
-      signalQueue.clear();
+      log.info("start frame decoding with {} pending buffers!", {queueSize()});
 
-      decoder->initialize();
+      for (auto &channel: channels)
+      {
+         std::lock_guard<std::mutex> lock(channel.mutex);
+
+         channel.signalQueue.clear();
+         channel.samplesReceived = 0;
+         channel.clockOrigin = INFINITY;
+         channel.firstArrival = INFINITY;
+         channel.streamTime = 0;
+         channel.streamRate = 0;
+         channel.timeOffset = 0;
+         channel.decodedRate = 0;
+         channel.carrierOn = false;
+         channel.gapStart = NAN;
+         channel.overloadStats = {};
+         channel.dequeueLatency.clear();
+         channel.emitLatency.clear();
+         channel.frameLatency.clear();
+         channel.overload = overloadConfig;
+         updateOverload(channel, Normal);
+         channel.decoder->initialize();
+         updateSnapshot(channel);
+      }
+
+      decodedQueue.clear();
+      mergeQueue.clear();
+
+      for (int i = 0; i < SignalReceiverTask::MaxReceivers; i++)
+      {
+         mergeActive[i] = false;
+         mergeHorizon[i] = 0;
+         mergeLast[i] = 0;
+      }
+
+      mergeStart = INFINITY;
+
+      startChannels();
+
+      // accept buffers before start is acknowledged
+      status = FrameDecoderTask::Listen;
 
       command.resolve();
 
@@ -141,15 +436,27 @@ struct FrameDecoderTask::Impl : FrameDecoderTask, AbstractTask
 
    void stopDecoder(rt::Event &command)
    {
-      log.info("stop frame decoding with {} pending buffers!", {signalQueue.size()});
+      log.info("stop frame decoding with {} pending buffers!", {queueSize()});
 
-      signalQueue.clear();
+      status = FrameDecoderTask::Halt;
 
-      for (const auto &frame: decoder->nextFrames({}))
+      stopChannels();
+
+      for (auto &channel: channels)
       {
-         frameStream->next(frame);
+         std::lock_guard<std::mutex> lock(channel.mutex);
+
+         channel.signalQueue.clear();
+
+         // flush frames pending in decoder
+         decodedQueue.add(Decoded {channel.index, publish(channel, flushFrames(channel)), channel.clockOrigin, INFINITY, true});
+
+         updateSnapshot(channel);
       }
 
+      // merge all remaining frames
+      mergeFrames(0);
+
       command.resolve();
 
       updateDecoderStatus(FrameDecoderTask::Halt);
@@ -163,176 +470,810 @@ struct FrameDecoderTask::Impl : FrameDecoderTask, AbstractTask
 
          log.info("change decoder config: {}", {config.dump()});
 
-         // NFC-A parameters
-         if (config.contains("nfca"))
+         // overload control parameters
+         if (config.contains("overload"))
          {
-            auto nfca = config["nfca"];
+            auto overload = config["overload"];
+
+            if (overload.contains("enabled"))
+               overloadConfig.enabled = overload["enabled"];
 
-            float min = NAN;
-            float max = NAN;
+            if (overload.contains("queueLimit"))
+               overloadConfig.queueLimit = std::max(1, overload["queueLimit"].get<int>());
 
-            if (nfca.contains("enabled"))
-               decoder->setEnableNfcA(nfca["enabled"]);
+            if (overload.contains("lagLimit"))
+               overloadConfig.lagLimit = std::max(1, overload["lagLimit"].get<int>());
 
-            if (nfca.contains("minimumModulationDeep"))
-               min = nfca["minimumModulationDeep"];
+            if (overload.contains("decimation"))
+               overloadConfig.decimation = std::max(1, overload["decimation"].get<int>());
 
-            if (nfca.contains("maximumModulationDeep"))
-               max = nfca["maximumModulationDeep"];
+            if (overload.contains("lowPriority"))
+            {
+               overloadConfig.lowPriority = 0;
 
-            decoder->setModulationThresholdNfcA(min, max);
+               for (const auto &tech: overload["lowPriority"])
+                  overloadConfig.lowPriority |= techMask(tech);
+            }
          }
 
-         // NFC-B parameters
-         if (config.contains("nfcb"))
+         // same configuration for all receivers
+         for (auto &channel: channels)
          {
-            auto nfcb = config["nfcb"];
+            std::lock_guard<std::mutex> lock(channel.mutex);
 
-            float min = NAN;
-            float max = NAN;
+            // configure over user enabled techs, not over shed ones
+            int level = channel.overloadLevel;
 
-            if (nfcb.contains("enabled"))
-               decoder->setEnableNfcB(nfcb["enabled"]);
+            updateOverload(channel, Normal);
 
-            if (nfcb.contains("minimumModulationDeep"))
-               min = nfcb["minimumModulationDeep"];
+            configure(*channel.decoder, config);
 
-            if (nfcb.contains("maximumModulationDeep"))
-               max = nfcb["maximumModulationDeep"];
+            channel.overload = overloadConfig;
 
-            decoder->setModulationThresholdNfcB(min, max);
+            updateOverload(channel, level);
+
+            updateSnapshot(channel);
          }
 
-         // NFC-F parameters
-         if (config.contains("nfcf"))
-         {
-            auto nfcf = config["nfcf"];
+         command.resolve();
+
+         updateDecoderStatus(status);
+      }
+      else
+      {
+         command.reject();
+      }
+   }
 
-            float min = NAN;
-            float max = NAN;
+   static void configure(nfc::NfcDecoder &decoder, const json &config)
+   {
+      // NFC-A parameters
+      if (config.contains("nfca"))
+      {
+         auto nfca = config["nfca"];
 
-            if (nfcf.contains("enabled"))
-               decoder->setEnableNfcF(nfcf["enabled"]);
+         float min = NAN;
+         float max = NAN;
 
-            if (nfcf.contains("minimumModulationDeep"))
-               min = nfcf["minimumModulationDeep"];
+         if (nfca.contains("enabled"))
+            decoder.setEnableNfcA(nfca["enabled"]);
 
-            if (nfcf.contains("maximumModulationDeep"))
-               max = nfcf["maximumModulationDeep"];
+         if (nfca.contains("minimumModulationDeep"))
+            min = nfca["minimumModulationDeep"];
 
-            decoder->setModulationThresholdNfcF(min, max);
-         }
+         if (nfca.contains("maximumModulationDeep"))
+            max = nfca["maximumModulationDeep"];
 
-         // NFC-V parameters
-         if (config.contains("nfcv"))
-         {
-            auto nfcv = config["nfcv"];
+         decoder.setModulationThresholdNfcA(min, max);
+      }
 
-            float min = NAN;
-            float max = NAN;
+      // NFC-B parameters
+      if (config.contains("nfcb"))
+      {
+         auto nfcb = config["nfcb"];
 
-            if (nfcv.contains("enabled"))
-               decoder->setEnableNfcV(nfcv["enabled"]);
+         float min = NAN;
+         float max = NAN;
 
-            if (nfcv.contains("minimumModulationDeep"))
-               min = nfcv["minimumModulationDeep"];
+         if (nfcb.contains("enabled"))
+            decoder.setEnableNfcB(nfcb["enabled"]);
 
-            if (nfcv.contains("maximumModulationDeep"))
-               max = nfcv["maximumModulationDeep"];
+         if (nfcb.contains("minimumModulationDeep"))
+            min = nfcb["minimumModulationDeep"];
 
-            decoder->setModulationThresholdNfcV(min, max);
-         }
+         if (nfcb.contains("maximumModulationDeep"))
+            max = nfcb["maximumModulationDeep"];
 
-         // stream reference time
-         if (config.contains("streamTime"))
-            decoder->setStreamTime(config["streamTime"]);
+         decoder.setModulationThresholdNfcB(min, max);
+      }
 
-         // Debug parameters
-         if (config.contains("debugEnabled"))
-            decoder->setEnableDebug(config["debugEnabled"]);
+      // NFC-F parameters
+      if (config.contains("nfcf"))
+      {
+         auto nfcf = config["nfcf"];
 
-         // global power level threshold
-         if (config.contains("powerLevelThreshold"))
-            decoder->setPowerLevelThreshold(config["powerLevelThreshold"]);
+         float min = NAN;
+         float max = NAN;
 
-         // sample rate must be last value set
-         if (config.contains("sampleRate"))
-            decoder->setSampleRate(config["sampleRate"]);
+         if (nfcf.contains("enabled"))
+            decoder.setEnableNfcF(nfcf["enabled"]);
 
-         command.resolve();
+         if (nfcf.contains("minimumModulationDeep"))
+            min = nfcf["minimumModulationDeep"];
 
-         updateDecoderStatus(status);
+         if (nfcf.contains("maximumModulationDeep"))
+            max = nfcf["maximumModulationDeep"];
+
+         decoder.setModulationThresholdNfcF(min, max);
       }
-      else
+
+      // NFC-V parameters
+      if (config.contains("nfcv"))
       {
-         command.reject();
+         auto nfcv = config["nfcv"];
+
+         float min = NAN;
+         float max = NAN;
+
+         if (nfcv.contains("enabled"))
+            decoder.setEnableNfcV(nfcv["enabled"]);
+
+         if (nfcv.contains("minimumModulationDeep"))
+            min = nfcv["minimumModulationDeep"];
+
+         if (nfcv.contains("maximumModulationDeep"))
+            max = nfcv["maximumModulationDeep"];
+
+         decoder.setModulationThresholdNfcV(min, max);
       }
+
+      // stream reference time
+      if (config.contains("streamTime"))
+         decoder.setStreamTime(config["streamTime"]);
+
+      // Debug parameters
+      if (config.contains("debugEnabled"))
+         decoder.setEnableDebug(config["debugEnabled"]);
+
+      // global power level threshold
+      if (config.contains("powerLevelThreshold"))
+         decoder.setPowerLevelThreshold(config["powerLevelThreshold"]);
+
+      // sample rate must be last value set
+      if (config.contains("sampleRate"))
+         decoder.setSampleRate(config["sampleRate"]);
    }
 
-   void signalDecode()
+   void startChannels()
    {
-      if (auto buffer = signalQueue.get())
+      decoding = true;
+
+      for (auto &channel: channels)
       {
-         taskThroughput.begin();
+         channel.worker = std::thread([this, &channel] {
+            while (decoding)
+            {
+               signalDecode(channel);
+            }
+         });
+      }
+   }
 
-         for (const auto &frame: decoder->nextFrames(buffer.value()))
+   void stopChannels()
+   {
+      decoding = false;
+
+      for (auto &channel: channels)
+      {
+         if (channel.worker.joinable())
+            channel.worker.join();
+      }
+   }
+
+   /*
+    * host time of first sample, estimated as the lowest difference between buffer arrival and stream position,
+    * buffers are delivered from receiver with variable latency but never before being captured
+    */
+   static void updateClock(Channel &channel, const sdr::SignalBuffer &buffer)
+   {
+      if (buffer.isValid() && buffer.sampleRate() > 0)
+      {
+         double now = hostTime();
+
+         if (channel.firstArrival == INFINITY)
+            channel.firstArrival = now;
+
+         channel.samplesReceived += buffer.elements();
+
+         double origin = now - double(channel.samplesReceived) / buffer.sampleRate();
+
+         if (origin < channel.clockOrigin)
+            channel.clockOrigin = origin;
+      }
+   }
+
+   void signalDecode(Channel &channel)
+   {
+      if (auto buffer = channel.signalQueue.get(50))
+      {
+         long long dequeueTime = rt::Latency::now();
+
+         std::lock_guard<std::mutex> lock(channel.mutex);
+
+         std::list<nfc::NfcFrame> frames;
+
+         channel.dequeueLatency.update(buffer->publishTime(), dequeueTime);
+
+         channel.throughput.begin();
+
+         if (buffer->isValid())
+         {
+            double duration = double(buffer->elements()) / buffer->sampleRate();
+
+            channel.streamRate = buffer->sampleRate();
+
+            switch (overloadControl(channel, buffer.value()))
+            {
+               case DecodeBuffer:
+               {
+                  frames = closeGap(channel);
+                  frames.splice(frames.end(), decodeBuffer(channel, buffer.value()));
+                  break;
+               }
+
+               case SkipBuffer:
+               {
+                  // decoder does not see this buffer
+                  frames = closeGap(channel);
+                  channel.timeOffset += duration;
+                  channel.overloadStats.skippedBuffers++;
+                  break;
+               }
+
+               case DropBuffer:
+               {
+                  // decoder restarts after dropped signal
+                  if (std::isnan(channel.gapStart))
+                     channel.gapStart = channel.streamTime;
+
+                  channel.decoder->initialize();
+                  channel.timeOffset = channel.streamTime + duration;
+                  channel.carrierOn = false;
+                  channel.overloadStats.droppedBuffers++;
+                  channel.overloadStats.droppedSamples += buffer->elements();
+                  break;
+               }
+            }
+
+            channel.streamTime += duration;
+         }
+         else
          {
-            frameStream->next(frame);
+            frames = flushFrames(channel);
          }
 
-         taskThroughput.update(buffer->elements());
+         traceFrames(frames, buffer.value(), dequeueTime);
+
+         publish(channel, frames);
+
+         channel.throughput.update(buffer->elements());
+
+         updateSnapshot(channel);
+
+         double origin = channel.clockOrigin;
+         double horizon = buffer->isValid() ? origin + channel.streamTime : INFINITY;
 
          if (!buffer->isValid())
          {
-            log.info("decoder EOF buffer received, finish!");
+            log.info("decoder EOF buffer received for receiver {}, finish!", {channel.index});
+
+            channel.decoder->cleanup();
+         }
+
+         decodedQueue.add(Decoded {channel.index, frames, origin, horizon, !buffer->isValid()});
+
+         if ((std::chrono::steady_clock::now() - channel.lastThroughput) > std::chrono::milliseconds(1000))
+         {
+            log.info("receiver {} average throughput {.2} Msps", {channel.index, channel.throughput.average() / 1E6});
+
+            channel.lastThroughput = std::chrono::steady_clock::now();
+         }
+      }
+   }
+
+   /*
+    * Decode buffer, decimated from Decimate overload level
+    */
+   std::list<nfc::NfcFrame> decodeBuffer(Channel &channel, const sdr::SignalBuffer &buffer)
+   {
+      sdr::SignalBuffer input = buffer;
+
+      if (channel.overloadLevel >= ShedTechs)
+         channel.overloadStats.shedBuffers++;
+
+      if (channel.overloadLevel >= Decimate && channel.overload.decimation > 1 && buffer.sampleRate() / channel.overload.decimation >= OVERLOAD_MIN_SAMPLE_RATE)
+      {
+         input = decimate(buffer, channel.overload.decimation);
+
+         channel.overloadStats.decimatedBuffers++;
+      }
+
+      // decoder restarts its clock on sample rate changes
+      if (channel.decodedRate && channel.decodedRate != input.sampleRate())
+         channel.timeOffset = channel.streamTime;
+
+      channel.decodedRate = input.sampleRate();
+
+      return adjustFrames(channel, channel.decoder->nextFrames(input));
+   }
+
+   /*
+    * Frames pending at end of stream
+    */
+   std::list<nfc::NfcFrame> flushFrames(Channel &channel)
+   {
+      auto frames = closeGap(channel);
 
-            decoder->cleanup();
+      frames.splice(frames.end(), adjustFrames(channel, channel.decoder->nextFrames({})));
 
-            updateDecoderStatus(FrameDecoderTask::Halt);
+      return frames;
+   }
+
+   /*
+    * Frame times are moved from decoder time to stream time when both differ
+    */
+   static std::list<nfc::NfcFrame> adjustFrames(Channel &channel, std::list<nfc::NfcFrame> frames)
+   {
+      bool adjust = channel.timeOffset != 0 || (channel.decodedRate && channel.decodedRate != channel.streamRate);
+
+      for (auto &frame: frames)
+      {
+         if (adjust)
+         {
+            frame.setTimeStart(frame.timeStart() + channel.timeOffset);
+            frame.setTimeEnd(frame.timeEnd() + channel.timeOffset);
+            frame.setDateTime(frame.dateTime() + channel.timeOffset);
+            frame.setSampleStart(std::lround(frame.timeStart() * channel.streamRate));
+            frame.setSampleEnd(std::lround(frame.timeEnd() * channel.streamRate));
          }
 
-         if ((std::chrono::steady_clock::now() - lastThroughput) > std::chrono::milliseconds(1000))
+         if (frame.isCarrierOn())
+            channel.carrierOn = true;
+         else if (frame.isCarrierOff())
+            channel.carrierOn = false;
+      }
+
+      return frames;
+   }
+
+   /*
+    * Frames carry trace times of the buffer where they were completed, set before frames are published
+    */
+   static void traceFrames(std::list<nfc::NfcFrame> &frames, const sdr::SignalBuffer &buffer, long long dequeueTime)
+   {
+      for (auto &frame: frames)
+      {
+         frame.setTraceTime(TraceHop::DeviceCapture, buffer.captureTime());
+         frame.setTraceTime(TraceHop::ReceiverPublish, buffer.publishTime());
+         frame.setTraceTime(TraceHop::DecoderDequeue, dequeueTime);
+      }
+   }
+
+   /*
+    * Report dropped signal as carrier lost with sync error, once signal is processed again
+    */
+   static std::list<nfc::NfcFrame> closeGap(Channel &channel)
+   {
+      std::list<nfc::NfcFrame> frames;
+
+      if (!std::isnan(channel.gapStart))
+      {
+         nfc::NfcFrame gap(TechType::None, FrameType::CarrierOff, channel.gapStart, channel.streamTime);
+
+         gap.setFramePhase(FramePhase::CarrierFrame);
+         gap.setFrameFlags(FrameFlags::SyncError);
+         gap.setSampleStart(std::lround(channel.gapStart * channel.streamRate));
+         gap.setSampleEnd(std::lround(channel.streamTime * channel.streamRate));
+         gap.setDateTime(channel.decoder->streamTime() + channel.gapStart);
+         gap.flip();
+
+         frames.push_back(gap);
+
+         channel.gapStart = NAN;
+      }
+
+      return frames;
+   }
+
+   /*
+    * Overload control, decoding pressure is the highest of queue depth and decoding lag relative to their limits.
+    * Level is raised while pressure is over limit and lowered once it stays under half the limit. Only live sources
+    * are controlled, recorded signals decoded faster than real time are never degraded
+    */
+   int overloadControl(Channel &channel, const sdr::SignalBuffer &buffer)
+   {
+      const auto &config = channel.overload;
+
+      if (!config.enabled || !isLive(channel))
+      {
+         updateOverload(channel, Normal);
+         return DecodeBuffer;
+      }
+
+      auto now = std::chrono::steady_clock::now();
+
+      int queued = channel.signalQueue.size();
+
+      // time from capture of this buffer last sample to now
+      double lag = hostTime() - channel.clockOrigin - channel.streamTime - double(buffer.elements()) / buffer.sampleRate();
+
+      double pressure = std::max(double(queued) / config.queueLimit, lag * 1000 / config.lagLimit);
+
+      if (pressure >= 1 && channel.overloadLevel < DropBuffers && now - channel.overloadChange > std::chrono::milliseconds(OVERLOAD_ESCALATE_DELAY))
+      {
+         log.warn("receiver {} decoder overloaded, queue {} lag {} ms, raise level to {}", {channel.index, queued, int(lag * 1000), channel.overloadLevel + 1});
+
+         updateOverload(channel, channel.overloadLevel + 1);
+
+         channel.overloadStats.escalations++;
+      }
+      else if (pressure < 0.5 && channel.overloadLevel > Normal && now - channel.overloadChange > std::chrono::milliseconds(OVERLOAD_RECOVER_DELAY))
+      {
+         log.info("receiver {} decoder recovered, queue {} lag {} ms, lower level to {}", {channel.index, queued, int(lag * 1000), channel.overloadLevel - 1});
+
+         updateOverload(channel, channel.overloadLevel - 1);
+
+         channel.overloadStats.recoveries++;
+      }
+
+      // queue memory is bounded at any level
+      if (queued >= config.queueLimit * OVERLOAD_QUEUE_HARD_FACTOR)
+         return DropBuffer;
+
+      if (channel.overloadLevel >= DropBuffers && pressure >= 1)
+         return DropBuffer;
+
+      if (channel.overloadLevel >= SkipIdle && !channel.carrierOn && signalPeak(buffer) < channel.decoder->powerLevelThreshold())
+         return SkipBuffer;
+
+      return DecodeBuffer;
+   }
+
+   /*
+    * Change overload level, low priority techs are disabled while level is ShedTechs or higher
+    */
+   static void updateOverload(Channel &channel, int level)
+   {
+      if (level >= ShedTechs && channel.overloadLevel < ShedTechs)
+      {
+         channel.overloadTechs = enabledTechs(*channel.decoder);
+
+         enableTechs(*channel.decoder, channel.overloadTechs & ~channel.overload.lowPriority);
+      }
+      else if (level < ShedTechs && channel.overloadLevel >= ShedTechs)
+      {
+         enableTechs(*channel.decoder, channel.overloadTechs);
+      }
+
+      if (channel.overloadLevel != level)
+         channel.overloadChange = std::chrono::steady_clock::now();
+
+      channel.overloadLevel = level;
+   }
+
+   /*
+    * Source is live when stream time does not run ahead of host time since first buffer
+    */
+   static bool isLive(const Channel &channel)
+   {
+      return channel.firstArrival - channel.clockOrigin < LIVE_SOURCE_SLACK;
+   }
+
+   static double hostTime()
+   {
+      return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+   }
+
+   /*
+    * Maximum signal magnitude from one of each CARRIER_SAMPLE_STRIDE samples
+    */
+   static float signalPeak(const sdr::SignalBuffer &buffer)
+   {
+      const float *src = buffer.data();
+
+      float peak = 0;
+
+      for (unsigned int j = 0; j < buffer.elements(); j += CARRIER_SAMPLE_STRIDE)
+      {
+         float value = buffer.stride() == 2 ? std::sqrt(src[j * 2] * src[j * 2] + src[j * 2 + 1] * src[j * 2 + 1]) : std::fabs(src[j]);
+
+         peak = std::max(peak, value);
+      }
+
+      return peak;
+   }
+
+   /*
+    * Signal magnitude averaged over each factor samples, at sample rate divided by factor
+    */
+   static sdr::SignalBuffer decimate(const sdr::SignalBuffer &buffer, int factor)
+   {
+      sdr::SignalBuffer input = buffer.stride() == 2 ? sdr::SignalKernel::magnitude(buffer) : buffer;
+
+      unsigned int count = input.elements() / factor;
+
+      sdr::SignalBuffer result(count, 1, buffer.sampleRate() / factor, buffer.offset() / factor, 0, sdr::SignalType::SAMPLE_REAL);
+
+      const float *src = input.data();
+      float *dst = result.pull(count);
+
+      for (unsigned int i = 0; i < count; i++, src += factor)
+      {
+         float value = 0;
+
+         for (int j = 0; j < factor; j++)
+            value += src[j];
+
+         dst[i] = value / float(factor);
+      }
+
+      result.flip();
+
+      return result;
+   }
+
+   static int enabledTechs(const nfc::NfcDecoder &decoder)
+   {
+      return (decoder.isNfcAEnabled() ? TECH_NFCA : 0) |
+             (decoder.isNfcBEnabled() ? TECH_NFCB : 0) |
+             (decoder.isNfcFEnabled() ? TECH_NFCF : 0) |
+             (decoder.isNfcVEnabled() ? TECH_NFCV : 0);
+   }
+
+   static void enableTechs(nfc::NfcDecoder &decoder, int techs)
+   {
+      decoder.setEnableNfcA(techs & TECH_NFCA);
+      decoder.setEnableNfcB(techs & TECH_NFCB);
+      decoder.setEnableNfcF(techs & TECH_NFCF);
+      decoder.setEnableNfcV(techs & TECH_NFCV);
+   }
+
+   // techs configured by user, without overload shedding
+   static int configuredTechs(const Channel &channel)
+   {
+      return channel.overloadLevel >= ShedTechs ? channel.overloadTechs : enabledTechs(*channel.decoder);
+   }
+
+   static int techMask(const std::string &name)
+   {
+      if (name == "nfca")
+         return TECH_NFCA;
+
+      if (name == "nfcb")
+         return TECH_NFCB;
+
+      if (name == "nfcf")
+         return TECH_NFCF;
+
+      if (name == "nfcv")
+         return TECH_NFCV;
+
+      return 0;
+   }
+
+   /*
+    * Send decoded frames on receiver stream, frames are complete before first one is sent, later hops are traced
+    * on copies so receiver stream subscribers never see them change
+    */
+   static std::list<nfc::NfcFrame> publish(Channel &channel, std::list<nfc::NfcFrame> frames)
+   {
+      for (auto &frame: frames)
+      {
+         frame.setFrameSource(channel.index);
+      }
+
+      for (const auto &frame: frames)
+      {
+         channel.frameStream->next(frame);
+      }
+
+      return frames;
+   }
+
+   /*
+    * Merge frames from all receivers in a single stream ordered by aligned host time. A frame is sent once all other
+    * receivers have decoded MERGE_WINDOW beyond it. With a single receiver frames are sent as soon as decoded, once
+    * the first MERGE_WINDOW of stream is over so receivers started later are not missed
+    */
+   void mergeFrames(int timeout)
+   {
+      bool finished = false;
+
+      while (auto decoded = decodedQueue.get(timeout))
+      {
+         int index = decoded->index;
+
+         timeout = 0;
+
+         mergeActive[index] = !decoded->eof;
+         mergeHorizon[index] = decoded->horizon;
+         mergeStart = std::min(mergeStart, decoded->origin);
+
+         for (const auto &frame: decoded->frames)
          {
-            log.info("average throughput {.2} Msps", {taskThroughput.average() / 1E6});
+            mergeLast[index] = std::max(mergeLast[index], decoded->origin + frame.timeStart());
+
+            mergeQueue.emplace(mergeLast[index], frame);
+         }
+
+         finished |= decoded->eof;
+      }
+
+      int active = 0;
+      double watermark = INFINITY;
+      double progress = 0;
 
-            lastThroughput = std::chrono::steady_clock::now();
+      for (int i = 0; i < SignalReceiverTask::MaxReceivers; i++)
+      {
+         if (mergeActive[i])
+         {
+            active++;
+            watermark = std::min(watermark, mergeHorizon[i] - MERGE_WINDOW);
+            progress = std::max(progress, mergeHorizon[i] - mergeStart);
          }
       }
+
+      // nothing to wait for with one receiver
+      if (active < 2 && (active == 0 || progress > MERGE_WINDOW))
+         watermark = INFINITY;
+
+      while (!mergeQueue.empty() && mergeQueue.begin()->first <= watermark)
+      {
+         nfc::NfcFrame &frame = mergeQueue.begin()->second;
+
+         traceEmit(frame);
+
+         frameStream->next(frame);
+
+         mergeQueue.erase(mergeQueue.begin());
+      }
+
+      // all receivers reached end of stream
+      if (finished && active == 0 && status == FrameDecoderTask::Listen)
+      {
+         log.info("all receivers finished, stop decoding");
+
+         updateDecoderStatus(FrameDecoderTask::Halt);
+      }
+   }
+
+   /*
+    * Merged stream emit is the last hop traced by decoder
+    */
+   void traceEmit(nfc::NfcFrame &frame)
+   {
+      Channel &channel = channels[frame.frameSource()];
+
+      long long emitTime = rt::Latency::now();
+
+      frame.setTraceTime(TraceHop::FrameEmit, emitTime);
+
+      channel.emitLatency.update(frame.traceTime(TraceHop::DecoderDequeue), emitTime);
+      channel.frameLatency.update(frame.traceTime(TraceHop::DeviceCapture), emitTime);
+   }
+
+   int queueSize()
+   {
+      int size = 0;
+
+      for (auto &channel: channels)
+         size += channel.signalQueue.size();
+
+      return size;
+   }
+
+   /*
+    * Copy decoder state for status, called with channel mutex held
+    */
+   static void updateSnapshot(Channel &channel)
+   {
+      std::lock_guard<std::mutex> lock(channel.snapshotMutex);
+
+      channel.snapshot.sampleRate = channel.decoder->sampleRate();
+      channel.snapshot.streamTime = channel.decoder->streamTime();
+      channel.snapshot.debugEnabled = channel.decoder->isDebugEnabled();
+      channel.snapshot.powerLevelThreshold = channel.decoder->powerLevelThreshold();
+      channel.snapshot.overloadLevel = channel.overloadLevel;
+      channel.snapshot.overloadStats = channel.overloadStats;
+      channel.snapshot.dequeueLatency = channel.dequeueLatency;
+   }
+
+   static Snapshot readSnapshot(Channel &channel)
+   {
+      std::lock_guard<std::mutex> lock(channel.snapshotMutex);
+
+      return channel.snapshot;
    }
 
    void updateDecoderStatus(int value, bool config = true)
    {
       status = value;
 
-      json data({
-                      {"status",              status == Listen ? "decoding" : "idle"},
-                      {"queueSize",           signalQueue.size()},
-                      {"sampleRate",          decoder->sampleRate()},
-                      {"streamTime",          decoder->streamTime()},
-                      {"debugEnabled",        decoder->isDebugEnabled()},
-                      {"powerLevelThreshold", decoder->powerLevelThreshold()}
-                });
+      json data;
 
-      if (config)
       {
-         data["nfca"] = {
-               {"enabled", decoder->isNfcAEnabled()}
-         };
+         Channel &primary = channels[0];
 
-         data["nfcb"] = {
-               {"enabled", decoder->isNfcBEnabled()}
-         };
+         Snapshot snapshot = readSnapshot(primary);
 
-         data["nfcf"] = {
-               {"enabled", decoder->isNfcFEnabled()}
+         data = {
+               {"status",              status == Listen ? "decoding" : "idle"},
+               {"queueSize",           queueSize()},
+               {"sampleRate",          snapshot.sampleRate},
+               {"streamTime",          snapshot.streamTime},
+               {"debugEnabled",        snapshot.debugEnabled},
+               {"powerLevelThreshold", snapshot.powerLevelThreshold}
          };
 
-         data["nfcv"] = {
-               {"enabled", decoder->isNfcVEnabled()}
-         };
+         if (config)
+         {
+            int techs;
+
+            {
+               std::lock_guard<std::mutex> lock(primary.mutex);
+
+               techs = configuredTechs(primary);
+            }
+
+            data["nfca"] = {
+                  {"enabled", bool(techs & TECH_NFCA)}
+            };
+
+            data["nfcb"] = {
+                  {"enabled", bool(techs & TECH_NFCB)}
+            };
+
+            data["nfcf"] = {
+                  {"enabled", bool(techs & TECH_NFCF)}
+            };
+
+            data["nfcv"] = {
+                  {"enabled", bool(techs & TECH_NFCV)}
+            };
+
+            data["overload"] = {
+                  {"enabled",     overloadConfig.enabled},
+                  {"queueLimit",  overloadConfig.queueLimit},
+                  {"lagLimit",    overloadConfig.lagLimit},
+                  {"decimation",  overloadConfig.decimation},
+                  {"lowPriority", json::array()}
+            };
+
+            for (const auto &name: {"nfca", "nfcb", "nfcf", "nfcv"})
+            {
+               if (overloadConfig.lowPriority & techMask(name))
+                  data["overload"]["lowPriority"].push_back(name);
+            }
+         }
+      }
+
+      // receivers with data, host time of first sample for alignment, overload decisions and latency per hop
+      for (auto &channel: channels)
+      {
+         if (channel.samplesReceived > 0)
+         {
+            Snapshot snapshot = readSnapshot(channel);
+
+            const auto &stats = snapshot.overloadStats;
+
+            data["channels"].push_back({
+                                             {"index",       channel.index},
+                                             {"queueSize",   channel.signalQueue.size()},
+                                             {"clockOrigin", channel.clockOrigin.load()},
+                                             {"overload",    {
+                                                                   {"level", snapshot.overloadLevel},
+                                                                   {"escalations", stats.escalations},
+                                                                   {"recoveries", stats.recoveries},
+                                                                   {"shedBuffers", stats.shedBuffers},
+                                                                   {"decimatedBuffers", stats.decimatedBuffers},
+                                                                   {"skippedBuffers", stats.skippedBuffers},
+                                                                   {"droppedBuffers", stats.droppedBuffers},
+                                                                   {"droppedSamples", stats.droppedSamples}
+                                                             }},
+                                             {"latency",     {
+                                                                   {"dequeue", latencyStatus(snapshot.dequeueLatency)},
+                                                                   {"emit", latencyStatus(channel.emitLatency)},
+                                                                   {"total", latencyStatus(channel.frameLatency)}
+                                                             }}
+                                       });
+         }
       }
 
-      log.info("updated decoder status: {}", {data.dump()});
+      // periodic updates only at debug level, state and config changes are always logged
+      if (config)
+         log.info("updated decoder status: {}", {data.dump()});
+      else
+         log.debug("updated decoder status: {}", {data.dump()});
 
       updateStatus(status, data);
 
@@ -0,0 +1,571 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <unistd.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <cerrno>
+#include <csignal>
+#include <sys/file.h>
+#define USE_POSIX_IO
+#endif
+
+#include <set>
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+#include <rt/Logger.h>
+#include <rt/FileSystem.h>
+
+#include <nfc/FrameStore.h>
+#include <nfc/FrameHistory.h>
+
+// default frames kept in memory
+#define MEMORY_FRAMES 65536
+
+// spool directory under system temporary path
+#define SPOOL_NAME "nfc-lab-history"
+
+// lock file held by process owning a spool session directory
+#define SPOOL_LOCK "owner.lock"
+
+// frames per spool file before rotation
+#define SPOOL_FILE_FRAMES 262144
+
+// default disk space for spool files
+#define RETENTION_BYTES (1024LL * 1024 * 1024)
+
+// appended frames between retention checks
+#define RETENTION_CHECK 4096
+
+namespace nfc {
+
+struct SpoolFile
+{
+   std::string path;
+   long frames;
+   long long bytes;
+   double timeStart;
+   double timeEnd;
+   std::chrono::system_clock::time_point created;
+};
+
+/*
+ * Spool directory owned by this history, named "<pid>-<instance>" and locked while files are in use
+ */
+struct SpoolSession
+{
+   std::string path;
+   int lock;
+};
+
+struct FrameHistory::Impl
+{
+   rt::Logger log {"FrameHistory"};
+
+   // most recent frames
+   std::deque<NfcFrame> memory;
+
+   // closed spool files, oldest first
+   std::deque<SpoolFile> spool;
+
+   // spool file receiving frames
+   std::shared_ptr<FrameStore> active;
+   SpoolFile activeFile {};
+
+   std::string spoolPath;
+
+   // locked session directories, last one receives new files
+   std::vector<SpoolSession> sessions;
+
+   long memoryFrames = MEMORY_FRAMES;
+   long retentionFrames = 0;
+   long long retentionBytes = RETENTION_BYTES;
+   double retentionAge = 0;
+
+   long spoolFrames = 0;
+   long long spoolSize = 0;
+   long appended = 0;
+   long discarded = 0;
+   int sequence = 0;
+
+   Impl()
+   {
+      spoolPath = tempPath() + "/" SPOOL_NAME;
+
+      purge();
+   }
+
+   ~Impl()
+   {
+      clear();
+   }
+
+   void append(const NfcFrame &frame)
+   {
+      memory.push_back(frame);
+
+      // move oldest frames out of memory window
+      while (memory.size() > memoryFrames)
+      {
+         spill(memory.front());
+
+         memory.pop_front();
+      }
+
+      if (++appended % RETENTION_CHECK == 0)
+         retain();
+   }
+
+   void spill(const NfcFrame &frame)
+   {
+      // only frames with content are stored
+      if (!frame.isPollFrame() && !frame.isListenFrame())
+         return;
+
+      if (spoolPath.empty() || (!active && !openSpool()))
+      {
+         discarded++;
+         return;
+      }
+
+      if (!activeFile.frames)
+         activeFile.timeStart = frame.timeStart();
+
+      active->append(frame);
+
+      activeFile.timeEnd = frame.timeEnd();
+      activeFile.frames++;
+
+      spoolFrames++;
+
+      if (activeFile.frames >= SPOOL_FILE_FRAMES)
+         rotate();
+   }
+
+   bool openSpool()
+   {
+      if (!openSession())
+      {
+         log.warn("unable to create spool path [{}], frames will be discarded", {spoolPath});
+
+         spoolPath.clear();
+
+         return false;
+      }
+
+      char name[32];
+
+      snprintf(name, sizeof(name), "/frames-%06d.nfcd", ++sequence);
+
+      activeFile = {sessions.back().path + name, 0, 0, 0, 0, std::chrono::system_clock::now()};
+
+      active = std::make_shared<FrameStore>(activeFile.path);
+
+      if (!active->open(FrameStore::Write))
+      {
+         log.warn("unable to create spool file [{}], frames will be discarded", {activeFile.path});
+
+         active.reset();
+
+         spoolPath.clear();
+
+         return false;
+      }
+
+      log.debug("open spool file [{}]", {activeFile.path});
+
+      return true;
+   }
+
+   void rotate()
+   {
+      active->close();
+      active.reset();
+
+      activeFile.bytes = rt::FileSystem::fileSize(activeFile.path);
+
+      spoolSize += activeFile.bytes;
+
+      log.debug("closed spool file [{}] with {} frames, {} bytes", {activeFile.path, activeFile.frames, activeFile.bytes});
+
+      spool.push_back(activeFile);
+
+      activeFile = {};
+
+      retain();
+   }
+
+   /*
+    * Create and lock own session directory under spool path, files from other processes are never shared
+    */
+   bool openSession()
+   {
+      if (!sessions.empty() && sessions.back().path.compare(0, spoolPath.size() + 1, spoolPath + "/") == 0)
+         return true;
+
+      static std::atomic<int> instances {0};
+
+      char name[32];
+
+      snprintf(name, sizeof(name), "/%d-%d", (int) getpid(), instances++);
+
+      SpoolSession session {spoolPath + name, -1};
+
+      if (!rt::FileSystem::createPath(session.path))
+         return false;
+
+#ifdef USE_POSIX_IO
+      session.lock = ::open((session.path + "/" SPOOL_LOCK).c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0600);
+
+      if (session.lock < 0 || flock(session.lock, LOCK_EX | LOCK_NB) != 0)
+      {
+         if (session.lock >= 0)
+            ::close(session.lock);
+
+         return false;
+      }
+#else
+      rt::FileSystem::truncateFile(session.path + "/" SPOOL_LOCK);
+#endif
+
+      // directory left by a finished process with same pid
+      removeSpoolFiles(session.path);
+
+      sessions.push_back(session);
+
+      sequence = 0;
+
+      return true;
+   }
+
+   void closeSessions()
+   {
+      for (const auto &session: sessions)
+      {
+         // lock file is removed while still held so no other process takes an empty directory as stale
+         rt::FileSystem::removeFile(session.path + "/" SPOOL_LOCK);
+
+#ifdef USE_POSIX_IO
+         ::close(session.lock);
+#endif
+
+         rt::FileSystem::removeDirectory(session.path);
+      }
+
+      sessions.clear();
+   }
+
+   /*
+    * Remove session directories left by processes no longer running, for example after a crash
+    */
+   void purge()
+   {
+      if (spoolPath.empty())
+         return;
+
+      int removed = 0;
+
+      for (const auto &entry: rt::FileSystem::directoryList(spoolPath))
+      {
+         if (!rt::FileSystem::isDirectory(entry.name) || isOwned(entry.name))
+            continue;
+
+#ifdef USE_POSIX_IO
+         // stale when its lock can be taken, or when it has no lock yet and owner process is gone
+         int lock = ::open((entry.name + "/" SPOOL_LOCK).c_str(), O_RDWR | O_CLOEXEC);
+
+         if (lock < 0 ? isRunning(entry.name) : flock(lock, LOCK_EX | LOCK_NB) != 0)
+         {
+            if (lock >= 0)
+               ::close(lock);
+
+            continue;
+         }
+
+         // lock is held until directory is removed
+         removed += removeSpoolFiles(entry.name);
+
+         rt::FileSystem::removeFile(entry.name + "/" SPOOL_LOCK);
+         rt::FileSystem::removeDirectory(entry.name);
+
+         if (lock >= 0)
+            ::close(lock);
+#endif
+      }
+
+      if (removed)
+         log.info("removed {} stale spool files from [{}]", {removed, spoolPath});
+   }
+
+   bool isOwned(const std::string &path) const
+   {
+      for (const auto &session: sessions)
+      {
+         if (session.path == path)
+            return true;
+      }
+
+      return false;
+   }
+
+#ifdef USE_POSIX_IO
+   static bool isRunning(const std::string &path)
+   {
+      int pid = std::atoi(path.substr(path.find_last_of('/') + 1).c_str());
+
+      return pid <= 0 || kill(pid, 0) == 0 || errno != ESRCH;
+   }
+#endif
+
+   static int removeSpoolFiles(const std::string &path)
+   {
+      int removed = 0;
+
+      for (const auto &entry: rt::FileSystem::directoryList(path))
+      {
+         auto name = entry.name.substr(entry.name.find_last_of('/') + 1);
+
+         if (name.rfind("frames-", 0) != 0 || name.size() < 5 || name.compare(name.size() - 5, 5, ".nfcd") != 0)
+            continue;
+
+         if (rt::FileSystem::removeFile(entry.name))
+            removed++;
+      }
+
+      return removed;
+   }
+
+   /*
+    * Remove oldest spool files while any retention limit is exceeded, active file counts toward disk limit
+    */
+   void retain()
+   {
+      auto now = std::chrono::system_clock::now();
+
+      // active file alone exceeds disk limit, close it so can be removed
+      if (spool.empty() && active && activeFile.frames && retentionBytes > 0 && activeBytes() > retentionBytes)
+      {
+         rotate();
+         return;
+      }
+
+      while (!spool.empty())
+      {
+         const SpoolFile &oldest = spool.front();
+
+         bool exceeded = (retentionFrames > 0 && size() > retentionFrames) ||
+                         (retentionBytes > 0 && spoolSize + activeBytes() > retentionBytes) ||
+                         (retentionAge > 0 && std::chrono::duration<double>(now - oldest.created).count() > retentionAge);
+
+         if (!exceeded)
+            break;
+
+         log.debug("remove spool file [{}] with {} frames", {oldest.path, oldest.frames});
+
+         rt::FileSystem::removeFile(oldest.path);
+
+         spoolFrames -= oldest.frames;
+         spoolSize -= oldest.bytes;
+
+         spool.pop_front();
+      }
+
+      // memory window alone may exceed frame limit
+      while (retentionFrames > 0 && memory.size() > retentionFrames)
+      {
+         memory.pop_front();
+      }
+   }
+
+   void clear()
+   {
+      std::set<std::string> folders;
+
+      if (!spoolPath.empty())
+         folders.insert(spoolPath);
+
+      if (active)
+      {
+         active->close();
+         active.reset();
+
+         rt::FileSystem::removeFile(activeFile.path);
+      }
+
+      for (const auto &file: spool)
+      {
+         rt::FileSystem::removeFile(file.path);
+      }
+
+      for (const auto &session: sessions)
+      {
+         folders.insert(session.path.substr(0, session.path.find_last_of('/')));
+      }
+
+      closeSessions();
+
+      // only succeeds for directories left empty
+      for (const auto &folder: folders)
+      {
+         rt::FileSystem::removeDirectory(folder);
+      }
+
+      if (discarded)
+         log.info("{} frames discarded from history", {discarded});
+
+      spool.clear();
+      memory.clear();
+      activeFile = {};
+      spoolFrames = 0;
+      spoolSize = 0;
+      discarded = 0;
+   }
+
+   long size() const
+   {
+      return spoolFrames + memory.size();
+   }
+
+   // bytes written to active spool file, pending partial segment not included
+   long long activeBytes() const
+   {
+      return active ? std::max(rt::FileSystem::fileSize(activeFile.path), 0LL) : 0;
+   }
+
+   void forEach(const std::function<void(const NfcFrame &)> &handler)
+   {
+      // frames on disk, active file is readable after flush
+      if (active)
+         active->flush();
+
+      auto visit = [&handler](const std::string &path) {
+         FrameStore store(path);
+
+         if (store.open(FrameStore::Read))
+         {
+            for (long i = 0, count = store.count(); i < count; i++)
+            {
+               handler(store.frame(i));
+            }
+         }
+      };
+
+      for (const auto &file: spool)
+      {
+         visit(file.path);
+      }
+
+      if (active)
+         visit(activeFile.path);
+
+      // recent frames in memory
+      for (const auto &frame: memory)
+      {
+         handler(frame);
+      }
+   }
+
+   static std::string tempPath()
+   {
+      for (const char *name: {"TMPDIR", "TEMP", "TMP"})
+      {
+         if (const char *value = std::getenv(name))
+            return value;
+      }
+
+      return "/tmp";
+   }
+};
+
+FrameHistory::FrameHistory() : impl(std::make_shared<Impl>())
+{
+}
+
+void FrameHistory::setMemoryFrames(long frames)
+{
+   impl->memoryFrames = frames > 0 ? frames : MEMORY_FRAMES;
+}
+
+void FrameHistory::setSpoolPath(const std::string &path)
+{
+   if (impl->active)
+      impl->rotate();
+
+   impl->spoolPath = path;
+
+   impl->purge();
+}
+
+void FrameHistory::setRetentionFrames(long frames)
+{
+   impl->retentionFrames = frames;
+}
+
+void FrameHistory::setRetentionBytes(long long bytes)
+{
+   impl->retentionBytes = bytes;
+}
+
+void FrameHistory::setRetentionAge(double seconds)
+{
+   impl->retentionAge = seconds;
+}
+
+void FrameHistory::append(const NfcFrame &frame)
+{
+   impl->append(frame);
+}
+
+void FrameHistory::clear()
+{
+   impl->clear();
+}
+
+long FrameHistory::size() const
+{
+   return impl->size();
+}
+
+long FrameHistory::memorySize() const
+{
+   return impl->memory.size();
+}
+
+long long FrameHistory::spoolBytes() const
+{
+   return impl->spoolSize + impl->activeBytes();
+}
+
+void FrameHistory::forEach(const std::function<void(const NfcFrame &)> &handler)
+{
+   impl->forEach(handler);
+}
+
+}
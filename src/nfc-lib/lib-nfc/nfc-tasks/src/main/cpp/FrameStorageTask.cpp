@@ -22,15 +22,15 @@
 
 */
 
-#include <fstream>
-#include <iomanip>
-
 #include <rt/Logger.h>
 #include <rt/BlockingQueue.h>
-#include <rt/FileSystem.h>
 
 #include <nfc/Nfc.h>
 #include <nfc/NfcFrame.h>
+#include <nfc/FrameStore.h>
+#include <nfc/FrameHistory.h>
+#include <nfc/JsonFrameReader.h>
+#include <nfc/JsonFrameWriter.h>
 #include <nfc/FrameStorageTask.h>
 
 #include "AbstractTask.h"
@@ -48,9 +48,15 @@ struct FrameStorageTask::Impl : FrameStorageTask, AbstractTask
    // frame stream subscription
    rt::Subject<nfc::NfcFrame>::Subscription decoderSubscription;
 
-   // frame stream queue buffer
+   // frames received from decoder pending to be stored
    rt::BlockingQueue<nfc::NfcFrame> frameQueue;
 
+   // bounded frame history, memory window and spool files
+   FrameHistory frameHistory;
+
+   // binary file receiving new frames while capture is running
+   std::shared_ptr<nfc::FrameStore> streamFile;
+
    Impl() : AbstractTask("FrameStorageTask", "storage")
    {
       // create storage stream subject
@@ -71,6 +77,7 @@ struct FrameStorageTask::Impl : FrameStorageTask, AbstractTask
 
    void stop() override
    {
+      closeStream();
    }
 
    bool loop() override
@@ -82,6 +89,12 @@ struct FrameStorageTask::Impl : FrameStorageTask, AbstractTask
       {
          log.debug("recorder command [{}]", {command->code});
 
+         // commands see all frames received so far
+         storeFrames();
+
+         // any new command finish current stream file
+         closeStream();
+
          if (command->code == FrameStorageTask::Read)
          {
             readFile(command.value());
@@ -94,8 +107,17 @@ struct FrameStorageTask::Impl : FrameStorageTask, AbstractTask
          {
             clearQueue(command.value());
          }
+         else if (command->code == FrameStorageTask::Configure)
+         {
+            configStorage(command.value());
+         }
       }
 
+      /*
+       * move received frames to history and stream file
+       */
+      storeFrames();
+
       wait(250);
 
       return true;
@@ -115,46 +137,24 @@ struct FrameStorageTask::Impl : FrameStorageTask, AbstractTask
 
             log.info("read frames from file {}", {file});
 
-            json info;
-
-            if (rt::FileSystem::exists(file))
+            if (nfc::FrameStore::isFrameFile(file))
             {
-               // open file
-               std::ifstream input(file);
+               readFrames(file);
 
-               // read json
-               input >> info;
-            }
+               command.resolve();
 
-            if (info.contains("frames"))
-            {
-               // read frames from file
-               for (const auto &frame: info["frames"])
-               {
-                  nfc::NfcFrame nfcFrame(256);
-
-                  nfcFrame.setTechType(frame["techType"]);
-                  nfcFrame.setFrameType(frame["frameType"]);
-                  nfcFrame.setFramePhase(frame["framePhase"]);
-                  nfcFrame.setFrameFlags(frame["frameFlags"]);
-                  nfcFrame.setFrameRate(frame["frameRate"]);
-                  nfcFrame.setTimeStart(frame["timeStart"]);
-                  nfcFrame.setTimeEnd(frame["timeEnd"]);
-                  nfcFrame.setSampleStart(frame["sampleStart"]);
-                  nfcFrame.setSampleEnd(frame["sampleEnd"]);
+               return;
+            }
 
-                  std::string frameData = frame["frameData"];
+            // frames are published while file is parsed
+            nfc::JsonFrameReader reader(file);
 
-                  for (size_t index = 0, size = 0; index < frameData.length(); index += size + 1)
-                  {
-                     nfcFrame.put(std::stoi(frameData.c_str() + index, &size, 16));
-                  }
+            reader.read([this](const nfc::NfcFrame &frame) {
+               storageStream->next(frame);
+               return true;
+            });
 
-                  nfcFrame.flip();
-
-                  storageStream->next(nfcFrame);
-               }
-            }
+            log.info("readed {} frames from file {}", {reader.count(), file});
 
             command.resolve();
 
@@ -187,40 +187,38 @@ struct FrameStorageTask::Impl : FrameStorageTask, AbstractTask
 
             log.info("write frames to file {}", {file});
 
-            json frames = json::array();
-
-            for (const auto &frame: frameQueue)
+            // binary frame file, other extensions are exported as JSON
+            if (file.size() > 5 && file.compare(file.size() - 5, 5, ".nfcd") == 0)
             {
-               if (frame.isPollFrame() || frame.isListenFrame())
+               if (writeFrames(file, config.contains("stream") && config["stream"]))
                {
-                  char buffer[4096];
-
-                  frame.reduce<int>(0, [&buffer](int offset, unsigned char value) {
-                     return offset + snprintf(buffer + offset, sizeof(buffer) - offset, offset > 0 ? ":%02X" : "%02X", value);
-                  });
-
-                  frames.push_back({
-                                         {"sampleStart", frame.sampleStart()},
-                                         {"sampleEnd",   frame.sampleEnd()},
-                                         {"timeStart",   frame.timeStart()},
-                                         {"timeEnd",     frame.timeEnd()},
-                                         {"techType",    frame.techType()},
-                                         {"frameType",   frame.frameType()},
-                                         {"frameRate",   frame.frameRate()},
-                                         {"frameFlags",  frame.frameFlags()},
-                                         {"framePhase",  frame.framePhase()},
-                                         {"frameData",   buffer}
-                                   });
+                  command.resolve();
+
+                  return;
                }
+
+               command.reject();
+
+               return;
             }
 
-            json info({{"frames", frames}});
+            nfc::JsonFrameWriter writer(file);
+
+            if (!writer.open())
+            {
+               command.reject();
+
+               return;
+            }
 
-            // create output file
-            std::ofstream output(file);
+            frameHistory.forEach([&writer](const nfc::NfcFrame &frame) {
+               if (frame.isPollFrame() || frame.isListenFrame())
+                  writer.append(frame);
+            });
 
-            // write prettified JSON to another file
-            output << std::setw(3) << info << std::endl;
+            writer.close();
+
+            log.info("written {} frames to file {}", {writer.count(), file});
 
             // confirm command execution
             command.resolve();
@@ -240,12 +238,123 @@ struct FrameStorageTask::Impl : FrameStorageTask, AbstractTask
       command.reject();
    }
 
+   void readFrames(const std::string &file)
+   {
+      nfc::FrameStore store(file);
+
+      if (store.open(nfc::FrameStore::Read))
+      {
+         for (long i = 0, count = store.count(); i < count; i++)
+         {
+            storageStream->next(store.frame(i));
+         }
+
+         log.info("readed {} frames from file {}", {store.count(), file});
+      }
+   }
+
+   bool writeFrames(const std::string &file, bool stream)
+   {
+      auto store = std::make_shared<nfc::FrameStore>(file);
+
+      if (!store->open(nfc::FrameStore::Write))
+         return false;
+
+      frameHistory.forEach([&store](const nfc::NfcFrame &frame) {
+         if (frame.isPollFrame() || frame.isListenFrame())
+            store->append(frame);
+      });
+
+      // keep file open to receive new frames
+      if (stream)
+      {
+         log.info("streaming frames to file {}", {file});
+
+         store->flush();
+
+         streamFile = store;
+
+         return true;
+      }
+
+      log.info("written {} frames to file {}", {store->count(), file});
+
+      store->close();
+
+      return true;
+   }
+
+   void storeFrames()
+   {
+      int appended = 0;
+
+      while (auto frame = frameQueue.get())
+      {
+         frameHistory.append(frame.value());
+
+         if (streamFile && (frame->isPollFrame() || frame->isListenFrame()))
+         {
+            streamFile->append(frame.value());
+
+            appended++;
+         }
+      }
+
+      // make new frames visible to readers
+      if (appended)
+         streamFile->flush();
+   }
+
+   void closeStream()
+   {
+      if (streamFile)
+      {
+         log.info("finished stream file {} with {} frames", {streamFile->path(), streamFile->count()});
+
+         streamFile->close();
+         streamFile.reset();
+      }
+   }
+
+   void configStorage(rt::Event &command)
+   {
+      if (auto data = command.get<std::string>("data"))
+      {
+         auto config = json::parse(data.value());
+
+         log.info("change storage config: {}", {config.dump()});
+
+         if (config.contains("memoryFrames"))
+            frameHistory.setMemoryFrames(config["memoryFrames"]);
+
+         if (config.contains("spoolPath"))
+            frameHistory.setSpoolPath(config["spoolPath"]);
+
+         if (config.contains("retentionFrames"))
+            frameHistory.setRetentionFrames(config["retentionFrames"]);
+
+         if (config.contains("retentionBytes"))
+            frameHistory.setRetentionBytes(config["retentionBytes"]);
+
+         if (config.contains("retentionAge"))
+            frameHistory.setRetentionAge(config["retentionAge"]);
+
+         command.resolve();
+
+         return;
+      }
+
+      command.reject();
+   }
+
    void clearQueue(rt::Event &event)
    {
       log.info("frame clearQueue");
 
       frameQueue.clear();
 
+      frameHistory.clear();
+
       event.resolve();
    }
 };
@@ -22,22 +22,20 @@
 
 */
 
-#if defined(__SSE2__) && defined(USE_SSE2)
-
-#include <x86intrin.h>
-
-#endif
-
+#include <cmath>
 #include <memory>
 
 #include <rt/Logger.h>
 #include <rt/Format.h>
 #include <rt/BlockingQueue.h>
 #include <rt/Throughput.h>
+#include <rt/Latency.h>
+#include <rt/BufferPool.h>
 
 #include <sdr/SignalType.h>
 #include <sdr/SignalBuffer.h>
 #include <sdr/DeviceFactory.h>
+#include <sdr/DeviceMonitor.h>
 
 #include <nfc/SignalReceiverTask.h>
 
@@ -48,52 +46,101 @@ namespace nfc {
 #define LOWER_GAIN_THRESHOLD 0.05
 #define UPPER_GAIN_THRESHOLD 0.25
 
+// receiver statistics interval
+#define STATUS_INTERVAL 5000
+
+// signal sampling stride for gain control
+#define GAIN_SAMPLE_STRIDE 64
+
 struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
 {
-   // radio device
-   std::shared_ptr<sdr::RadioDevice> receiver;
+   /*
+    * Radio device slot, each device streams from its own driver thread and publishes on indexed subjects
+    * signal.iq.N and signal.raw.N, first slot is also published on signal.iq and signal.raw
+    */
+   struct Receiver
+   {
+      // receiver index
+      int index = 0;
+
+      // radio device
+      std::shared_ptr<sdr::RadioDevice> device;
+
+      // signal stream subject for raw data
+      rt::Subject<sdr::SignalBuffer> *signalRvStream = nullptr;
+
+      // signal stream subject for IQ data
+      rt::Subject<sdr::SignalBuffer> *signalIqStream = nullptr;
+
+      // streaming requested for this device
+      bool streaming = false;
 
-   // signal stream subject for raw data
+      // current receiver gain mode
+      int gainMode = 0;
+
+      // current receiver gain value
+      int gainValue = 0;
+
+      // last control offset
+      unsigned int gainChange = 0;
+
+      // time from device capture to publish, since streaming started
+      rt::Latency publishLatency;
+   };
+
+   // radio devices
+   Receiver receivers[MaxReceivers];
+
+   // device discovery, driven by USB hotplug events
+   sdr::DeviceMonitor deviceMonitor;
+
+   // signal stream subject for raw data of first receiver
    rt::Subject<sdr::SignalBuffer> *signalRvStream = nullptr;
 
-   // signal stream subject for IQ data
+   // signal stream subject for IQ data of first receiver
    rt::Subject<sdr::SignalBuffer> *signalIqStream = nullptr;
 
-   // signal stream queue buffer
-   rt::BlockingQueue<sdr::SignalBuffer> signalQueue;
+   // signal stream queue buffer, tagged with receiver index
+   rt::BlockingQueue<std::pair<int, sdr::SignalBuffer>> signalQueue;
 
    // throughput meter
    rt::Throughput taskThroughput;
 
-   // last detection attempt
-   std::chrono::time_point<std::chrono::steady_clock> lastSearch;
-
-   // current receiver gain mode
-   int receiverGainMode = 0;
-
-   // current receiver gain value
-   int receiverGainValue = 0;
-
-   // last control offset
-   unsigned int receiverGainChange = 0;
+   // last statistics update
+   std::chrono::time_point<std::chrono::steady_clock> lastStatus;
 
    Impl() : AbstractTask("SignalReceiverTask", "receiver")
    {
       signalRvStream = rt::Subject<sdr::SignalBuffer>::name("signal.raw");
       signalIqStream = rt::Subject<sdr::SignalBuffer>::name("signal.iq");
+
+      for (int i = 0; i < MaxReceivers; i++)
+      {
+         receivers[i].index = i;
+         receivers[i].signalRvStream = rt::Subject<sdr::SignalBuffer>::name("signal.raw." + std::to_string(i));
+         receivers[i].signalIqStream = rt::Subject<sdr::SignalBuffer>::name("signal.iq." + std::to_string(i));
+      }
    }
 
    void start() override
    {
-      refresh();
+      discover();
+
+      if (!receivers[0].device)
+         updateReceiverStatus(SignalReceiverTask::Statistics);
+
+      lastStatus = std::chrono::steady_clock::now();
    }
 
    void stop() override
    {
-      if (receiver)
+      for (auto &receiver: receivers)
       {
-         log.info("shutdown device {}", {receiver->name()});
-         receiver.reset();
+         if (receiver.device)
+         {
+            log.info("shutdown device {}", {receiver.device->name()});
+            receiver.device.reset();
+         }
       }
 
       updateReceiverStatus(SignalReceiverTask::Halt);
@@ -127,15 +174,29 @@ struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
       }
 
       /*
-      * process device refresh
+      * process device attach / detach
+      */
+      discover();
+
+      /*
+      * process end of stream for devices that stopped by themselves
+      */
+      finish();
+
+      /*
+      * process receiver statistics
       */
-      if ((std::chrono::steady_clock::now() - lastSearch) > std::chrono::milliseconds(5000))
+      if ((std::chrono::steady_clock::now() - lastStatus) > std::chrono::milliseconds(STATUS_INTERVAL))
       {
          refresh();
 
-         if (receiver && receiver->isStreaming())
+         if (isStreaming())
          {
             log.info("average throughput {.2} Msps", {taskThroughput.average() / 1E6});
+
+            auto pool = rt::BufferPool::statistics();
+
+            log.debug("buffer pool hits {} misses {} discards {} idle {} KB", {pool.hits, pool.misses, pool.discards, pool.idleBytes / 1024});
          }
       }
 
@@ -144,105 +205,196 @@ struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
       return true;
    }
 
+   void discover()
+   {
+      int events = deviceMonitor.update([this](int event, const std::string &name) {
+         if (event == sdr::DeviceMonitor::Detach)
+         {
+            for (auto &receiver: receivers)
+            {
+               if (receiver.device && receiver.device->name() == name)
+                  closeReceiver(receiver);
+            }
+         }
+      });
+
+      // open new devices on bus changes
+      if (events > 0)
+         attach();
+   }
+
    void refresh()
    {
-      int mode = SignalReceiverTask::Statistics;
+      // retry devices already present that failed to open, without enumeration
+      attach();
 
-      if (!receiver)
+      for (auto &receiver: receivers)
       {
-         // open first available receiver
-         for (const auto &name: sdr::DeviceFactory::deviceList())
-         {
-            // create device instance
-            receiver.reset(sdr::DeviceFactory::newInstance(name));
+         if (receiver.device && !receiver.device->isReady())
+            closeReceiver(receiver);
+      }
 
-            if (receiver)
-            {
-               // default parameters for AirSpy
-               if (name.find("airspy") == 0)
-               {
-                  receiver->setCenterFreq(40.68E6);
-                  receiver->setSampleRate(10E6);
-                  receiver->setGainMode(1);
-                  receiver->setGainValue(3);
-                  receiver->setBiasTee(0);
-               }
-                  // default parameters for Rtl SDR
-               else if (name.find("rtlsdr") == 0)
-               {
-                  receiver->setCenterFreq(27.12E6);
-                  receiver->setSampleRate(3.2E6);
-                  receiver->setGainMode(1);
-                  receiver->setGainValue(77);
-               }
-                  // default parameters for others
-               else
-               {
-                  receiver->setCenterFreq(13.56E6);
-                  receiver->setSampleRate(10E6);
-                  receiver->setGainMode(0);
-                  receiver->setGainValue(0);
-               }
+      // update receiver status
+      updateReceiverStatus(SignalReceiverTask::Statistics);
 
-               receiver->setMixerAgc(0);
-               receiver->setTunerAgc(0);
-               receiver->setBiasTee(0);
-               receiver->setTestMode(0);
-               receiver->setDirectSampling(0);
+      // store last status time
+      lastStatus = std::chrono::steady_clock::now();
+   }
 
-               // try to open...
-               if (receiver->open(sdr::SignalDevice::Read))
-               {
-                  log.info("device {} connected!", {name});
+   void finish()
+   {
+      for (auto &receiver: receivers)
+      {
+         if (receiver.streaming && receiver.device && !receiver.device->isStreaming())
+         {
+            log.info("device {} finished streaming", {receiver.device->name()});
 
-                  mode = SignalReceiverTask::Attach;
+            receiver.streaming = false;
 
-                  break;
-               }
+            // queued after last device buffer, for EOF
+            signalQueue.add(receiver.index, sdr::SignalBuffer());
 
-               receiver.reset();
+            updateReceiverStatus(isStreaming() ? SignalReceiverTask::Streaming : SignalReceiverTask::Halt);
+         }
+      }
+   }
+
+   void attach()
+   {
+      for (const auto &name: deviceMonitor.deviceList())
+      {
+         Receiver *slot = nullptr;
 
-               log.warn("device {} open failed", {name});
+         for (auto &receiver: receivers)
+         {
+            // device already open
+            if (receiver.device && receiver.device->name() == name)
+            {
+               slot = nullptr;
+               break;
             }
+
+            if (!receiver.device && !slot)
+               slot = &receiver;
          }
+
+         if (slot && openReceiver(*slot, name))
+            updateReceiverStatus(SignalReceiverTask::Attach);
       }
-      else if (!receiver->isReady())
+   }
+
+   bool openReceiver(Receiver &receiver, const std::string &name)
+   {
+      // create device instance
+      receiver.device.reset(sdr::DeviceFactory::newInstance(name));
+
+      if (auto &device = receiver.device)
       {
-         log.warn("device {} disconnected", {receiver->name()});
+         // default parameters for AirSpy
+         if (name.find("airspy") == 0)
+         {
+            device->setCenterFreq(40.68E6);
+            device->setSampleRate(10E6);
+            device->setGainMode(1);
+            device->setGainValue(3);
+            device->setBiasTee(0);
+         }
+            // default parameters for Rtl SDR
+         else if (name.find("rtlsdr") == 0)
+         {
+            device->setCenterFreq(27.12E6);
+            device->setSampleRate(3.2E6);
+            device->setGainMode(1);
+            device->setGainValue(77);
+         }
+            // simulated device, sample rate is given in device name
+         else if (name.find("sim") == 0)
+         {
+            device->setCenterFreq(13.56E6);
+            device->setGainMode(1);
+            device->setGainValue(0);
+         }
+            // default parameters for others
+         else
+         {
+            device->setCenterFreq(13.56E6);
+            device->setSampleRate(10E6);
+            device->setGainMode(0);
+            device->setGainValue(0);
+         }
+
+         device->setMixerAgc(0);
+         device->setTunerAgc(0);
+         device->setBiasTee(0);
+         device->setTestMode(0);
+         device->setDirectSampling(0);
+
+         // try to open...
+         if (device->open(sdr::SignalDevice::Read))
+         {
+            log.info("device {} connected as receiver {}!", {name, receiver.index});
 
-         // send null buffer for EOF
-         signalIqStream->next({});
+            receiver.streaming = false;
+            receiver.gainMode = 0;
+            receiver.gainValue = 0;
 
-         // send null buffer for EOF
-         signalRvStream->next({});
+            return true;
+         }
+
+         device.reset();
 
-         // close device
-         receiver.reset();
+         log.warn("device {} open failed", {name});
       }
 
-      // update receiver status
-      updateReceiverStatus(mode);
+      return false;
+   }
+
+   void closeReceiver(Receiver &receiver)
+   {
+      log.warn("device {} disconnected", {receiver.device->name()});
+
+      // close device, no more buffers are queued after this
+      receiver.device.reset();
+      receiver.streaming = false;
+
+      // send null buffer for EOF
+      signalQueue.add(receiver.index, sdr::SignalBuffer());
 
-      // store last search time
-      lastSearch = std::chrono::steady_clock::now();
+      // notify immediately
+      updateReceiverStatus(SignalReceiverTask::Detach);
    }
 
    void startReceiver(const rt::Event &command)
    {
-      if (receiver)
+      bool started = false;
+
+      for (auto &receiver: receivers)
       {
-         log.info("start streaming for device {}", {receiver->name()});
+         if (receiver.device)
+         {
+            log.info("start streaming for device {}", {receiver.device->name()});
 
-         // read current gain mode and value
-         receiverGainChange = 0;
+            // read current gain mode and value
+            receiver.gainChange = 0;
 
-         log.info("gain mode {} gain value {}", {receiverGainMode, receiverGainValue});
+            receiver.publishLatency.clear();
 
-         // start receiving
-         receiver->start([this](sdr::SignalBuffer &buffer) {
-            signalQueue.add(buffer);
-         });
+            log.info("gain mode {} gain value {}", {receiver.gainMode, receiver.gainValue});
+
+            // start receiving, buffers are tagged with receiver index
+            // magnitude is not requested, decoder demodulates I/Q samples directly
+            receiver.device->start([this, index = receiver.index](sdr::SignalBuffer &buffer) {
+               signalQueue.add(index, buffer);
+            });
+
+            receiver.streaming = true;
+
+            started = true;
+         }
+      }
 
+      if (started)
+      {
          command.resolve();
 
          updateReceiverStatus(SignalReceiverTask::Streaming);
@@ -251,12 +403,24 @@ struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
 
    void stopReceiver(const rt::Event &command)
    {
-      if (receiver)
+      bool stopped = false;
+
+      for (auto &receiver: receivers)
       {
-         log.info("stop streaming for device {}", {receiver->name()});
+         if (receiver.device)
+         {
+            log.info("stop streaming for device {}", {receiver.device->name()});
+
+            receiver.device->stop();
+
+            receiver.streaming = false;
 
-         receiver->stop();
+            stopped = true;
+         }
+      }
 
+      if (stopped)
+      {
          command.resolve();
 
          updateReceiverStatus(SignalReceiverTask::Halt);
@@ -265,9 +429,9 @@ struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
 
    void queryReceiver(const rt::Event &command)
    {
-      if (receiver)
+      if (receivers[0].device)
       {
-         log.info("query status for device {}", {receiver->name()});
+         log.info("query status for device {}", {receivers[0].device->name()});
 
          command.resolve();
 
@@ -277,53 +441,63 @@ struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
 
    void configReceiver(const rt::Event &command)
    {
-      if (receiver)
+      if (auto data = command.get<std::string>("data"))
       {
-         if (auto data = command.get<std::string>("data"))
+         auto config = json::parse(data.value());
+
+         // target receiver, first one by default
+         int index = config.contains("index") ? config["index"].get<int>() : 0;
+
+         if (index >= 0 && index < MaxReceivers && receivers[index].device)
          {
-            auto config = json::parse(data.value());
+            Receiver &receiver = receivers[index];
 
-            log.info("change receiver config {}: {}", {receiver->name(), config.dump()});
+            auto &device = receiver.device;
+
+            log.info("change receiver config {}: {}", {device->name(), config.dump()});
 
             if (config.contains("centerFreq"))
-               receiver->setCenterFreq(config["centerFreq"]);
+               device->setCenterFreq(config["centerFreq"]);
 
             if (config.contains("sampleRate"))
-               receiver->setSampleRate(config["sampleRate"]);
+               device->setSampleRate(config["sampleRate"]);
+
+            if (config.contains("sampleType"))
+               device->setSampleType(config["sampleType"]);
 
             if (config.contains("tunerAgc"))
-               receiver->setTunerAgc(config["tunerAgc"]);
+               device->setTunerAgc(config["tunerAgc"]);
 
             if (config.contains("mixerAgc"))
-               receiver->setMixerAgc(config["mixerAgc"]);
+               device->setMixerAgc(config["mixerAgc"]);
 
             if (config.contains("biasTee"))
-               receiver->setBiasTee(config["biasTee"]);
+               device->setBiasTee(config["biasTee"]);
 
             if (config.contains("directSampling"))
-               receiver->setDirectSampling(config["directSampling"]);
+               device->setDirectSampling(config["directSampling"]);
 
             if (config.contains("gainMode"))
             {
-               receiverGainMode = config["gainMode"];
+               receiver.gainMode = config["gainMode"];
 
-               if (receiverGainMode > 0)
+               if (receiver.gainMode > 0)
                {
-                  receiver->setGainMode(receiverGainMode);
+                  device->setGainMode(receiver.gainMode);
                }
                else
                {
-                  receiverGainValue = 0;
-                  receiver->setGainMode(1);
-                  receiver->setGainValue(receiverGainValue);
+                  receiver.gainValue = 0;
+                  device->setGainMode(1);
+                  device->setGainValue(receiver.gainValue);
                }
             }
 
             if (config.contains("gainValue"))
             {
-               receiverGainMode = 1;
-               receiverGainValue = config["gainValue"];
-               receiver->setGainValue(receiverGainValue);
+               receiver.gainMode = 1;
+               receiver.gainValue = config["gainValue"];
+               device->setGainValue(receiver.gainValue);
             }
          }
       }
@@ -333,31 +507,69 @@ struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
       updateReceiverStatus(SignalReceiverTask::Config);
    }
 
+   bool isStreaming() const
+   {
+      for (const auto &receiver: receivers)
+      {
+         if (receiver.device && receiver.device->isStreaming())
+            return true;
+      }
+
+      return false;
+   }
+
    void updateReceiverStatus(int event)
+   {
+      // first receiver status in top level for single device clients
+      json data = receiverStatus(receivers[0], event);
+
+      // status of all receivers
+      for (const auto &receiver: receivers)
+      {
+         if (receiver.device)
+         {
+            json entry = receiverStatus(receiver, event);
+
+            entry["index"] = receiver.index;
+
+            data["receivers"].push_back(entry);
+         }
+      }
+
+      log.info("updated receiver status: {}", {data.dump()});
+
+      updateStatus(event, data);
+   }
+
+   static json receiverStatus(const Receiver &receiver, int event)
    {
       json data;
 
-      if (receiver)
+      if (auto &device = receiver.device)
       {
          // data name and status
-         data["name"] = receiver->name();
-         data["version"] = receiver->version();
-         data["status"] = receiver->isStreaming() ? "streaming" : "idle";
+         data["name"] = device->name();
+         data["version"] = device->version();
+         data["status"] = device->isStreaming() ? "streaming" : "idle";
 
          // data parameters
-         data["centerFreq"] = receiver->centerFreq();
-         data["sampleRate"] = receiver->sampleRate();
-         data["streamTime"] = receiver->streamTime();
-         data["gainMode"] = receiver->gainMode();
-         data["gainValue"] = receiver->gainValue();
-         data["mixerAgc"] = receiver->mixerAgc();
-         data["tunerAgc"] = receiver->tunerAgc();
-         data["biasTee"] = receiver->biasTee();
-         data["directSampling"] = receiver->directSampling();
+         data["centerFreq"] = device->centerFreq();
+         data["sampleRate"] = device->sampleRate();
+         data["sampleType"] = device->sampleType();
+         data["streamTime"] = device->streamTime();
+         data["gainMode"] = device->gainMode();
+         data["gainValue"] = device->gainValue();
+         data["mixerAgc"] = device->mixerAgc();
+         data["tunerAgc"] = device->tunerAgc();
+         data["biasTee"] = device->biasTee();
+         data["directSampling"] = device->directSampling();
 
          // data statistics
-         data["samplesReceived"] = receiver->samplesReceived();
-         data["samplesDropped"] = receiver->samplesDropped();
+         data["samplesReceived"] = device->samplesReceived();
+         data["samplesDropped"] = device->samplesDropped();
+         data["latency"] = {
+               {"publish", latencyStatus(receiver.publishLatency)}
+         };
 
          // send capabilities on data attach
          if (event == SignalReceiverTask::Attach)
@@ -367,7 +579,7 @@ struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
                                               {"name",  "Auto"}
                                         });
 
-            for (const auto &entry: receiver->supportedGainModes())
+            for (const auto &entry: device->supportedGainModes())
             {
                if (entry.first > 0)
                {
@@ -378,7 +590,7 @@ struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
                }
             }
 
-            for (const auto &entry: receiver->supportedGainValues())
+            for (const auto &entry: device->supportedGainValues())
             {
                data["gainValues"].push_back({
                                                   {"value", entry.first},
@@ -386,7 +598,7 @@ struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
                                             });
             }
 
-            for (const auto &entry: receiver->supportedSampleRates())
+            for (const auto &entry: device->supportedSampleRates())
             {
                data["sampleRates"].push_back({
                                                    {"value", entry.first},
@@ -400,127 +612,95 @@ struct SignalReceiverTask::Impl : SignalReceiverTask, AbstractTask
          data["status"] = "absent";
       }
 
-      log.info("updated receiver status: {}", {data.dump()});
-
-      updateStatus(event, data);
+      return data;
    }
 
    void processQueue(int timeout)
    {
       if (auto entry = signalQueue.get(timeout))
       {
-         sdr::SignalBuffer buffer = entry.value();
-         sdr::SignalBuffer result(buffer.elements(), 1, buffer.sampleRate(), buffer.offset(), 0, sdr::SignalType::SAMPLE_REAL);
+         Receiver &receiver = receivers[entry->first];
 
-         float *src = buffer.data();
-         float *dst = result.pull(buffer.elements());
-         float avrg = 0;
+         sdr::SignalBuffer buffer = entry->second;
 
-         taskThroughput.begin();
-
-         // compute real signal value and average value
-#if defined(__SSE2__) && defined(USE_SSE2)
-         for (int j = 0, n = 0; j < buffer.elements(); j += 16, n += 32)
+         // null buffer for EOF, no gain control
+         if (!buffer.isValid())
          {
-            // load 16 I/Q vectors
-            __m128 a0 = _mm_load_ps(src + n + 0);  // I0, Q0, I1, Q1
-            __m128 a1 = _mm_load_ps(src + n + 4);  // I2, Q2, I3, Q3
-            __m128 a2 = _mm_load_ps(src + n + 8);  // I4, Q4, I5, Q5
-            __m128 a3 = _mm_load_ps(src + n + 12); // I6, Q6, I7, Q7
-            __m128 a4 = _mm_load_ps(src + n + 16);  // I8, Q8, I9, Q9
-            __m128 a5 = _mm_load_ps(src + n + 20); // I10, Q10, I11, Q11
-            __m128 a6 = _mm_load_ps(src + n + 24);  // I12, Q12, I13, Q13
-            __m128 a7 = _mm_load_ps(src + n + 28); // I14, Q14, I15, Q15
-
-            // square all components
-            __m128 p0 = _mm_mul_ps(a0, a0); // I0^2, Q0^2, I1^2, Q1^2
-            __m128 p1 = _mm_mul_ps(a1, a1); // I2^2, Q2^2, I3^2, Q3^2
-            __m128 p2 = _mm_mul_ps(a2, a2); // I4^2, Q4^2, I5^2, Q5^2
-            __m128 p3 = _mm_mul_ps(a3, a3); // I6^2, Q6^2, I7^2, Q7^2
-            __m128 p4 = _mm_mul_ps(a4, a4); // I8^2, Q8^2, I9^2, Q9^2
-            __m128 p5 = _mm_mul_ps(a5, a5); // I10^2, Q10^2, I11^2, Q11^2
-            __m128 p6 = _mm_mul_ps(a6, a6); // I12^2, Q12^2, I13^2, Q13^2
-            __m128 p7 = _mm_mul_ps(a7, a7); // I14^2, Q14^2, I15^2, Q15^2
-
-            // permute components
-            __m128 i0 = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(2, 0, 2, 0)); // I0^2, I1^2, I2^2, I3^2
-            __m128 i1 = _mm_shuffle_ps(p2, p3, _MM_SHUFFLE(2, 0, 2, 0)); // I4^2, I5^2, I6^2, I7^2
-            __m128 i2 = _mm_shuffle_ps(p4, p5, _MM_SHUFFLE(2, 0, 2, 0)); // I8^2, I9^2, I10^2, I11^2
-            __m128 i3 = _mm_shuffle_ps(p6, p7, _MM_SHUFFLE(2, 0, 2, 0)); // I12^2, I13^2, I14^2, I15^2
-            __m128 q0 = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(3, 1, 3, 1)); // Q0^2, Q1^2, Q2^2, Q3^2
-            __m128 q1 = _mm_shuffle_ps(p2, p3, _MM_SHUFFLE(3, 1, 3, 1)); // Q4^2, Q5^2, Q6^2, Q7^2
-            __m128 q2 = _mm_shuffle_ps(p4, p5, _MM_SHUFFLE(3, 1, 3, 1)); // Q8^2, Q9^2, Q10^2, Q11^2
-            __m128 q3 = _mm_shuffle_ps(p6, p7, _MM_SHUFFLE(3, 1, 3, 1)); // Q12^2, Q13^2, Q14^2, Q15^2
-
-            // add vector components
-            __m128 r0 = _mm_add_ps(i0, q0); // I0^2+Q0^2, I1^2+Q1^2, I2^2+Q2^2, I3^2+Q3^2
-            __m128 r1 = _mm_add_ps(i1, q1); // I4^2+Q4^2, I5^2+Q5^2, I6^2+Q6^2, I7^2+Q7^2
-            __m128 r2 = _mm_add_ps(i2, q2); // I8^2+Q8^2, I9^2+Q1^2, I10^2+Q10^2, I11^2+Q11^2
-            __m128 r3 = _mm_add_ps(i3, q3); // I12^2+Q12^2, I13^2+Q13^2, I14^2+Q14^2, I15^2+Q15^2
-
-            // square-root vectors
-            __m128 m0 = _mm_sqrt_ps(r0); // sqrt(I0^2+Q0^2), sqrt(I1^2+Q1^2), sqrt(I2^2+Q2^2), sqrt(I3^2+Q3^2)
-            __m128 m1 = _mm_sqrt_ps(r1); // sqrt(I4^2+Q4^2), sqrt(I5^2+Q5^2), sqrt(I6^2+Q6^2), sqrt(I7^2+Q7^2)
-            __m128 m2 = _mm_sqrt_ps(r2); // sqrt(I8^2+Q8^2), sqrt(I9^2+Q9^2), sqrt(I10^2+Q10^2), sqrt(I11^2+Q11^2)
-            __m128 m3 = _mm_sqrt_ps(r3); // sqrt(I12^2+Q12^2), sqrt(I13^2+Q13^2), sqrt(I14^2+Q14^2), sqrt(I15^2+Q15^2)
-
-            // store results
-            _mm_store_ps(dst + j + 0, m0);
-            _mm_store_ps(dst + j + 4, m1);
-            _mm_store_ps(dst + j + 8, m2);
-            _mm_store_ps(dst + j + 12, m3);
-
-            // compute exponential average
-            avrg = avrg * (1 - 0.001f) + dst[j + 0] * 0.001f;
-            avrg = avrg * (1 - 0.001f) + dst[j + 4] * 0.001f;
-            avrg = avrg * (1 - 0.001f) + dst[j + 8] * 0.001f;
-            avrg = avrg * (1 - 0.001f) + dst[j + 12] * 0.001f;
+            publish(receiver, buffer);
+            return;
          }
-#else
-#pragma GCC ivdep
-         for (int j = 0, n = 0; j < buffer.elements(); j += 4, n += 8)
-         {
-            dst[j + 0] = sqrtf(src[n + 0] * src[n + 0] + src[n + 1] * src[n + 1]);
-            dst[j + 1] = sqrtf(src[n + 2] * src[n + 2] + src[n + 3] * src[n + 3]);
-            dst[j + 2] = sqrtf(src[n + 4] * src[n + 4] + src[n + 5] * src[n + 5]);
-            dst[j + 3] = sqrtf(src[n + 6] * src[n + 6] + src[n + 7] * src[n + 7]);
 
-            avrg = avrg * (1 - 0.001f) + dst[j + 0] * 0.001f;
-         }
-#endif
+         taskThroughput.begin();
+
+         // signal average for gain control, from sparse samples
+         float avrg = computeAverage(buffer);
 
          taskThroughput.update(buffer.elements());
 
-         // flip buffer pointers
-         result.flip();
+         // trace publish time before any subscriber can see the buffer
+         buffer.setPublishTime(rt::Latency::now());
 
-         // send IQ value buffer
-         signalIqStream->next(buffer);
+         receiver.publishLatency.update(buffer.captureTime(), buffer.publishTime());
 
-         // send Real value buffer
-         signalRvStream->next(result);
+         // send same buffer to IQ and raw subscribers, magnitude is computed by subscribers that need it
+         publish(receiver, buffer);
 
          // if automatic gain control is engaged adjust gain dynamically
-         if (receiverGainMode == 0 && buffer.offset() > receiverGainChange)
+         if (receiver.device && receiver.gainMode == 0 && buffer.offset() > receiver.gainChange)
          {
             // for weak signals, increase receiver gain
-            if (avrg < LOWER_GAIN_THRESHOLD && receiverGainValue < 6)
+            if (avrg < LOWER_GAIN_THRESHOLD && receiver.gainValue < 6)
             {
-               receiverGainChange = buffer.offset() + buffer.elements();
-               receiver->setGainValue(++receiverGainValue);
-               log.info("increase gain {}", {receiverGainValue});
+               receiver.gainChange = buffer.offset() + buffer.elements();
+               receiver.device->setGainValue(++receiver.gainValue);
+               log.info("increase gain {} for receiver {}", {receiver.gainValue, receiver.index});
             }
 
             // for strong signals, decrease receiver gain
-            if (avrg > UPPER_GAIN_THRESHOLD && receiverGainValue > 0)
+            if (avrg > UPPER_GAIN_THRESHOLD && receiver.gainValue > 0)
             {
-               receiverGainChange = buffer.offset() + buffer.elements();
-               receiver->setGainValue(--receiverGainValue);
-               log.info("decrease gain {}", {receiverGainValue});
+               receiver.gainChange = buffer.offset() + buffer.elements();
+               receiver.device->setGainValue(--receiver.gainValue);
+               log.info("decrease gain {} for receiver {}", {receiver.gainValue, receiver.index});
             }
          }
       }
    }
+
+   void publish(const Receiver &receiver, const sdr::SignalBuffer &buffer)
+   {
+      // send IQ value buffer
+      receiver.signalIqStream->next(buffer);
+
+      // send raw buffer to decoder
+      receiver.signalRvStream->next(buffer);
+
+      // first receiver feeds single device subscribers
+      if (receiver.index == 0)
+      {
+         signalIqStream->next(buffer);
+         signalRvStream->next(buffer);
+      }
+   }
+
+   /*
+    * compute signal average from one of each GAIN_SAMPLE_STRIDE samples
+    */
+   static float computeAverage(const sdr::SignalBuffer &buffer)
+   {
+      const float *src = buffer.data();
+
+      float avrg = 0;
+
+      for (int j = 0; j < buffer.elements(); j += GAIN_SAMPLE_STRIDE)
+      {
+         float value = buffer.stride() == 2 ? std::sqrt(src[j * 2] * src[j * 2] + src[j * 2 + 1] * src[j * 2 + 1]) : std::fabs(src[j]);
+
+         avrg = avrg * (1 - 0.001f * GAIN_SAMPLE_STRIDE / 4) + value * (0.001f * GAIN_SAMPLE_STRIDE / 4);
+      }
+
+      return avrg;
+   }
 };
 
 SignalReceiverTask::SignalReceiverTask() : rt::Worker("SignalReceiverTask")
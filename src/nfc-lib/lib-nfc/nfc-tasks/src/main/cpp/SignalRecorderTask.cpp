@@ -22,22 +22,26 @@
 
 */
 
-#if defined(__SSE2__) && defined(USE_SSE2)
-
-#include <x86intrin.h>
-
-#endif
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 
 #include <rt/Logger.h>
 
 #include <sdr/SignalType.h>
 #include <sdr/SignalBuffer.h>
+#include <sdr/SignalKernel.h>
 #include <sdr/RecordDevice.h>
+#include <sdr/RecordIndex.h>
 
 #include <nfc/SignalRecorderTask.h>
 
 #include "AbstractTask.h"
 
+// default buffers read ahead of publish position
+#define PREFETCH_BUFFERS 8
+
 namespace nfc {
 
 struct SignalRecorderTask::Impl : SignalRecorderTask, AbstractTask
@@ -62,6 +66,42 @@ struct SignalRecorderTask::Impl : SignalRecorderTask, AbstractTask
    // record device
    std::shared_ptr<sdr::RecordDevice> device;
 
+   // skip file blocks without carrier while reading
+   bool skipIdle = false;
+
+   // replay speed factor over real time, zero for maximum speed
+   double replaySpeed = 1.0;
+
+   // buffers read from file pending to be published
+   struct PrefetchBlock
+   {
+      sdr::SignalBuffer iq;
+      sdr::SignalBuffer real;
+
+      // first sample, per channel, buffer offset is only 32 bits wide
+      long long offset;
+   };
+
+   // prefetch thread and buffers pending to be published
+   std::thread prefetchThread;
+   std::mutex prefetchMutex;
+   std::condition_variable prefetchSync;
+   std::deque<PrefetchBlock> prefetchBuffers;
+   unsigned int prefetchDepth = PREFETCH_BUFFERS;
+   bool prefetchRunning = false;
+   bool prefetchFinished = false;
+
+   // wall clock time and sample offset for first replayed buffer
+   std::chrono::time_point<std::chrono::steady_clock> replayStart;
+   long long replayOrigin = -1;
+
+   // next sample to publish, per channel
+   long long publishOffset = 0;
+
+   // delay of last replayed buffer against wall clock
+   double replayLag = 0;
+   double replayMaxLag = 0;
+
    Impl() : AbstractTask("SignalRecorderTask", "recorder"), status(SignalRecorderTask::Idle)
    {
       // access to signal subject stream
@@ -147,10 +187,10 @@ struct SignalRecorderTask::Impl : SignalRecorderTask, AbstractTask
       /*
       * update recorder status
       */
-//      if ((std::chrono::steady_clock::now() - lastStatus) > std::chrono::milliseconds(500))
-//      {
-//         updateRecorderStatus();
-//      }
+      if (status == SignalRecorderTask::Writing && (std::chrono::steady_clock::now() - lastStatus) > std::chrono::milliseconds(1000))
+      {
+         updateRecorderStatus(status);
+      }
 
       return true;
    }
@@ -163,41 +203,17 @@ struct SignalRecorderTask::Impl : SignalRecorderTask, AbstractTask
 
          log.info("read file command: {}", {config.dump()});
 
-         if (config.contains("fileName"))
+         if (openFile(config))
          {
-            device = std::make_shared<sdr::RecordDevice>(config["fileName"]);
+            startPrefetch();
 
-            signalQueue.clear();
-
-            if (device->open(sdr::SignalDevice::Read))
-            {
-               if (device->channelCount() <= 2)
-               {
-                  log.info("streaming started for file [{}]", {device->name()});
+            log.info("streaming started for file [{}]", {device->name()});
 
-                  command.resolve();
+            command.resolve();
 
-                  updateRecorderStatus(SignalRecorderTask::Reading);
-
-                  return;
-               }
-               else
-               {
-                  log.warn("too many channels in file [{}]", {device->name()});
-
-                  device.reset();
-               }
-            }
-            else
-            {
-               log.warn("unable to open file [{}]", {device->name()});
+            updateRecorderStatus(SignalRecorderTask::Reading);
 
-               device.reset();
-            }
-         }
-         else
-         {
-            log.info("recording failed, no file name");
+            return;
          }
       }
       else
@@ -210,6 +226,51 @@ struct SignalRecorderTask::Impl : SignalRecorderTask, AbstractTask
       updateRecorderStatus(SignalRecorderTask::Idle);
    }
 
+   bool openFile(const json &config)
+   {
+      if (!config.contains("fileName"))
+      {
+         log.info("recording failed, no file name");
+
+         return false;
+      }
+
+      close();
+
+      device = std::make_shared<sdr::RecordDevice>(config["fileName"]);
+
+      signalQueue.clear();
+
+      if (!device->open(sdr::SignalDevice::Read))
+      {
+         log.warn("unable to open file [{}]", {device->name()});
+
+         device.reset();
+
+         return false;
+      }
+
+      if (device->channelCount() > 2)
+      {
+         log.warn("too many channels in file [{}]", {device->name()});
+
+         device.reset();
+
+         return false;
+      }
+
+      skipIdle = config.contains("skipIdle") && config["skipIdle"].get<bool>();
+
+      // number of buffers read ahead
+      prefetchDepth = config.contains("prefetch") ? std::max(1, config["prefetch"].get<int>()) : PREFETCH_BUFFERS;
+
+      // start reading from given time
+      if (config.contains("startTime") && device->seekTime(config["startTime"].get<double>()) != 0)
+         log.warn("invalid start time {} for file [{}]", {config["startTime"].get<double>(), device->name()});
+
+      return true;
+   }
+
    void writeFile(const rt::Event &command)
    {
       if (auto data = command.get<std::string>("data"))
@@ -220,6 +281,9 @@ struct SignalRecorderTask::Impl : SignalRecorderTask, AbstractTask
 
          if (config.contains("fileName"))
          {
+            // stop replay prefetch thread before device is replaced
+            close();
+
             device = std::make_shared<sdr::RecordDevice>(config["fileName"]);
 
             if (config.contains("sampleRate"))
@@ -284,147 +348,310 @@ struct SignalRecorderTask::Impl : SignalRecorderTask, AbstractTask
 
    void startReplay(const rt::Event &command)
    {
-      command.resolve();
+      if (auto data = command.get<std::string>("data"))
+      {
+         auto config = json::parse(data.value());
+
+         log.info("replay file command: {}", {config.dump()});
+
+         if (openFile(config))
+         {
+            replaySpeed = config.contains("speed") ? config["speed"].get<double>() : 1.0;
+
+            startPrefetch();
+
+            log.info("replay started for file [{}] at speed {}", {device->name(), replaySpeed});
+
+            command.resolve();
+
+            updateRecorderStatus(SignalRecorderTask::Replaying);
+
+            return;
+         }
+      }
+      else
+      {
+         log.info("replay failed, invalid command data");
+      }
 
-      updateRecorderStatus(SignalRecorderTask::Replaying);
+      command.reject();
+
+      updateRecorderStatus(SignalRecorderTask::Idle);
    }
 
    void signalRead()
    {
-      if (device && device->isOpen())
+      // buffers are published as soon as prefetch thread reads them
+      signalPublish(false);
+   }
+
+   /*
+    * Read next block from device, IQ files produce same buffer for both streams, returns false if no samples readed
+    */
+   bool readBlock(PrefetchBlock &block)
+   {
+      // jump to next block with carrier using file index
+      if (skipIdle)
       {
-         int sampleRate = device->sampleRate();
-         int channelCount = device->channelCount();
-         int sampleOffset = device->sampleOffset();
+         long long current = device->sampleOffset() / device->channelCount();
+         long long next = device->index().nextCarrier(current);
 
-         switch (channelCount)
+         if (next < 0)
+            device->seek(device->sampleCount());
+         else if (next > current)
+            device->seek(next);
+      }
+
+      int sampleRate = device->sampleRate();
+      int channelCount = device->channelCount();
+      long long sampleOffset = device->sampleOffset();
+
+      switch (channelCount)
+      {
+         case 1:
          {
-            case 1:
+            sdr::SignalBuffer buffer(65536 * channelCount, 1, sampleRate, sampleOffset, 0, sdr::SignalType::SAMPLE_REAL);
+
+            if (device->read(buffer) > 0)
             {
-               sdr::SignalBuffer buffer(65536 * channelCount, 1, sampleRate, sampleOffset, 0, sdr::SignalType::SAMPLE_REAL);
+               block.real = buffer;
+               block.offset = sampleOffset;
 
-               if (device->read(buffer) > 0)
-               {
-                  signalRvStream->next(buffer);
-               }
+               return true;
+            }
 
-               break;
+            break;
+         }
+         case 2:
+         {
+            sdr::SignalBuffer buffer(65536 * channelCount, 2, sampleRate, sampleOffset >> 1, 0, sdr::SignalType::SAMPLE_IQ);
+
+            // same I/Q buffer is sent to decoder, magnitude is computed by subscribers that need it
+            if (device->read(buffer) > 0)
+            {
+               block.iq = buffer;
+               block.real = buffer;
+               block.offset = sampleOffset >> 1;
+
+               return true;
             }
-            case 2:
+
+            break;
+         }
+
+         default:
+         {
+            device->close();
+         }
+      }
+
+      return false;
+   }
+
+   void signalWrite()
+   {
+      if (device && device->isOpen())
+      {
+         // drain all pending buffers, conversion is done here and file writes from device I/O thread
+         while (auto buffer = signalQueue.get(50))
+         {
+            if (!buffer->isEmpty())
             {
-               sdr::SignalBuffer buffer(65536 * channelCount, 2, sampleRate, sampleOffset >> 1, 0, sdr::SignalType::SAMPLE_IQ);
+               // I/Q samples stored as magnitude for single channel recordings
+               if (buffer->type() == sdr::SignalType::SAMPLE_IQ && device->channelCount() == 1)
+               {
+                  sdr::SignalBuffer magnitude = sdr::SignalKernel::magnitude(buffer.value());
 
-               if (device->read(buffer) > 0)
+                  device->write(magnitude);
+               }
+               else
                {
-                  sdr::SignalBuffer result(buffer.elements(), 1, buffer.sampleRate(), buffer.offset(), 0, sdr::SignalType::SAMPLE_REAL);
-
-                  float *src = buffer.data();
-                  float *dst = result.pull(buffer.elements());
-
-                  // compute real signal value
-#if defined(__SSE2__) && defined(USE_SSE2)
-                  for (int j = 0, n = 0; j < buffer.elements(); j += 8, n += 16)
-                  {
-                     // load 8 I/Q vectors
-                     __m128 a1 = _mm_load_ps(src + n + 0);  // I0, Q0, I1, Q1
-                     __m128 a2 = _mm_load_ps(src + n + 4);  // I2, Q2, I3, Q3
-                     __m128 a3 = _mm_load_ps(src + n + 8);  // I4, Q4, I5, Q5
-                     __m128 a4 = _mm_load_ps(src + n + 12); // I6, Q6, I7, Q7
-
-                     // square all components
-                     __m128 p1 = _mm_mul_ps(a1, a1); // I0^2, Q0^2, I1^2, Q1^2
-                     __m128 p2 = _mm_mul_ps(a2, a2); // I2^2, Q2^2, I3^2, Q3^2
-                     __m128 p3 = _mm_mul_ps(a3, a3); // I4^2, Q4^2, I5^2, Q5^2
-                     __m128 p4 = _mm_mul_ps(a4, a4); // I6^2, Q6^2, I6^2, Q7^2
-
-                     // permute components
-                     __m128 i1 = _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(2, 0, 2, 0)); // I0^2, I1^2, I2^2, I3^2
-                     __m128 i2 = _mm_shuffle_ps(p3, p4, _MM_SHUFFLE(2, 0, 2, 0)); // I4^2, I5^2, I6^2, I7^2
-                     __m128 q1 = _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(3, 1, 3, 1)); // Q0^2, Q1^2, Q2^2, Q3^2
-                     __m128 q2 = _mm_shuffle_ps(p3, p4, _MM_SHUFFLE(3, 1, 3, 1)); // Q4^2, Q5^2, Q6^2, Q7^2
-
-                     // add vector components
-                     __m128 r1 = _mm_add_ps(i1, q1); // I0^2+Q0^2, I1^2+Q1^2, I2^2+Q2^2, I3^2+Q3^2
-                     __m128 r2 = _mm_add_ps(i2, q2); // I4^2+Q4^2, I5^2+Q5^2, I6^2+Q6^2, I7^2+Q7^2
-
-                     // square-root vectors
-                     __m128 m1 = _mm_sqrt_ps(r1); // sqrt(I0^2+Q0^2), sqrt(I1^2+Q1^2), sqrt(I2^2+Q2^2), sqrt(I3^2+Q3^2)
-                     __m128 m2 = _mm_sqrt_ps(r2); // sqrt(I4^2+Q4^2), sqrt(I5^2+Q5^2), sqrt(I6^2+Q6^2), sqrt(I7^2+Q7^2)
-
-                     // store results
-                     _mm_store_ps(dst + j + 0, m1);
-                     _mm_store_ps(dst + j + 4, m2);
-                  }
-#else
-#pragma GCC ivdep
-                  for (int j = 0, n = 0; j < buffer.elements(); j += 4, n += 8)
-                  {
-                     dst[j + 0] = sqrtf(src[n + 0] * src[n + 0] + src[n + 1] * src[n + 1]);
-                     dst[j + 1] = sqrtf(src[n + 2] * src[n + 2] + src[n + 3] * src[n + 3]);
-                     dst[j + 2] = sqrtf(src[n + 4] * src[n + 4] + src[n + 5] * src[n + 5]);
-                     dst[j + 3] = sqrtf(src[n + 6] * src[n + 6] + src[n + 7] * src[n + 7]);
-                  }
-#endif
-                  // flip buffer pointers
-                  result.flip();
-
-                  // send IQ value buffer
-                  signalIqStream->next(buffer);
-
-                  // send Real value buffer
-                  signalRvStream->next(result);
+                  device->write(buffer.value());
                }
+            }
 
+            if (signalQueue.size() == 0)
                break;
-            }
+         }
 
-            default:
-            {
-               device->close();
-            }
+         if (!device->isReady())
+         {
+            log.warn("recording failed for file [{}]", {device->name()});
+
+            close();
+
+            updateRecorderStatus(SignalRecorderTask::Idle);
          }
+      }
+   }
 
-         if (device->isEof() || !device->isOpen())
+   void signalCapture()
+   {
+   }
+
+   void signalReplay()
+   {
+      signalPublish(replaySpeed > 0);
+   }
+
+   /*
+    * Publish next prefetched buffer, when paced waits until wall clock reaches its end time scaled by replay speed
+    */
+   void signalPublish(bool paced)
+   {
+      std::unique_lock<std::mutex> lock(prefetchMutex);
+
+      if (prefetchBuffers.empty())
+      {
+         if (prefetchFinished)
          {
-            log.info("streaming finished for file [{}]", {device->name()});
+            lock.unlock();
+
+            if (status == SignalRecorderTask::Replaying)
+               log.info("replay finished for file [{}], maximum lag {} ms", {device->name(), replayMaxLag * 1000});
+            else
+               log.info("streaming finished for file [{}]", {device->name()});
 
             // send null buffer for EOF
             signalIqStream->next({});
             signalRvStream->next({});
 
-            // close file
-            device.reset();
+            close();
 
-            // update status
             updateRecorderStatus(SignalRecorderTask::Idle);
+
+            return;
          }
+
+         prefetchSync.wait_for(lock, std::chrono::milliseconds(50));
+
+         return;
       }
-   }
 
-   void signalWrite()
-   {
-      if (device && device->isOpen())
+      auto now = std::chrono::steady_clock::now();
+
+      if (paced)
       {
-         if (auto buffer = signalQueue.get())
+         const PrefetchBlock &next = prefetchBuffers.front();
+
+         if (replayOrigin < 0)
          {
-            if (!buffer->isEmpty())
-            {
-               device->write(buffer.value());
-            }
+            replayOrigin = next.offset;
+            replayStart = now;
+         }
+
+         // buffer is available when its last sample would have been received
+         double elapsed = double(next.offset + next.real.elements() - replayOrigin) / (next.real.sampleRate() * replaySpeed);
+
+         auto due = replayStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(elapsed));
+
+         if (now < due)
+         {
+            lock.unlock();
+
+            std::this_thread::sleep_until(std::min(due, now + std::chrono::milliseconds(50)));
+
+            return;
          }
+
+         replayLag = std::chrono::duration<double>(now - due).count();
+         replayMaxLag = std::max(replayMaxLag, replayLag);
+      }
+
+      auto block = prefetchBuffers.front();
+
+      prefetchBuffers.pop_front();
+
+      prefetchSync.notify_all();
+
+      lock.unlock();
+
+      // send IQ value buffer
+      if (block.iq)
+         signalIqStream->next(block.iq);
+
+      // send Real value buffer
+      signalRvStream->next(block.real);
+
+      publishOffset = block.offset + block.real.elements();
+
+      if (status == SignalRecorderTask::Replaying && (now - lastStatus) > std::chrono::milliseconds(1000))
+      {
+         updateRecorderStatus(status);
       }
    }
 
-   void signalCapture()
+   /*
+    * Start prefetch thread, file is only accessed from this thread until reading finish
+    */
+   void startPrefetch()
    {
+      replayOrigin = -1;
+      publishOffset = device->sampleOffset() / device->channelCount();
+      replayLag = 0;
+      replayMaxLag = 0;
+      prefetchRunning = true;
+      prefetchFinished = false;
+
+      prefetchThread = std::thread([this] { prefetchRead(); });
    }
 
-   void signalReplay()
+   /*
+    * Prefetch thread, keeps up to prefetchDepth buffers ready so file access never delays the pipeline
+    */
+   void prefetchRead()
    {
+      log.debug("prefetch thread started");
+
+      while (true)
+      {
+         PrefetchBlock block {};
+
+         bool readed = readBlock(block);
+         bool finished = !readed || device->isEof() || !device->isOpen();
+
+         std::unique_lock<std::mutex> lock(prefetchMutex);
+
+         if (readed)
+         {
+            prefetchSync.wait(lock, [this] { return prefetchBuffers.size() < prefetchDepth || !prefetchRunning; });
+
+            if (!prefetchRunning)
+               break;
+
+            prefetchBuffers.push_back(block);
+         }
+
+         if (finished || !prefetchRunning)
+         {
+            prefetchFinished = true;
+            prefetchSync.notify_all();
+            break;
+         }
+
+         prefetchSync.notify_all();
+      }
+
+      log.debug("prefetch thread finished");
    }
 
    void close()
    {
+      if (prefetchThread.joinable())
+      {
+         {
+            std::lock_guard<std::mutex> lock(prefetchMutex);
+
+            prefetchRunning = false;
+
+            prefetchSync.notify_all();
+         }
+
+         prefetchThread.join();
+      }
+
+      prefetchBuffers.clear();
+
       device.reset();
    }
 
@@ -459,11 +686,26 @@ struct SignalRecorderTask::Impl : SignalRecorderTask, AbstractTask
          data["file"] = device->name();
          data["channelCount"] = device->channelCount();
          data["sampleCount"] = device->sampleCount();
-         data["sampleOffset"] = device->sampleOffset();
+
+         // device position is owned by prefetch thread, offset is taken from last published buffer
+         data["sampleOffset"] = prefetchThread.joinable() ? publishOffset * device->channelCount() : device->sampleOffset();
          data["sampleRate"] = device->sampleRate();
          data["sampleSize"] = device->sampleSize();
          data["sampleType"] = device->sampleType();
          data["streamTime"] = device->streamTime();
+
+         if (status == Writing)
+         {
+            data["writeRate"] = device->writeRate() / 1E6;
+            data["writeBacklog"] = device->writeBacklog();
+         }
+
+         if (status == Replaying)
+         {
+            data["replaySpeed"] = replaySpeed;
+            data["replayLag"] = replayLag;
+            data["replayMaxLag"] = replayMaxLag;
+         }
       }
 
       log.info("updated recorder status: {}", {data.dump()});
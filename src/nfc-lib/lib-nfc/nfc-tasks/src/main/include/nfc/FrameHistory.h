@@ -0,0 +1,85 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef NFC_FRAMEHISTORY_H
+#define NFC_FRAMEHISTORY_H
+
+#include <string>
+#include <memory>
+#include <functional>
+
+#include <nfc/NfcFrame.h>
+
+namespace nfc {
+
+/*
+ * Bounded frame history, recent frames are kept in memory and older ones are spilled to rotating
+ * spool files on disk, spool files are removed according to retention limits
+ */
+class FrameHistory
+{
+      struct Impl;
+
+   public:
+
+      FrameHistory();
+
+      // maximum frames kept in memory
+      void setMemoryFrames(long frames);
+
+      // directory for spool files, empty to discard frames leaving memory window, each history writes to its own locked
+      // subdirectory and subdirectories left there by processes no longer running are removed
+      void setSpoolPath(const std::string &path);
+
+      // retention limits for whole history, zero for unlimited
+      void setRetentionFrames(long frames);
+
+      void setRetentionBytes(long long bytes);
+
+      void setRetentionAge(double seconds);
+
+      void append(const NfcFrame &frame);
+
+      // remove all frames, including spool files and spool directory if left empty
+      void clear();
+
+      // frames in memory and on disk
+      long size() const;
+
+      long memorySize() const;
+
+      // bytes on disk, including active spool file
+      long long spoolBytes() const;
+
+      // visit all frames from oldest to newest
+      void forEach(const std::function<void(const NfcFrame &)> &handler);
+
+   private:
+
+      std::shared_ptr<Impl> impl;
+};
+
+}
+
+#endif
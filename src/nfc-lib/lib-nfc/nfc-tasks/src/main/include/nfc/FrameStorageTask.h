@@ -37,7 +37,8 @@ class FrameStorageTask : public rt::Worker
       {
          Clear,
          Read,
-         Write
+         Write,
+         Configure
       };
 
       enum Status
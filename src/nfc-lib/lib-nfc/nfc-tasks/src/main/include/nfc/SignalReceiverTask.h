@@ -47,9 +47,13 @@ class SignalReceiverTask : public rt::Worker
          Streaming,
          Attach,
          Config,
-         Statistics
+         Statistics,
+         Detach
       };
 
+      // maximum number of devices streaming at same time
+      static constexpr int MaxReceivers = 4;
+
    private:
 
       struct Impl;
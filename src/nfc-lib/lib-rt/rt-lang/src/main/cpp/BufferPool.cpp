@@ -0,0 +1,209 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstdlib>
+
+#include <rt/BufferPool.h>
+
+// smallest pooled block size
+#define MIN_BLOCK_BITS 9
+
+// largest pooled block size
+#define MAX_BLOCK_BITS 28
+
+// size classes, 1 for minimum size and 4 for each power of two up to maximum
+#define SIZE_CLASSES (1 + (MAX_BLOCK_BITS - MIN_BLOCK_BITS) * 4)
+
+// default maximum idle memory held in pool
+#define DEFAULT_LIMIT (256 * 1024 * 1024)
+
+namespace rt {
+
+struct SizeClass
+{
+   std::mutex mutex;
+   std::vector<void *> blocks;
+};
+
+struct Pool
+{
+   SizeClass classes[SIZE_CLASSES];
+
+   std::atomic<long long> hits {0};
+   std::atomic<long long> misses {0};
+   std::atomic<long long> releases {0};
+   std::atomic<long long> discards {0};
+   std::atomic<long long> idleBytes {0};
+   std::atomic<long long> limitBytes {DEFAULT_LIMIT};
+};
+
+// pool is never destroyed so buffers released during static destruction are still safe
+static Pool &pool()
+{
+   static auto *instance = new Pool();
+
+   return *instance;
+}
+
+// return block size for given size class
+static std::size_t classSize(int index)
+{
+   if (index == 0)
+      return 1 << MIN_BLOCK_BITS;
+
+   int bits = MIN_BLOCK_BITS + (index - 1) / 4;
+   int step = (index - 1) & 3;
+
+   return (std::size_t) (4 + step + 1) << (bits - 2);
+}
+
+// return size class for requested size and round up size to class block size, -1 if size is not pooled
+static int sizeClass(std::size_t &size)
+{
+   if (size <= (1 << MIN_BLOCK_BITS))
+   {
+      size = 1 << MIN_BLOCK_BITS;
+      return 0;
+   }
+
+   if (size > (1 << MAX_BLOCK_BITS))
+      return -1;
+
+   std::size_t value = size - 1;
+
+   // position of most significant bit
+   int bits = 0;
+
+   while (value >> (bits + 1))
+      bits++;
+
+   // quarter step within power of two
+   int step = (int) (value >> (bits - 2)) & 3;
+
+   int index = 1 + (bits - MIN_BLOCK_BITS) * 4 + step;
+
+   size = classSize(index);
+
+   return index;
+}
+
+void *BufferPool::acquire(std::size_t &size)
+{
+   int index = sizeClass(size);
+
+   if (index >= 0)
+   {
+      SizeClass &entry = pool().classes[index];
+
+      std::lock_guard<std::mutex> lock(entry.mutex);
+
+      if (!entry.blocks.empty())
+      {
+         void *block = entry.blocks.back();
+
+         entry.blocks.pop_back();
+
+         pool().idleBytes -= size;
+
+         pool().hits++;
+
+         return block;
+      }
+   }
+
+   pool().misses++;
+
+   return std::malloc(size);
+}
+
+void BufferPool::release(void *block, std::size_t size)
+{
+   if (!block)
+      return;
+
+   int index = sizeClass(size);
+
+   if (index >= 0 && pool().idleBytes + (long long) size <= pool().limitBytes)
+   {
+      SizeClass &entry = pool().classes[index];
+
+      std::lock_guard<std::mutex> lock(entry.mutex);
+
+      entry.blocks.push_back(block);
+
+      pool().idleBytes += size;
+
+      pool().releases++;
+
+      return;
+   }
+
+   pool().discards++;
+
+   std::free(block);
+}
+
+void BufferPool::trim()
+{
+   for (int index = 0; index < SIZE_CLASSES; index++)
+   {
+      SizeClass &entry = pool().classes[index];
+
+      std::lock_guard<std::mutex> lock(entry.mutex);
+
+      for (void *block: entry.blocks)
+      {
+         std::free(block);
+      }
+
+      pool().idleBytes -= (long long) (entry.blocks.size() * classSize(index));
+
+      entry.blocks.clear();
+   }
+}
+
+void BufferPool::setLimit(std::size_t bytes)
+{
+   pool().limitBytes = (long long) bytes;
+
+   if (pool().idleBytes > pool().limitBytes)
+      trim();
+}
+
+std::size_t BufferPool::limit()
+{
+   return (std::size_t) pool().limitBytes.load();
+}
+
+BufferPool::Statistics BufferPool::statistics()
+{
+      Pool &p = pool();
+
+   return {p.hits, p.misses, p.releases, p.discards, p.idleBytes, p.limitBytes};
+}
+
+}
@@ -23,9 +23,11 @@
 */
 
 #include <fcntl.h>
+#include <unistd.h>
 #include <dirent.h>
 #include <sys/stat.h>
 
+#include <cstdio>
 #include <fstream>
 
 #include <rt/FileSystem.h>
@@ -111,6 +113,34 @@ bool FileSystem::truncateFile(const std::string &path)
    return file.is_open();
 }
 
+bool FileSystem::removeFile(const std::string &path)
+{
+   if (!isRegularFile(path))
+      return false;
+
+   return std::remove(path.c_str()) == 0;
+}
+
+bool FileSystem::removeDirectory(const std::string &path)
+{
+   if (!isDirectory(path))
+      return false;
+
+   return rmdir(path.c_str()) == 0;
+}
+
+long long FileSystem::fileSize(const std::string &path)
+{
+   struct stat sb {};
+
+   if (stat(path.c_str(), &sb) == 0)
+   {
+      return sb.st_size;
+   }
+
+   return -1;
+}
+
 std::list<FileSystem::DirectoryEntry> FileSystem::directoryList(const std::string &path)
 {
    std::list<DirectoryEntry> result;
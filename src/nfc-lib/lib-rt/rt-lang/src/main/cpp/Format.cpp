@@ -22,181 +22,354 @@
 
 */
 
-#include <regex>
-#include <iostream>
+#include <memory>
+#include <vector>
+#include <cstdarg>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
 
 #include <rt/Format.h>
 
+// maximum number of segments for one format string
+#define MAX_SEGMENTS 64
+
 const char *ws = " \t\n\r\f\v";
 
-std::string rt::Format::format(const std::string &fmt, const std::vector<Variant> &parameters)
+namespace rt {
+
+/*
+ * Format string segment, literal text or parameter placeholder
+ */
+struct Segment
+{
+   int start; // segment start offset in format string
+   int length; // segment length in format string
+   char opts[8]; // placeholder options, as "{.2}" or "{08x}"
+   char mode; // placeholder mode, 'x' / 'X' or 0 for default
+   bool placeholder;
+};
+
+/*
+ * Pre-parsed format string
+ */
+struct Pattern
 {
-   std::regex token(R"(\{([\.0-9]*)?([xX])?\})");
+   int count = 0;
+   Segment segments[MAX_SEGMENTS];
+};
 
-   std::string content = fmt;
+/*
+ * Split format string in literal and placeholders segments, placeholder syntax is {[.0-9]*[xX]?}
+ */
+static void parse(const char *fmt, Pattern &pattern)
+{
+   int start = 0, i = 0;
 
-   char buffer[16384];
+   pattern.count = 0;
 
-   for (const auto &parameter: parameters)
+   while (fmt[i] && pattern.count < MAX_SEGMENTS - 2)
    {
-      buffer[0] = 0;
+      if (fmt[i] == '{')
+      {
+         int e = i + 1, o = 0;
 
-      std::smatch match;
+         char opts[8] {0};
+         char mode = 0;
 
-      if (!std::regex_search(content, match, token))
-         break;
+         // placeholder options
+         while ((fmt[e] == '.' || (fmt[e] >= '0' && fmt[e] <= '9')) && o < sizeof(opts) - 1)
+            opts[o++] = fmt[e++];
 
-      std::string opts = match[1];
-      std::string mode = match[2];
+         // placeholder mode
+         if (fmt[e] == 'x' || fmt[e] == 'X')
+            mode = fmt[e++];
 
-      if (auto value = std::get_if<bool>(&parameter))
-      {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "s").c_str(), *value ? "true" : "false");
-      }
-      else if (auto value = std::get_if<char>(&parameter))
-      {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + (mode.empty() ? "c" : mode)).c_str(), *value);
-      }
-      else if (auto value = std::get_if<short>(&parameter))
-      {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + (mode.empty() ? "d" : mode)).c_str(), *value);
-      }
-      else if (auto value = std::get_if<int>(&parameter))
-      {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + (mode.empty() ? "d" : mode)).c_str(), *value);
-      }
-      else if (auto value = std::get_if<long>(&parameter))
-      {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + (mode.empty() ? "d" : mode)).c_str(), *value);
-      }
-      else if (auto value = std::get_if<long long>(&parameter))
-      {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + (mode.empty() ? "ll" : mode)).c_str(), *value);
-      }
-      else if (auto value = std::get_if<unsigned char>(&parameter))
-      {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + (mode.empty() ? "u" : mode)).c_str(), *value);
-      }
-      else if (auto value = std::get_if<unsigned short>(&parameter))
-      {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + (mode.empty() ? "u" : mode)).c_str(), *value);
-      }
-      else if (auto value = std::get_if<unsigned int>(&parameter))
-      {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + (mode.empty() ? "u" : mode)).c_str(), *value);
-      }
-      else if (auto value = std::get_if<unsigned long>(&parameter))
-      {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + (mode.empty() ? "u" : mode)).c_str(), *value);
-      }
-      else if (auto value = std::get_if<unsigned long long>(&parameter))
-      {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + (mode.empty() ? "ll" : mode)).c_str(), *value);
-      }
-      else if (auto value = std::get_if<float>(&parameter))
-      {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "f").c_str(), *value);
-      }
-      else if (auto value = std::get_if<double>(&parameter))
-      {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "f").c_str(), *value);
-      }
-      else if (auto value = std::get_if<char *>(&parameter))
-      {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "s").c_str(), *value);
-      }
-      else if (auto value = std::get_if<void *>(&parameter))
-      {
-         snprintf(buffer, sizeof(buffer), "0x%p", *value);
-      }
-      else if (auto value = std::get_if<std::string>(&parameter))
-      {
-         snprintf(buffer, sizeof(buffer), ("%" + opts + "s").c_str(), value->c_str());
-      }
-      else if (auto value = std::get_if<std::thread::id>(&parameter))
-      {
-         snprintf(buffer, sizeof(buffer), ("0x%" + opts + "x").c_str(), *value);
+         if (fmt[e] == '}')
+         {
+            // previous literal
+            if (i > start)
+               pattern.segments[pattern.count++] = {start, i - start, {0}, 0, false};
+
+            Segment &segment = pattern.segments[pattern.count++];
+
+            segment = {i, e - i + 1, {0}, mode, true};
+
+            std::memcpy(segment.opts, opts, sizeof(opts));
+
+            start = i = e + 1;
+
+            continue;
+         }
       }
-      else if (auto value = std::get_if<Buffer<unsigned char>>(&parameter))
+
+      i++;
+   }
+
+   // remaining literal
+   if (fmt[start])
+      pattern.segments[pattern.count++] = {start, (int) std::strlen(fmt + start), {0}, 0, false};
+}
+
+/*
+ * Return pattern for persistent format, parsed only once per thread
+ */
+static const Pattern &cached(const char *fmt)
+{
+   static thread_local std::unordered_map<const char *, std::unique_ptr<Pattern>> cache;
+
+   auto &pattern = cache[fmt];
+
+   if (!pattern)
+   {
+      pattern = std::make_unique<Pattern>();
+
+      parse(fmt, *pattern);
+   }
+
+   return *pattern;
+}
+
+/*
+ * Bounded printf into buffer, returns number of characters written
+ */
+static inline int print(char *buffer, int size, const char *spec, ...)
+{
+   if (size <= 0)
+      return 0;
+
+   va_list args;
+   va_start(args, spec);
+   int length = vsnprintf(buffer, size, spec, args);
+   va_end(args);
+
+   return length < 0 ? 0 : (length < size ? length : size - 1);
+}
+
+/*
+ * Build printf specifier as "%" + opts + length + conversion
+ */
+static inline const char *spec(char *buffer, const Segment &segment, const char *length, char conversion, bool numeric = true)
+{
+   int n = 0;
+
+   buffer[n++] = '%';
+
+   for (int i = 0; segment.opts[i]; i++)
+      buffer[n++] = segment.opts[i];
+
+   for (int i = 0; length[i]; i++)
+      buffer[n++] = length[i];
+
+   buffer[n++] = numeric && segment.mode ? segment.mode : conversion;
+   buffer[n] = 0;
+
+   return buffer;
+}
+
+/*
+ * Format one parameter into buffer
+ */
+static int argument(char *buffer, int size, const Segment &segment, const Variant &parameter)
+{
+   char fmt[32];
+
+   if (auto value = std::get_if<bool>(&parameter))
+      return print(buffer, size, spec(fmt, segment, "", 's', false), *value ? "true" : "false");
+
+   if (auto value = std::get_if<char>(&parameter))
+      return print(buffer, size, spec(fmt, segment, "", 'c'), *value);
+
+   if (auto value = std::get_if<short>(&parameter))
+      return print(buffer, size, spec(fmt, segment, "", 'd'), *value);
+
+   if (auto value = std::get_if<int>(&parameter))
+      return print(buffer, size, spec(fmt, segment, "", 'd'), *value);
+
+   if (auto value = std::get_if<long>(&parameter))
+      return print(buffer, size, spec(fmt, segment, "l", 'd'), *value);
+
+   if (auto value = std::get_if<long long>(&parameter))
+      return print(buffer, size, spec(fmt, segment, "ll", 'd'), *value);
+
+   if (auto value = std::get_if<unsigned char>(&parameter))
+      return print(buffer, size, spec(fmt, segment, "", 'u'), *value);
+
+   if (auto value = std::get_if<unsigned short>(&parameter))
+      return print(buffer, size, spec(fmt, segment, "", 'u'), *value);
+
+   if (auto value = std::get_if<unsigned int>(&parameter))
+      return print(buffer, size, spec(fmt, segment, "", 'u'), *value);
+
+   if (auto value = std::get_if<unsigned long>(&parameter))
+      return print(buffer, size, spec(fmt, segment, "l", 'u'), *value);
+
+   if (auto value = std::get_if<unsigned long long>(&parameter))
+      return print(buffer, size, spec(fmt, segment, "ll", 'u'), *value);
+
+   if (auto value = std::get_if<float>(&parameter))
+      return print(buffer, size, spec(fmt, segment, "", 'f', false), *value);
+
+   if (auto value = std::get_if<double>(&parameter))
+      return print(buffer, size, spec(fmt, segment, "", 'f', false), *value);
+
+   if (auto value = std::get_if<char *>(&parameter))
+      return print(buffer, size, spec(fmt, segment, "", 's', false), *value ? *value : "(null)");
+
+   if (auto value = std::get_if<void *>(&parameter))
+      return print(buffer, size, "0x%p", *value);
+
+   if (auto value = std::get_if<std::string>(&parameter))
+      return print(buffer, size, spec(fmt, segment, "", 's', false), value->c_str());
+
+   if (auto value = std::get_if<std::thread::id>(&parameter))
+      return print(buffer, size, "0x%lx", (unsigned long) std::hash<std::thread::id>()(*value));
+
+   if (auto value = std::get_if<Buffer<unsigned char>>(&parameter))
+   {
+      int offset = 0;
+
+      // format line as: 0000: 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 ................
+      for (int i = 0; i < value->size(); i += 16)
       {
-         int offset = 0;
+         offset += print(buffer + offset, size - offset, "%04X: ", i);
 
-         // format line as: 0000: 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 ................
-         for (int i = 0; i < value->size(); i += 16)
+         for (int j = 0; j < 16; j++)
          {
-            offset += snprintf(buffer + offset, sizeof(buffer) - offset, "%04X: ", i);
-
-            for (int j = 0; j < 16; j++)
-            {
-               if (i + j < value->size())
-                  offset += snprintf(buffer + offset, sizeof(buffer) - offset, "%02X ", (unsigned int) value->data()[i + j]);
-               else
-                  offset += snprintf(buffer + offset, sizeof(buffer) - offset, "   ");
-            }
+            if (i + j < value->size())
+               offset += print(buffer + offset, size - offset, "%02X ", (unsigned int) value->data()[i + j]);
+            else
+               offset += print(buffer + offset, size - offset, "   ");
+         }
 
-            offset += snprintf(buffer + offset, sizeof(buffer) - offset, " ");
+         offset += print(buffer + offset, size - offset, " ");
 
-            for (int j = 0; j < 16; j++)
+         for (int j = 0; j < 16; j++)
+         {
+            if (i + j < value->size())
             {
-               if (i + j < value->size())
-               {
-                  offset += snprintf(buffer + offset, sizeof(buffer) - offset, "%c", isprint(value->data()[i + j]) ? value->data()[i + j] : '.');
-               }
+               offset += print(buffer + offset, size - offset, "%c", isprint(value->data()[i + j]) ? value->data()[i + j] : '.');
             }
+         }
 
-            if (i + 16 < value->size())
-            {
-               offset += snprintf(buffer + offset, sizeof(buffer) - offset, "\n");
+         if (i + 16 < value->size())
+         {
+            offset += print(buffer + offset, size - offset, "\n");
 
-               // exit if print buffer is reached
-               if (sizeof(buffer) - offset < 80)
-               {
-                  snprintf(buffer + offset, sizeof(buffer) - offset, "...");
+            // exit if print buffer is reached
+            if (size - offset < 80)
+            {
+               offset += print(buffer + offset, size - offset, "...");
 
-                  break;
-               }
+               break;
             }
          }
       }
-      else if (auto value = std::get_if<std::chrono::duration<long long, std::ratio<1, 1000000000>>>(&parameter))
-      {
-         // get duration horus
-         int hours = (int) std::chrono::duration_cast<std::chrono::hours>(*value).count();
 
-         // get duration minutes
-         int minutes = (int) std::chrono::duration_cast<std::chrono::minutes>(*value).count() % 60;
+      return offset;
+   }
+
+   if (auto value = std::get_if<std::chrono::duration<long long, std::ratio<1, 1000000000>>>(&parameter))
+   {
+      // get duration horus
+      int hours = (int) std::chrono::duration_cast<std::chrono::hours>(*value).count();
+
+      // get duration minutes
+      int minutes = (int) std::chrono::duration_cast<std::chrono::minutes>(*value).count() % 60;
 
-         // get duration seconds
-         int seconds = (int) std::chrono::duration_cast<std::chrono::seconds>(*value).count() % 60;
+      // get duration seconds
+      int seconds = (int) std::chrono::duration_cast<std::chrono::seconds>(*value).count() % 60;
 
-         // get duration milliseconds
-         int milliseconds = (int) std::chrono::duration_cast<std::chrono::milliseconds>(*value).count() % 1000;
+      // get duration milliseconds
+      int milliseconds = (int) std::chrono::duration_cast<std::chrono::milliseconds>(*value).count() % 1000;
 
-         // format as HH:MM:SS.mmm
-         sprintf(buffer, "%02d:%02d:%02d.%03d", hours, minutes, seconds, milliseconds);
+      // format as HH:MM:SS.mmm
+      return print(buffer, size, "%02d:%02d:%02d.%03d", hours, minutes, seconds, milliseconds);
+   }
+
+   return 0;
+}
+
+std::string Format::format(const std::string &fmt, const std::vector<Variant> &parameters)
+{
+   char buffer[16384];
+
+   int length = format(buffer, sizeof(buffer), fmt.c_str(), parameters.data(), parameters.size());
+
+   // retry with larger buffer if content is truncated
+   if (length == sizeof(buffer) - 1)
+   {
+      std::vector<char> large(1 << 20);
+
+      length = format(large.data(), large.size(), fmt.c_str(), parameters.data(), parameters.size());
+
+      return {large.data(), (size_t) length};
+   }
+
+   return {buffer, (size_t) length};
+}
+
+int Format::format(char *buffer, int size, const char *fmt, const Variant *parameters, int count, bool persistent)
+{
+   Pattern local;
+
+   // get parsed format string
+   const Pattern *pattern = &local;
+
+   if (persistent)
+      pattern = &cached(fmt);
+   else
+      parse(fmt, local);
+
+   int offset = 0, index = 0;
+
+   if (size <= 0)
+      return 0;
+
+   for (int s = 0; s < pattern->count && offset < size - 1; s++)
+   {
+      const Segment &segment = pattern->segments[s];
+
+      // format next parameter
+      if (segment.placeholder && index < count)
+      {
+         offset += argument(buffer + offset, size - offset, segment, parameters[index++]);
       }
 
-      content.replace(match.position(), match.length(), buffer);
+         // or copy literal text (and placeholders without parameter)
+      else
+      {
+         int length = std::min(segment.length, size - offset - 1);
+
+         std::memcpy(buffer + offset, fmt + segment.start, length);
+
+         offset += length;
+      }
    }
 
-   return content;
+   buffer[offset] = 0;
+
+   return offset;
 }
 
-std::string rt::Format::trim(const std::string &str)
+std::string Format::trim(const std::string &str)
 {
    return ltrim(rtrim(str));
 }
 
-std::string rt::Format::ltrim(const std::string &str)
+std::string Format::ltrim(const std::string &str)
 {
    std::string s = str;
    s.erase(0, s.find_first_not_of(ws));
    return s;
 }
 
-std::string rt::Format::rtrim(const std::string &str)
+std::string Format::rtrim(const std::string &str)
 {
    std::string s = str;
    s.erase(s.find_last_not_of(ws) + 1);
    return s;
-}
\ No newline at end of file
+}
+
+}
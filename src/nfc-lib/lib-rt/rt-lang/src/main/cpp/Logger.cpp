@@ -26,6 +26,8 @@
 #include <pthread.h>
 
 #include <map>
+#include <list>
+#include <mutex>
 #include <string>
 #include <fstream>
 #include <cmath>
@@ -38,7 +40,21 @@
 #include <rt/Logger.h>
 #include <rt/Format.h>
 #include <rt/FileSystem.h>
-#include <rt/BlockingQueue.h>
+
+// size of per-thread log ring, must be power of 2^n
+#define RING_SIZE (1 << 19)
+
+// maximum size for one log record
+#define RECORD_SIZE (1 << 14)
+
+// maximum size for string or buffer arguments
+#define ARGUMENT_SIZE (1 << 12)
+
+// maximum number of arguments formatted per record
+#define MAX_PARAMS 32
+
+// record level mark for ring wrap padding
+#define PADDING_MARK 0xffff
 
 namespace rt {
 
@@ -53,34 +69,256 @@ const char *tags[] = {
       "" // 7
 };
 
-// log event for store debugging information
-struct LogEvent
+struct Logger::Impl
 {
-   std::string level;
-   std::string logger;
-   std::string format;
-   std::vector<Variant> params;
-
-   std::thread::id thread;
-   std::chrono::time_point<std::chrono::system_clock> time;
-
-   LogEvent(std::string level, std::string logger, std::string format, std::vector<Variant> params) :
-         level(std::move(level)),
-         logger(std::move(logger)),
-         format(std::move(format)),
-         params(std::move(params)),
-         thread(std::this_thread::get_id()),
-         time(std::chrono::system_clock::now())
+   int level;
+   std::string name;
+
+   Impl(std::string name, int level) : name(std::move(name)), level(level)
    {
    }
 };
 
+// binary log record header, followed by copied format string and packed arguments
+struct LogRecord
+{
+   unsigned int size; // total record size aligned to 8 bytes
+   unsigned short level; // record level or padding mark
+   unsigned short params; // number of packed arguments
+   unsigned int formatSize; // length of copied format string, 0 if format is persistent
+   const char *format; // persistent format string
+   const Logger::Impl *logger; // source logger
+   long long time; // record time, nanoseconds since epoch
+};
+
+// single producer / single consumer ring for one thread log records
+struct LogRing
+{
+   // producer write offset
+   alignas(64) std::atomic<unsigned long long> head {0};
+
+   // consumer read offset
+   alignas(64) std::atomic<unsigned long long> tail {0};
+
+   // records dropped due to full ring
+   std::atomic<unsigned int> dropped {0};
+
+   // owner thread finished
+   std::atomic<bool> closed {false};
+
+   // owner thread name
+   std::string thread;
+
+   // record storage
+   alignas(64) unsigned char data[RING_SIZE];
+
+   LogRing()
+   {
+      std::ostringstream oss;
+      oss << std::this_thread::get_id();
+      thread = oss.str();
+   }
+
+   // reserve contiguous space for one record, returns nullptr if ring is full
+   inline unsigned char *reserve(unsigned int size)
+   {
+      unsigned long long h = head.load(std::memory_order_relaxed);
+      unsigned long long t = tail.load(std::memory_order_acquire);
+
+      unsigned int offset = h & (RING_SIZE - 1);
+      unsigned int contiguous = RING_SIZE - offset;
+      unsigned int required = size > contiguous ? size + contiguous : size;
+
+      if (h + required - t > RING_SIZE)
+         return nullptr;
+
+      // not enough space until ring end, fill with padding record and wrap
+      if (size > contiguous)
+      {
+         auto *padding = reinterpret_cast<LogRecord *>(data + offset);
+
+         padding->size = contiguous;
+         padding->level = PADDING_MARK;
+
+         head.store(h + contiguous, std::memory_order_release);
+
+         offset = 0;
+      }
+
+      return data + offset;
+   }
+
+   // publish last reserved record
+   inline void commit(unsigned int size)
+   {
+      head.store(head.load(std::memory_order_relaxed) + size, std::memory_order_release);
+   }
+
+   // return next pending record, skipping padding, or nullptr if ring is empty
+   inline LogRecord *peek()
+   {
+      unsigned long long t = tail.load(std::memory_order_relaxed);
+
+      while (t < head.load(std::memory_order_acquire))
+      {
+         auto *record = reinterpret_cast<LogRecord *>(data + (t & (RING_SIZE - 1)));
+
+         if (record->level != PADDING_MARK)
+            return record;
+
+         t += record->size;
+
+         tail.store(t, std::memory_order_release);
+      }
+
+      return nullptr;
+   }
+
+   // release record returned by peek
+   inline void release(LogRecord *record)
+   {
+      tail.store(tail.load(std::memory_order_relaxed) + record->size, std::memory_order_release);
+   }
+};
+
+// registry of all thread rings, only locked when a thread logs for first time
+struct LogRegistry
+{
+   std::mutex mutex;
+
+   std::list<std::shared_ptr<LogRing>> rings;
+
+   std::shared_ptr<LogRing> attach()
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      return rings.emplace_back(std::make_shared<LogRing>());
+   }
+
+   std::list<std::shared_ptr<LogRing>> list()
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      // remove drained rings from finished threads
+      rings.remove_if([](const std::shared_ptr<LogRing> &ring) {
+         return ring->closed && !ring->peek();
+      });
+
+      return rings;
+   }
+};
+
+static LogRegistry registry;
+
+// current thread ring holder, marks ring as closed when thread finish
+struct LogRingHolder
+{
+   std::shared_ptr<LogRing> ring;
+
+   ~LogRingHolder()
+   {
+      if (ring)
+         ring->closed = true;
+   }
+};
+
+static thread_local LogRingHolder threadRing;
+
+// argument packing helpers
+template<typename T>
+inline unsigned char *packValue(unsigned char *ptr, unsigned char *end, const T &value)
+{
+   if (ptr + sizeof(T) > end)
+      return nullptr;
+
+   std::memcpy(ptr, &value, sizeof(T));
+
+   return ptr + sizeof(T);
+}
+
+inline unsigned char *packBytes(unsigned char *ptr, unsigned char *end, const void *data, unsigned int length)
+{
+   if (length > ARGUMENT_SIZE)
+      length = ARGUMENT_SIZE;
+
+   if (!(ptr = packValue(ptr, end, length)) || ptr + length + 1 > end)
+      return nullptr;
+
+   std::memcpy(ptr, data, length);
+
+   // null terminated so strings can be formatted in place
+   ptr[length] = 0;
+
+   return ptr + length + 1;
+}
+
+inline unsigned char *pack(unsigned char *ptr, unsigned char *end, const Variant &param)
+{
+   if (ptr >= end)
+      return nullptr;
+
+   *ptr++ = (unsigned char) param.index();
+
+   return std::visit([ptr, end](auto &&value) -> unsigned char * {
+
+      using T = std::decay_t<decltype(value)>;
+
+      if constexpr (std::is_same_v<T, std::string>)
+         return packBytes(ptr, end, value.data(), value.length());
+      else if constexpr (std::is_same_v<T, char *>)
+         return packBytes(ptr, end, value, value ? std::strlen(value) : 0);
+      else if constexpr (std::is_same_v<T, Buffer<unsigned char>>)
+         return packBytes(ptr, end, value.data(), value.size());
+      else
+         return packValue(ptr, end, value);
+
+   }, param);
+}
+
+// argument unpacking helpers
+template<std::size_t I = 0>
+inline const unsigned char *unpack(unsigned int index, const unsigned char *ptr, Variant &param)
+{
+   if constexpr (I < std::variant_size_v<Variant>)
+   {
+      if (index != I)
+         return unpack<I + 1>(index, ptr, param);
+
+      using T = std::variant_alternative_t<I, Variant>;
+
+      if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, char *> || std::is_same_v<T, Buffer<unsigned char>>)
+      {
+         unsigned int length;
+
+         std::memcpy(&length, ptr, sizeof(length));
+
+         ptr += sizeof(length);
+
+         if constexpr (std::is_same_v<T, Buffer<unsigned char>>)
+            param = Buffer<unsigned char>((unsigned char *) ptr, length);
+         else
+            param = (char *) ptr;
+
+         return ptr + length + 1;
+      }
+      else
+      {
+         T value;
+
+         std::memcpy(&value, ptr, sizeof(T));
+
+         param = value;
+
+         return ptr + sizeof(T);
+      }
+   }
+
+   return ptr;
+}
+
 // threaded logger to console stdout, runs on low priority thread
 struct Logger::Writer
 {
-   // events queue
-   BlockingQueue<LogEvent *> queue;
-
    // output file
    std::ostream &stream;
 
@@ -90,6 +328,9 @@ struct Logger::Writer
    // shutdown flag
    std::atomic<bool> buffered;
 
+   // writer mutex for unbuffered mode
+   std::mutex mutex;
+
    // writer thread
    std::thread thread;
 
@@ -115,43 +356,214 @@ struct Logger::Writer
       thread.join();
    }
 
-   void push(LogEvent *event)
+   void push(int level, const Logger::Impl *logger, const char *format, bool persistent, std::initializer_list<Variant> &params)
    {
-      // reject nre events if shutdown is started
+      // reject new events if shutdown is started
       if (shutdown)
          return;
 
       if (buffered)
       {
-         queue.add(event);
+         // get ring for current thread
+         if (!threadRing.ring)
+            threadRing.ring = registry.attach();
+
+         LogRing *ring = threadRing.ring.get();
+
+         // reserve space for packed record
+         if (unsigned int size = measure(format, persistent, params))
+         {
+            if (unsigned char *data = ring->reserve(size))
+            {
+               ring->commit(encode(data, size, level, logger, format, persistent, params));
+               return;
+            }
+         }
+
+         ring->dropped++;
       }
       else
       {
-         write(event);
+         alignas(8) unsigned char data[RECORD_SIZE];
+
+         if (unsigned int size = measure(format, persistent, params))
+         {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            encode(data, size, level, logger, format, persistent, params);
+
+            write(reinterpret_cast<LogRecord *>(data), nullptr);
+         }
+      }
+   }
+
+   // calculate packed record size, returns 0 if exceeds maximum record size
+   static unsigned int measure(const char *format, bool persistent, std::initializer_list<Variant> &params)
+   {
+      unsigned int size = sizeof(LogRecord);
+
+      if (!persistent)
+         size += std::min<unsigned int>(std::strlen(format), ARGUMENT_SIZE) + 1;
+
+      for (const auto &param: params)
+      {
+         size += 1 + std::visit([](auto &&value) -> unsigned int {
+
+            using T = std::decay_t<decltype(value)>;
+
+            if constexpr (std::is_same_v<T, std::string>)
+               return sizeof(unsigned int) + std::min<unsigned int>(value.length(), ARGUMENT_SIZE) + 1;
+            else if constexpr (std::is_same_v<T, char *>)
+               return sizeof(unsigned int) + std::min<unsigned int>(value ? std::strlen(value) : 0, ARGUMENT_SIZE) + 1;
+            else if constexpr (std::is_same_v<T, Buffer<unsigned char>>)
+               return sizeof(unsigned int) + std::min<unsigned int>(value.size(), ARGUMENT_SIZE) + 1;
+            else
+               return sizeof(T);
+
+         }, param);
+      }
+
+      // align record size to 8 bytes
+      size = (size + 7) & ~7;
+
+      return size <= RECORD_SIZE ? size : 0;
+   }
+
+   static unsigned int encode(unsigned char *data, unsigned int size, int level, const Logger::Impl *logger, const char *format, bool persistent, std::initializer_list<Variant> &params)
+   {
+      auto *record = reinterpret_cast<LogRecord *>(data);
+
+      unsigned char *ptr = data + sizeof(LogRecord);
+      unsigned char *end = data + size;
+
+      record->size = size;
+      record->level = level & 0x7;
+      record->params = params.size();
+      record->logger = logger;
+      record->format = persistent ? format : nullptr;
+      record->formatSize = 0;
+      record->time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+      // copy non persistent format string
+      if (!persistent)
+      {
+         unsigned int length = std::strlen(format);
+
+         if (length > ARGUMENT_SIZE)
+            length = ARGUMENT_SIZE;
+
+         std::memcpy(ptr, format, length);
+
+         ptr[length] = 0;
+
+         record->formatSize = length + 1;
+
+         ptr += length + 1;
+      }
+
+      // pack arguments in binary form
+      for (const auto &param: params)
+      {
+         ptr = pack(ptr, end, param);
       }
+
+      return record->size;
    }
 
    void exec()
    {
       while (!shutdown)
       {
-         while (auto event = queue.get(100))
+         if (!drain())
+         {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+         }
+      }
+
+      // write remaining records before exit
+      drain();
+
+      stream.flush();
+   }
+
+   // write pending records from all threads in time order, returns number of records written
+   int drain()
+   {
+      int count = 0;
+
+      auto rings = registry.list();
+
+      while (true)
+      {
+         LogRing *next = nullptr;
+         LogRecord *first = nullptr;
+
+         // select oldest pending record from all rings
+         for (const auto &ring: rings)
          {
-            if (stream.good())
+            if (LogRecord *record = ring->peek())
             {
-               write(event.value());
+               if (!first || record->time < first->time)
+               {
+                  first = record;
+                  next = ring.get();
+               }
             }
          }
+
+         if (!next)
+            break;
+
+         if (stream.good())
+            write(first, next);
+
+         next->release(first);
+
+         count++;
+      }
+
+      // report discarded records
+      for (const auto &ring: rings)
+      {
+         if (unsigned int dropped = ring->dropped.exchange(0))
+         {
+            char buffer[128];
+
+            int size = snprintf(buffer, sizeof(buffer), "logger ring full for thread-%s, %d records dropped\n", ring->thread.c_str(), dropped);
+
+            stream.write(buffer, size);
+         }
       }
+
+      return count;
    }
 
-   void write(LogEvent *event)
+   void write(const LogRecord *record, const LogRing *ring)
    {
       char date[32], buffer[65535];
       struct tm timeinfo {};
 
-      auto seconds = std::chrono::duration_cast<std::chrono::seconds>(event->time.time_since_epoch()).count();
-      auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(event->time.time_since_epoch()).count() % 1000;
+      Variant params[MAX_PARAMS];
+
+      auto *ptr = reinterpret_cast<const unsigned char *>(record) + sizeof(LogRecord);
+
+      // format string, persistent or copied in record
+      const char *format = record->format ? record->format : (const char *) ptr;
+
+      ptr += record->formatSize;
+
+      int count = std::min<int>(record->params, MAX_PARAMS);
+
+      // unpack arguments, strings point directly into record data
+      for (int i = 0; i < count; i++)
+      {
+         unsigned int index = *ptr++;
+
+         ptr = unpack(index, ptr, params[i]);
+      }
+
+      time_t seconds = record->time / 1000000000LL;
+      int millis = (record->time / 1000000LL) % 1000;
 
 #ifdef _WIN32
       localtime_s(&timeinfo, &seconds);
@@ -159,27 +571,35 @@ struct Logger::Writer
       localtime_r(&seconds, &timeinfo);
 #endif
 
-      std::ostringstream oss;
-      oss << event->thread;
+      std::string current;
 
-      strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &timeinfo);
+      const char *thread;
+
+      if (ring)
+      {
+         thread = ring->thread.c_str();
+      }
+      else
+      {
+         std::ostringstream oss;
+         oss << std::this_thread::get_id();
+         current = oss.str();
+         thread = current.c_str();
+      }
 
-      int size = snprintf(buffer, sizeof(buffer), "%s.%03d %s (thread-%s) [%s] %s\n", date, (int) millis, event->level.c_str(), oss.str().c_str(), event->logger.c_str(), Format::format(event->format, event->params).c_str());
+      strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &timeinfo);
 
-      stream.write(buffer, size);
+      int size = snprintf(buffer, sizeof(buffer), "%s.%03d %s (thread-%s) [%s] ", date, millis, tags[record->level], thread, record->logger->name.c_str());
 
-      delete event;
-   }
+      if (size >= sizeof(buffer))
+         size = sizeof(buffer) - 1;
 
-};
+      // format message directly in line buffer, reserving one byte for line feed
+      size += Format::format(buffer + size, sizeof(buffer) - size - 1, format, params, count, record->format != nullptr);
 
-struct Logger::Impl
-{
-   int level;
-   std::string name;
+      buffer[size++] = '\n';
 
-   Impl(std::string name, int level) : name(std::move(name)), level(level)
-   {
+      stream.write(buffer, size);
    }
 };
 
@@ -200,53 +620,22 @@ Logger::Logger(const std::string &name, int level)
    impl = putLogger(name, level);
 }
 
-void Logger::trace(const std::string &format, std::vector<Variant> params) const
-{
-   if (isEnabled(TRACE_LEVEL))
-      writer->push(new LogEvent(tags[TRACE_LEVEL], impl->name, format, std::move(params)));
-}
-
-void Logger::debug(const std::string &format, std::vector<Variant> params) const
-{
-   if (isEnabled(DEBUG_LEVEL))
-      writer->push(new LogEvent(tags[DEBUG_LEVEL], impl->name, format, std::move(params)));
-}
-
-void Logger::info(const std::string &format, std::vector<Variant> params) const
-{
-   if (isEnabled(INFO_LEVEL))
-      writer->push(new LogEvent(tags[INFO_LEVEL], impl->name, format, std::move(params)));
-}
-
-void Logger::warn(const std::string &format, std::vector<Variant> params) const
-{
-   if (isEnabled(WARN_LEVEL))
-      writer->push(new LogEvent(tags[WARN_LEVEL], impl->name, format, std::move(params)));
-}
-
-void Logger::error(const std::string &format, std::vector<Variant> params) const
-{
-   if (isEnabled(ERROR_LEVEL))
-      writer->push(new LogEvent(tags[ERROR_LEVEL], impl->name, format, std::move(params)));
-}
-
-void Logger::print(int level, const std::string &format, std::vector<Variant> params) const
+void Logger::push(int level, const char *format, bool persistent, std::initializer_list<Variant> params) const
 {
-   if (isEnabled(level))
-      writer->push(new LogEvent(tags[level & 0x7], impl->name, format, std::move(params)));
+   writer->push(level, impl.get(), format, persistent, params);
 }
 
-inline bool Logger::isEnabled(int value) const
+bool Logger::isEnabled(int value) const
 {
    return writer && ((writer->level < NONE_LEVEL && impl->level >= value) || writer->level >= value);
 }
 
-inline int Logger::getLevel() const
+int Logger::getLevel() const
 {
    return impl->level;
 }
 
-inline void Logger::setLevel(int level)
+void Logger::setLevel(int level)
 {
    impl->level = level;
 }
@@ -48,7 +48,17 @@ Map::operator std::string() const
       if (content.length() > 2)
          content.append(", ");
 
-      content.append(Format::format("{}: {}", {entry.first, entry.second}));
+      char buffer[1024];
+
+      Variant params[] = {entry.first, entry.second};
+
+      int length = Format::format(buffer, sizeof(buffer), "{}: {}", params, 2, true);
+
+      // entries that may not fit are formatted again without size limit
+      if (length < int(sizeof(buffer)) - 1)
+         content.append(buffer, length);
+      else
+         content.append(Format::format("{}: {}", {entry.first, entry.second}));
    }
 
    content.append(" }");
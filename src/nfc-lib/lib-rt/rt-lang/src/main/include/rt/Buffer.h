@@ -25,11 +25,17 @@
 #ifndef LANG_BUFFER_H
 #define LANG_BUFFER_H
 
+#include <new>
+#include <algorithm>
 #include <atomic>
+#include <cstdint>
 #include <cstring>
 #include <memory>
 #include <functional>
 
+#include <rt/Span.h>
+#include <rt/BufferPool.h>
+
 #define BUFFER_ALIGNMENT 256
 
 namespace rt {
@@ -42,25 +48,61 @@ class Buffer
       struct Alloc
       {
          T *data = nullptr; // aligned payload data pointer
-         void *block = nullptr;  // raw memory block pointer
+         void *block = nullptr;  // raw memory block pointer, holds this header, extension area and payload
+         void *payload = nullptr; // separate payload block after resize
          void *context = nullptr; // custom context payload
+         std::size_t blockSize = 0; // raw memory block size
+         std::size_t payloadSize = 0; // separate payload block size
          unsigned int type = 0; // custom data type
          unsigned int stride = 0; // custom data stride
          std::atomic<int> references; // block reference count
 
-         Alloc(unsigned int type, unsigned int capacity, unsigned int stride, void *context) : data(nullptr), type(type), references(1), stride(stride), context(context)
+         Alloc(void *block, std::size_t blockSize, unsigned int type, unsigned int stride, void *context) : block(block), blockSize(blockSize), type(type), references(1), stride(stride), context(context)
+         {
+         }
+
+         // allocate header, extension area and aligned payload in one pooled block
+         static Alloc *create(unsigned int type, unsigned int capacity, unsigned int stride, void *context, unsigned int extension = 0)
          {
-            // allocate raw memory including alignment space
-            block = malloc(capacity * sizeof(T) + BUFFER_ALIGNMENT);
+            std::size_t size = header() + extension + capacity * sizeof(T) + BUFFER_ALIGNMENT;
+
+            void *block = BufferPool::acquire(size);
+
+            auto alloc = new(block) Alloc(block, size, type, stride, context);
 
-            // align data buffer
-            data = (T *) ((((uintptr_t) block) + BUFFER_ALIGNMENT) & ~(BUFFER_ALIGNMENT - 1));
+            // align data buffer after extension area
+            alloc->data = align((char *) block + header() + extension);
+
+            return alloc;
          }
 
-         ~Alloc()
+         // return memory blocks to pool
+         static void destroy(Alloc *alloc)
          {
-            // release allocated buffer
-            free(block);
+            void *block = alloc->block;
+            std::size_t size = alloc->blockSize;
+
+            if (alloc->payload)
+               BufferPool::release(alloc->payload, alloc->payloadSize);
+
+            alloc->~Alloc();
+
+            BufferPool::release(block, size);
+         }
+
+         static constexpr std::size_t header()
+         {
+            return (sizeof(Alloc) + 15) & ~15;
+         }
+
+         static inline T *align(void *ptr)
+         {
+            return (T *) ((((uintptr_t) ptr) + BUFFER_ALIGNMENT - 1) & ~(BUFFER_ALIGNMENT - 1));
+         }
+
+         inline void *extension() const
+         {
+            return (char *) block + header();
          }
 
          inline int attach()
@@ -80,13 +122,39 @@ class Buffer
          unsigned int position; // current data position
          unsigned int capacity; // buffer data capacity
          unsigned int limit; // buffer data limit
+         unsigned int offset; // view start offset within allocation
 
-         State(unsigned int position, unsigned int capacity, unsigned int limit) : position(position), capacity(capacity), limit(limit)
+         State(unsigned int position, unsigned int capacity, unsigned int limit, unsigned int offset = 0) : position(position), capacity(capacity), limit(limit), offset(offset)
          {
          }
 
       } state;
 
+      // first element of this buffer view
+      inline T *base() const
+      {
+         return alloc->data + state.offset;
+      }
+
+   protected:
+
+      // constructors for derived buffers that keep fixed size metadata in the same allocation
+      Buffer(unsigned int capacity, unsigned int type, unsigned int stride, void *context, unsigned int extension) : state(0, capacity, capacity), alloc(Alloc::create(type, capacity, stride, context, extension))
+      {
+      }
+
+      Buffer(T *data, unsigned int capacity, unsigned int type, unsigned int stride, void *context, unsigned int extension) : state(0, capacity, capacity), alloc(Alloc::create(type, capacity, stride, context, extension))
+      {
+         if (data && capacity)
+            put(data, capacity).flip();
+      }
+
+      // metadata area reserved by derived buffers, nullptr for empty buffer
+      inline void *extension() const
+      {
+         return alloc ? alloc->extension() : nullptr;
+      }
+
    public:
 
       Buffer() : state(0, 0, 0), alloc(nullptr)
@@ -99,20 +167,20 @@ class Buffer
             alloc->attach();
       }
 
-      explicit Buffer(T *data, unsigned int capacity, unsigned int type = 0, unsigned int stride = 1, void *context = nullptr) : state(0, capacity, capacity), alloc(new Alloc(type, capacity, stride, context))
+      explicit Buffer(T *data, unsigned int capacity, unsigned int type = 0, unsigned int stride = 1, void *context = nullptr) : state(0, capacity, capacity), alloc(Alloc::create(type, capacity, stride, context))
       {
          if (data && capacity)
             put(data, capacity).flip();
       }
 
-      explicit Buffer(unsigned int capacity, unsigned int type = 0, unsigned int stride = 1, void *context = nullptr) : state(0, capacity, capacity), alloc(new Alloc(type, capacity, stride, context))
+      explicit Buffer(unsigned int capacity, unsigned int type = 0, unsigned int stride = 1, void *context = nullptr) : state(0, capacity, capacity), alloc(Alloc::create(type, capacity, stride, context))
       {
       }
 
       ~Buffer()
       {
          if (alloc && alloc->detach() == 0)
-            delete alloc;
+            Alloc::destroy(alloc);
       }
 
       inline Buffer &operator=(const Buffer &other)
@@ -121,7 +189,7 @@ class Buffer
             return *this;
 
          if (alloc && alloc->detach() == 0)
-            delete alloc;
+            Alloc::destroy(alloc);
 
          state = other.state;
          alloc = other.alloc;
@@ -140,10 +208,13 @@ class Buffer
          if (state.limit != other.state.limit || state.position != other.state.position || state.capacity != other.state.capacity)
             return false;
 
-         if (alloc == other.alloc)
+         if (alloc == other.alloc && state.offset == other.state.offset)
             return true;
 
-         return std::memcmp(alloc->data + state.position, other.alloc->data + state.position, state.limit) == 0;
+         if (!alloc || !other.alloc)
+            return false;
+
+         return std::memcmp(base() + state.position, other.base() + other.state.position, (state.limit - state.position) * sizeof(T)) == 0;
       }
 
       inline bool operator!=(const Buffer &other) const
@@ -154,7 +225,7 @@ class Buffer
       inline void reset()
       {
          if (alloc && alloc->detach() == 0)
-            delete alloc;
+            Alloc::destroy(alloc);
 
          state = {0, 0, 0};
          alloc = {nullptr};
@@ -232,14 +303,80 @@ class Buffer
 
       inline T *data() const
       {
-         return alloc ? alloc->data : nullptr;
+         return alloc ? base() : nullptr;
+      }
+
+      inline unsigned int origin() const
+      {
+         return state.offset;
+      }
+
+      /*
+       * Returns a view of elements [from, to) sharing the same allocation, with its own position and limit
+       */
+      inline Buffer<T> slice(unsigned int from, unsigned int to) const
+      {
+         Buffer<T> view;
+
+         if (alloc && from <= to && to <= state.capacity)
+         {
+            view.alloc = alloc;
+            view.state = {0, to - from, to - from, state.offset + from};
+
+            alloc->attach();
+         }
+
+         return view;
+      }
+
+      /*
+       * Returns a view of remaining elements [position, limit)
+       */
+      inline Buffer<T> slice() const
+      {
+         return slice(state.position, state.limit);
+      }
+
+      /*
+       * Returns remaining elements [position, limit) for direct read, state is not modified until advance() is called
+       */
+      inline Span<T> readable() const
+      {
+         return alloc ? Span<T>(base() + state.position, state.limit - state.position) : Span<T>();
+      }
+
+      /*
+       * Returns up to "size" elements from current position for direct write, state is not modified until commit() is called
+       */
+      inline Span<T> writable(unsigned int size) const
+      {
+         return alloc ? Span<T>(base() + state.position, std::min(size, state.limit - state.position)) : Span<T>();
+      }
+
+      /*
+       * Skip "size" elements consumed through readable()
+       */
+      inline Buffer<T> &advance(unsigned int size)
+      {
+         if (alloc)
+            state.position += std::min(size, state.limit - state.position);
+
+         return *this;
+      }
+
+      /*
+       * Mark "size" elements produced through writable() as written
+       */
+      inline Buffer<T> &commit(unsigned int size)
+      {
+         return advance(size);
       }
 
       inline T *pull(unsigned int size)
       {
          if (alloc && state.position + size <= state.capacity)
          {
-            T *ptr = alloc->data + state.position;
+            T *ptr = base() + state.position;
 
             state.position += size;
 
@@ -249,20 +386,32 @@ class Buffer
          return nullptr;
       }
 
+      /*
+       * Change capacity of a buffer that owns its whole allocation, buffers sharing the allocation with views or
+       * copies, and views themselves, are left unchanged because others still index the current payload
+       */
       inline Buffer<T> &resize(unsigned int newCapacity)
       {
-         if (alloc)
+         if (alloc && alloc->references == 1 && state.offset == 0)
          {
-            auto data = new T[newCapacity];
+            std::size_t size = newCapacity * sizeof(T) + BUFFER_ALIGNMENT;
+
+            void *block = BufferPool::acquire(size);
+
+            T *data = Alloc::align(block);
 
             for (int i = 0; i < newCapacity && i < state.limit; i++)
             {
-               data[i] = alloc->data[i];
+               data[i] = base()[i];
             }
 
-            delete[] alloc->data;
+            if (alloc->payload)
+               BufferPool::release(alloc->payload, alloc->payloadSize);
 
+            alloc->payload = block;
+            alloc->payloadSize = size;
             alloc->data = data;
+            state.offset = 0;
             state.limit = newCapacity > state.limit ? state.limit : newCapacity;
             state.capacity = newCapacity;
          }
@@ -306,7 +455,7 @@ class Buffer
       {
          if (alloc && state.position < state.limit)
          {
-            *data = alloc->data[state.position++];
+            *data = base()[state.position++];
          }
 
          return *this;
@@ -316,7 +465,7 @@ class Buffer
       {
          if (alloc && state.position < state.limit)
          {
-            alloc->data[state.position++] = *data;
+            base()[state.position++] = *data;
          }
 
          return *this;
@@ -326,7 +475,7 @@ class Buffer
       {
          if (alloc && state.position < state.limit)
          {
-            value = alloc->data[state.position++];
+            value = base()[state.position++];
          }
 
          return *this;
@@ -336,7 +485,7 @@ class Buffer
       {
          if (alloc && state.position < state.limit)
          {
-            alloc->data[state.position++] = value;
+            base()[state.position++] = value;
          }
 
          return *this;
@@ -344,28 +493,20 @@ class Buffer
 
       inline Buffer<T> &get(T *data, unsigned int size)
       {
-         if (alloc)
-         {
-            for (int i = 0; state.position < state.limit && i < size; i++, state.position++)
-            {
-               data[i] = alloc->data[state.position];
-            }
-         }
+         auto span = readable();
 
-         return *this;
+         std::copy_n(span.data(), std::min(size, span.size()), data);
+
+         return advance(size);
       }
 
       inline Buffer<T> &put(const T *data, unsigned int size)
       {
-         if (alloc)
-         {
-            for (int i = 0; i < size && state.position < state.limit; i++, state.position++)
-            {
-               alloc->data[state.position] = data[i];
-            }
-         }
+         auto span = writable(size);
 
-         return *this;
+         std::copy_n(data, span.size(), span.data());
+
+         return commit(span.size());
       }
 
       template<typename E>
@@ -375,7 +516,7 @@ class Buffer
          {
             for (int i = state.position; i < state.limit; i++)
             {
-               value = handler(value, alloc->data[i]);
+               value = handler(value, base()[i]);
             }
          }
 
@@ -388,19 +529,19 @@ class Buffer
          {
             for (int i = state.position; i < state.limit; i += alloc->stride)
             {
-               handler(alloc->data + i, alloc->stride);
+               handler(base() + i, alloc->stride);
             }
          }
       }
 
       inline T &operator[](unsigned int index)
       {
-         return alloc->data[index];
+         return base()[index];
       }
 
       inline const T &operator[](unsigned int index) const
       {
-         return alloc->data[index];
+         return base()[index];
       }
 };
 
@@ -0,0 +1,72 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef LANG_BUFFERPOOL_H
+#define LANG_BUFFERPOOL_H
+
+#include <cstddef>
+
+namespace rt {
+
+/*
+ * Recycling pool for raw buffer memory blocks, organized in size classes with 4 steps per power of two.
+ * Blocks released while the idle memory is below the configured limit are kept for later reuse,
+ * otherwise they are returned to the system.
+ */
+class BufferPool
+{
+   public:
+
+      struct Statistics
+      {
+         long long hits; // acquire requests served from pool
+         long long misses; // acquire requests that required system allocation
+         long long releases; // blocks returned to pool
+         long long discards; // blocks freed because pool limit is reached or size is not pooled
+         long long idleBytes; // memory currently held in pool
+         long long limitBytes; // maximum memory held in pool
+      };
+
+   public:
+
+      // acquire block of at least "size" bytes, real block size is returned in "size"
+      static void *acquire(std::size_t &size);
+
+      // release block previously acquired with given size
+      static void release(void *block, std::size_t size);
+
+      // free all idle blocks
+      static void trim();
+
+      // set maximum idle memory held in pool
+      static void setLimit(std::size_t bytes);
+
+      static std::size_t limit();
+
+      static Statistics statistics();
+};
+
+}
+
+#endif
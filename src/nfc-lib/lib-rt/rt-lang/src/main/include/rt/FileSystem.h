@@ -51,6 +51,14 @@ class FileSystem
 
       static bool truncateFile(const std::string &path);
 
+      static bool removeFile(const std::string &path);
+
+      // remove empty directory
+      static bool removeDirectory(const std::string &path);
+
+      // file size in bytes, -1 if not exists
+      static long long fileSize(const std::string &path);
+
       static std::list<DirectoryEntry> directoryList(const std::string &path);
 };
 
@@ -38,6 +38,12 @@ class Format
 
       static std::string format(const std::string &fmt, const std::vector<Variant> &parameters);
 
+      /*
+       * Format parameters directly into caller buffer, returns number of characters written (excluding null terminator).
+       * Persistent format strings (literals) are parsed only once and cached by pointer for each thread.
+       */
+      static int format(char *buffer, int size, const char *fmt, const Variant *parameters, int count, bool persistent = false);
+
       static std::string ltrim(const std::string &str);
 
       static std::string rtrim(const std::string &str);
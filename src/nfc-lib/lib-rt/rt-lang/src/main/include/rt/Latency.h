@@ -0,0 +1,135 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef NFC_LAB_LATENCY_H
+#define NFC_LAB_LATENCY_H
+
+#include <chrono>
+#include <algorithm>
+
+namespace rt {
+
+/*
+ * Latency histogram between two pipeline hops, with power of two buckets in microseconds. Bucket 0 counts
+ * intervals under 1us, bucket N counts intervals from 2^(N-1) to 2^N us and the last one everything above
+ */
+class Latency
+{
+   public:
+
+      static constexpr int Buckets = 24;
+
+   private:
+
+      // number of intervals
+      long long n = 0;
+
+      // total time, in nanoseconds
+      long long s = 0;
+
+      // minimum and maximum interval, in nanoseconds
+      long long lo = 0;
+      long long hi = 0;
+
+      // histogram buckets
+      long long h[Buckets] {};
+
+   public:
+
+      // monotonic timestamp in nanoseconds, common time base for all pipeline hops
+      static inline long long now()
+      {
+         return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+      }
+
+      // add interval between two hop timestamps, ignored if any of them was not traced
+      inline void update(long long from, long long to)
+      {
+         if (from > 0 && to >= from)
+            add(to - from);
+      }
+
+      inline void add(long long nanos)
+      {
+         int b = 0;
+
+         for (long long us = nanos / 1000; us > 0 && b < Buckets - 1; us >>= 1)
+            b++;
+
+         lo = n ? std::min(lo, nanos) : nanos;
+         hi = n ? std::max(hi, nanos) : nanos;
+
+         h[b]++;
+         s += nanos;
+         n++;
+      }
+
+      inline void clear()
+      {
+         *this = Latency();
+      }
+
+      inline long long count() const
+      {
+         return n;
+      }
+
+      inline long long bucket(int index) const
+      {
+         return h[index];
+      }
+
+      inline long long minimum() const
+      {
+         return lo;
+      }
+
+      inline long long maximum() const
+      {
+         return hi;
+      }
+
+      inline double average() const
+      {
+         return n ? double(s) / double(n) : 0;
+      }
+
+      // upper limit of the bucket holding the given fraction of intervals, bounded by maximum, in nanoseconds
+      inline long long percentile(double p) const
+      {
+         long long c = 0;
+
+         for (int b = 0; b < Buckets - 1; b++)
+         {
+            if ((c += h[b]) > 0 && c >= p * n)
+               return std::min(hi, (1000LL << b));
+         }
+
+         return hi;
+      }
+};
+
+}
+
+#endif //NFC_LAB_LATENCY_H
@@ -27,11 +27,20 @@
 
 #include <cstdio>
 #include <string>
+#include <type_traits>
 #include <vector>
 #include <initializer_list>
 
 #include <rt/Variant.h>
 
+/*
+ * Maximum log level compiled in, calls with higher level never push or format a record. Parameters are still
+ * built at call site, so avoid expensive arguments in trace and debug calls on hot paths
+ */
+#ifndef LOGGER_COMPILE_LEVEL
+#define LOGGER_COMPILE_LEVEL 5
+#endif
+
 namespace rt {
 
 class Logger
@@ -53,17 +62,89 @@ class Logger
 
       explicit Logger(const std::string &name, int level = INFO_LEVEL);
 
-      void trace(const std::string &format, std::vector<Variant> params = {}) const;
+      // constant char arrays are taken as string literals and formatted later, must have static storage duration,
+      // mutable char arrays such as stack buffers are copied as any other string
+
+      template<typename C, std::size_t N>
+      inline void trace(C (&format)[N], std::initializer_list<Variant> params = {}) const
+      {
+         if constexpr (LOGGER_COMPILE_LEVEL >= TRACE_LEVEL)
+            if (isEnabled(TRACE_LEVEL))
+               push(TRACE_LEVEL, format, std::is_const_v<C>, params);
+      }
+
+      inline void trace(const std::string &format, std::initializer_list<Variant> params = {}) const
+      {
+         if constexpr (LOGGER_COMPILE_LEVEL >= TRACE_LEVEL)
+            if (isEnabled(TRACE_LEVEL))
+               push(TRACE_LEVEL, format.c_str(), false, params);
+      }
+
+      template<typename C, std::size_t N>
+      inline void debug(C (&format)[N], std::initializer_list<Variant> params = {}) const
+      {
+         if constexpr (LOGGER_COMPILE_LEVEL >= DEBUG_LEVEL)
+            if (isEnabled(DEBUG_LEVEL))
+               push(DEBUG_LEVEL, format, std::is_const_v<C>, params);
+      }
+
+      inline void debug(const std::string &format, std::initializer_list<Variant> params = {}) const
+      {
+         if constexpr (LOGGER_COMPILE_LEVEL >= DEBUG_LEVEL)
+            if (isEnabled(DEBUG_LEVEL))
+               push(DEBUG_LEVEL, format.c_str(), false, params);
+      }
+
+      template<typename C, std::size_t N>
+      inline void info(C (&format)[N], std::initializer_list<Variant> params = {}) const
+      {
+         if constexpr (LOGGER_COMPILE_LEVEL >= INFO_LEVEL)
+            if (isEnabled(INFO_LEVEL))
+               push(INFO_LEVEL, format, std::is_const_v<C>, params);
+      }
 
-      void debug(const std::string &format, std::vector<Variant> params = {}) const;
+      inline void info(const std::string &format, std::initializer_list<Variant> params = {}) const
+      {
+         if constexpr (LOGGER_COMPILE_LEVEL >= INFO_LEVEL)
+            if (isEnabled(INFO_LEVEL))
+               push(INFO_LEVEL, format.c_str(), false, params);
+      }
 
-      void info(const std::string &format, std::vector<Variant> params = {}) const;
+      template<typename C, std::size_t N>
+      inline void warn(C (&format)[N], std::initializer_list<Variant> params = {}) const
+      {
+         if constexpr (LOGGER_COMPILE_LEVEL >= WARN_LEVEL)
+            if (isEnabled(WARN_LEVEL))
+               push(WARN_LEVEL, format, std::is_const_v<C>, params);
+      }
 
-      void warn(const std::string &format, std::vector<Variant> params = {}) const;
+      inline void warn(const std::string &format, std::initializer_list<Variant> params = {}) const
+      {
+         if constexpr (LOGGER_COMPILE_LEVEL >= WARN_LEVEL)
+            if (isEnabled(WARN_LEVEL))
+               push(WARN_LEVEL, format.c_str(), false, params);
+      }
 
-      void error(const std::string &format, std::vector<Variant> params = {}) const;
+      template<typename C, std::size_t N>
+      inline void error(C (&format)[N], std::initializer_list<Variant> params = {}) const
+      {
+         if constexpr (LOGGER_COMPILE_LEVEL >= ERROR_LEVEL)
+            if (isEnabled(ERROR_LEVEL))
+               push(ERROR_LEVEL, format, std::is_const_v<C>, params);
+      }
 
-      void print(int level, const std::string &format, std::vector<Variant> params = {}) const;
+      inline void error(const std::string &format, std::initializer_list<Variant> params = {}) const
+      {
+         if constexpr (LOGGER_COMPILE_LEVEL >= ERROR_LEVEL)
+            if (isEnabled(ERROR_LEVEL))
+               push(ERROR_LEVEL, format.c_str(), false, params);
+      }
+
+      inline void print(int level, const std::string &format, std::initializer_list<Variant> params = {}) const
+      {
+         if (level <= LOGGER_COMPILE_LEVEL && isEnabled(level))
+            push(level, format.c_str(), false, params);
+      }
 
       bool isEnabled(int level) const;
 
@@ -79,6 +160,11 @@ class Logger
 
       static void flush();
 
+   private:
+
+      // store log record in current thread ring, format string is copied unless is persistent (string literal)
+      void push(int level, const char *format, bool persistent, std::initializer_list<Variant> params) const;
+
    private:
 
       std::shared_ptr<Impl> impl;
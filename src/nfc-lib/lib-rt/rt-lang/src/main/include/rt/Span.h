@@ -0,0 +1,84 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef LANG_SPAN_H
+#define LANG_SPAN_H
+
+namespace rt {
+
+/*
+ * Contiguous range of elements, minimal std::span equivalent for hot loops over raw buffer memory
+ */
+template<class T>
+class Span
+{
+   private:
+
+      T *ptr;
+      unsigned int count;
+
+   public:
+
+      Span() : ptr(nullptr), count(0)
+      {
+      }
+
+      Span(T *data, unsigned int size) : ptr(data), count(size)
+      {
+      }
+
+      inline T *data() const
+      {
+         return ptr;
+      }
+
+      inline unsigned int size() const
+      {
+         return count;
+      }
+
+      inline bool empty() const
+      {
+         return count == 0;
+      }
+
+      inline T *begin() const
+      {
+         return ptr;
+      }
+
+      inline T *end() const
+      {
+         return ptr + count;
+      }
+
+      inline T &operator[](unsigned int index) const
+      {
+         return ptr[index];
+      }
+};
+
+}
+
+#endif
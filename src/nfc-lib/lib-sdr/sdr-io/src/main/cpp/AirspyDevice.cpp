@@ -30,13 +30,19 @@
 #include <airspy.h>
 
 #include <rt/Logger.h>
+#include <rt/Latency.h>
 
 #include <sdr/SignalType.h>
 #include <sdr/SignalBuffer.h>
+#include <sdr/IqConverter.h>
 #include <sdr/AirspyDevice.h>
 
 #define MAX_QUEUE_SIZE 4
 
+// raw ADC samples are 12 bit unsigned
+#define RAW_SAMPLE_SCALE (1.0f / 2048)
+#define RAW_SAMPLE_OFFSET 2048
+
 namespace sdr {
 
 int process_transfer(airspy_transfer *transfer);
@@ -65,6 +71,9 @@ struct AirspyDevice::Impl
    airspy_read_partid_serialno_t airspySerial {};
    airspy_sample_type airspySample = AIRSPY_SAMPLE_FLOAT32_IQ;
 
+   // raw samples to I/Q and magnitude conversion, for Integer sample type
+   IqConverter iqConverter {RAW_SAMPLE_SCALE, RAW_SAMPLE_OFFSET};
+
    std::mutex streamMutex;
    std::queue<SignalBuffer> streamQueue;
    RadioDevice::StreamHandler streamCallback;
@@ -216,12 +225,15 @@ struct AirspyDevice::Impl
    {
       if (airspyHandle)
       {
-         log.info("start streaming for device {}", {deviceName});
+         log.info("start streaming for device {}, {} samples", {deviceName, std::string(airspySample == AIRSPY_SAMPLE_UINT16_REAL ? "raw" : "float")});
 
          // clear counters
          samplesDropped = 0;
          samplesReceived = 0;
 
+         // reset converter state
+         iqConverter.reset();
+
          // reset stream status
          streamCallback = std::move(handler);
          streamQueue = std::queue<SignalBuffer>();
@@ -316,6 +328,33 @@ struct AirspyDevice::Impl
       return 0;
    }
 
+   int setSampleType(int value)
+   {
+      if (airspyHandle && airspy_is_streaming(airspyHandle))
+      {
+         log.warn("sample type can not be changed while streaming");
+         return -1;
+      }
+
+      sampleType = value;
+
+      // integer mode requests raw ADC samples and converts them here, float mode uses libairspy converter
+      airspySample = sampleType == RadioDevice::Integer ? AIRSPY_SAMPLE_UINT16_REAL : AIRSPY_SAMPLE_FLOAT32_IQ;
+
+      if (airspyHandle)
+      {
+         if ((airspyResult = airspy_set_sample_type(airspyHandle, airspySample)) != AIRSPY_SUCCESS)
+            log.warn("failed airspy_set_sample_type: [{}] {}", {airspyResult, airspy_error_name((enum airspy_error) airspyResult)});
+
+         // sample rate depends on sample type when not given as index
+         setSampleRate(sampleRate);
+
+         return airspyResult;
+      }
+
+      return 0;
+   }
+
    int setGainMode(int mode)
    {
       gainMode = mode;
@@ -597,14 +636,12 @@ int AirspyDevice::setSampleRate(long value)
 
 int AirspyDevice::sampleType() const
 {
-   return Float;
+   return impl->sampleType;
 }
 
 int AirspyDevice::setSampleType(int value)
 {
-   impl->log.warn("setSampleType has no effect!");
-
-   return -1;
+   return impl->setSampleType(value);
 }
 
 long AirspyDevice::streamTime() const
@@ -749,8 +786,14 @@ int process_transfer(airspy_transfer *transfer)
    // check device validity
    if (auto *device = static_cast<AirspyDevice::Impl *>(transfer->ctx))
    {
+      // transfer completion time, first hop of latency tracing
+      long long captureTime = rt::Latency::now();
+
       SignalBuffer buffer;
 
+      unsigned int samples = transfer->sample_count;
+      unsigned int dropped = transfer->dropped_samples;
+
       switch (transfer->sample_type)
       {
          case AIRSPY_SAMPLE_FLOAT32_REAL:
@@ -760,11 +803,28 @@ int process_transfer(airspy_transfer *transfer)
          case AIRSPY_SAMPLE_FLOAT32_IQ:
             buffer = SignalBuffer((float *) transfer->samples, transfer->sample_count * 2, 2, device->sampleRate, device->samplesReceived, 0, SignalType::SAMPLE_IQ);
             break;
+
+         case AIRSPY_SAMPLE_UINT16_REAL:
+         {
+            // raw samples at twice the I/Q rate, converted straight into pooled buffers
+            samples = transfer->sample_count / 2;
+            dropped = transfer->dropped_samples / 2;
+
+            buffer = SignalBuffer(samples * 2, 2, device->sampleRate, device->samplesReceived, 0, SignalType::SAMPLE_IQ);
+
+            device->iqConverter.process((short *) transfer->samples, transfer->sample_count, buffer.pull(samples * 2), nullptr);
+
+            buffer.flip();
+
+            break;
+         }
       }
 
+      buffer.setCaptureTime(captureTime);
+
       // update counters
-      device->samplesReceived += transfer->sample_count;
-      device->samplesDropped += transfer->dropped_samples;
+      device->samplesReceived += samples;
+      device->samplesDropped += dropped;
 
       // stream to buffer callback
       if (device->streamCallback)
@@ -24,6 +24,7 @@
 
 #include <sdr/AirspyDevice.h>
 #include <sdr/RealtekDevice.h>
+#include <sdr/SimulatedDevice.h>
 #include <sdr/DeviceFactory.h>
 
 namespace sdr {
@@ -40,6 +41,10 @@ std::vector<std::string> DeviceFactory::deviceList()
    for (const auto &entry: sdr::RealtekDevice::listDevices())
       devices.push_back(entry);
 
+   // add simulated devices
+   for (const auto &entry: sdr::SimulatedDevice::listDevices())
+      devices.push_back(entry);
+
    return devices;
 }
 
@@ -51,6 +56,9 @@ RadioDevice *DeviceFactory::newInstance(const std::string &name)
    if (name.rfind("rtlsdr://", 0) == 0)
       return new RealtekDevice(name);
 
+   if (name.rfind("sim://", 0) == 0)
+      return new SimulatedDevice(name);
+
    //   if (name.startsWith("lime://"))
 //      return new LimeDevice(name, parent);
 
@@ -0,0 +1,242 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+
+#include <libusb.h>
+
+#include <rt/Logger.h>
+
+#include <sdr/DeviceFactory.h>
+#include <sdr/DeviceMonitor.h>
+
+namespace sdr {
+
+/*
+ * Bus notifications from libusb hotplug callbacks, enumeration is delegated to DeviceFactory
+ */
+struct UsbBackend : DeviceMonitor::Backend
+{
+   rt::Logger log {"UsbBackend"};
+
+   libusb_context *context = nullptr;
+   libusb_hotplug_callback_handle callback = 0;
+
+   bool registered = false;
+
+   std::atomic_bool changed {false};
+
+   UsbBackend()
+   {
+      int result;
+
+      if ((result = libusb_init(&context)) < 0)
+      {
+         log.warn("failed libusb_init: [{}]", {result});
+         context = nullptr;
+         return;
+      }
+
+      if (!libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG))
+      {
+         log.info("hotplug not supported, using device polling");
+         return;
+      }
+
+      int events = LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT;
+
+      if ((result = libusb_hotplug_register_callback(context, (libusb_hotplug_event) events, LIBUSB_HOTPLUG_NO_FLAGS, LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY, hotplugEvent, this, &callback)) != LIBUSB_SUCCESS)
+      {
+         log.warn("failed libusb_hotplug_register_callback: [{}], using device polling", {result});
+         return;
+      }
+
+      registered = true;
+   }
+
+   ~UsbBackend() override
+   {
+      if (registered)
+         libusb_hotplug_deregister_callback(context, callback);
+
+      if (context)
+         libusb_exit(context);
+   }
+
+   bool hotplug() override
+   {
+      return registered;
+   }
+
+   bool wait(int timeout) override
+   {
+      if (registered)
+      {
+         timeval tv {timeout / 1000, (timeout % 1000) * 1000};
+
+         // hotplug callbacks are invoked from here
+         libusb_handle_events_timeout_completed(context, &tv, nullptr);
+      }
+
+      return changed.exchange(false);
+   }
+
+   std::vector<std::string> enumerate() override
+   {
+      return DeviceFactory::deviceList();
+   }
+
+   static int LIBUSB_CALL hotplugEvent(libusb_context *ctx, libusb_device *device, libusb_hotplug_event event, void *data)
+   {
+      static_cast<UsbBackend *>(data)->changed = true;
+
+      // keep callback registered
+      return 0;
+   }
+};
+
+struct DeviceMonitor::Impl
+{
+   rt::Logger log {"DeviceMonitor"};
+
+   // enumeration backend
+   std::shared_ptr<Backend> backend;
+
+   // interval between enumerations without hotplug
+   std::chrono::milliseconds pollInterval;
+
+   // delay from last bus change to enumeration, lets devices finish initialization
+   std::chrono::milliseconds settleTime;
+
+   // cached device list
+   std::vector<std::string> devices;
+
+   // enumeration required on first update
+   bool initial = true;
+
+   // bus change waiting for settle time
+   bool pending = false;
+
+   // time of last bus change
+   std::chrono::steady_clock::time_point lastChange;
+
+   // time of last enumeration
+   std::chrono::steady_clock::time_point lastPoll;
+
+   // enumeration counter
+   long enumerations = 0;
+
+   Impl(std::shared_ptr<Backend> backend, int pollInterval, int settleTime) : backend(backend ? std::move(backend) : std::make_shared<UsbBackend>()), pollInterval(pollInterval), settleTime(settleTime)
+   {
+   }
+
+   int update(const EventHandler &handler, int timeout)
+   {
+      if (backend->hotplug())
+      {
+         if (backend->wait(timeout))
+         {
+            pending = true;
+            lastChange = std::chrono::steady_clock::now();
+         }
+
+         // enumerate only once bus is quiet
+         if (!initial && (!pending || std::chrono::steady_clock::now() - lastChange < settleTime))
+            return 0;
+      }
+      else
+      {
+         if (!initial && std::chrono::steady_clock::now() - lastPoll < pollInterval)
+            return 0;
+      }
+
+      std::vector<std::string> current = backend->enumerate();
+
+      initial = false;
+      pending = false;
+      lastPoll = std::chrono::steady_clock::now();
+      enumerations++;
+
+      int events = 0;
+
+      // removed devices first, so a replaced device is detached before attached again
+      for (const auto &name: devices)
+      {
+         if (std::find(current.begin(), current.end(), name) == current.end())
+         {
+            log.info("device {} detached", {name});
+
+            if (handler)
+               handler(Detach, name);
+
+            events++;
+         }
+      }
+
+      for (const auto &name: current)
+      {
+         if (std::find(devices.begin(), devices.end(), name) == devices.end())
+         {
+            log.info("device {} attached", {name});
+
+            if (handler)
+               handler(Attach, name);
+
+            events++;
+         }
+      }
+
+      devices = current;
+
+      return events;
+   }
+};
+
+DeviceMonitor::DeviceMonitor(std::shared_ptr<Backend> backend, int pollInterval, int settleTime) : impl(std::make_shared<Impl>(std::move(backend), pollInterval, settleTime))
+{
+}
+
+std::vector<std::string> DeviceMonitor::deviceList() const
+{
+   return impl->devices;
+}
+
+bool DeviceMonitor::isHotplug() const
+{
+   return impl->backend->hotplug();
+}
+
+int DeviceMonitor::update(const EventHandler &handler, int timeout)
+{
+   return impl->update(handler, timeout);
+}
+
+long DeviceMonitor::enumerations() const
+{
+   return impl->enumerations;
+}
+
+}
@@ -0,0 +1,260 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+
+#include <x86intrin.h>
+
+#endif
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include <sdr/IqConverter.h>
+
+// non-zero half-band taps, placed at odd offsets from center
+#define KERNEL_TAPS 24
+
+// Q branch delay, matches half-band group delay
+#define DELAY_TAPS (KERNEL_TAPS / 2)
+
+// output samples per chunk, working set remains in L1 cache
+#define CHUNK_SIZE 256
+
+// DC estimation smoothing factor, updated once per call
+#define DC_SMOOTH 0.25f
+
+namespace sdr {
+
+/*
+ * 47 taps half-band, same response as libairspy float converter so signal levels does not change between both paths
+ */
+static const std::vector<float> HALF_BAND_KERNEL = {
+      -0.000998606272947510f, 0, 0.001695637278417295f, 0, -0.003054430179754289f, 0, 0.005055504379767936f, 0,
+      -0.007901319195893647f, 0, 0.011873357051047719f, 0, -0.017411159379930066f, 0, 0.025304817427568772f, 0,
+      -0.037225225204559217f, 0, 0.057533286997004301f, 0, -0.102327462004259350f, 0, 0.317034472508947400f, 0.5f,
+      0.317034472508947400f, 0, -0.102327462004259350f, 0, 0.057533286997004301f, 0, -0.037225225204559217f, 0,
+      0.025304817427568772f, 0, -0.017411159379930066f, 0, 0.011873357051047719f, 0, -0.007901319195893647f, 0,
+      0.005055504379767936f, 0, -0.003054430179754289f, 0, 0.001695637278417295f, 0, -0.000998606272947510f
+};
+
+struct IqConverter::Impl
+{
+   // raw sample scale
+   float scale;
+
+   // initial DC offset
+   float initial;
+
+   // current DC offset estimation
+   float dc;
+
+   // output samples processed, selects Fs/4 rotation phase
+   unsigned long long position = 0;
+
+   // first half of symmetric I branch kernel
+   float taps[KERNEL_TAPS / 2] {};
+
+   // Q branch gain, half-band center tap
+   float center;
+
+   // I branch history and current chunk
+   alignas(16) float ibuf[KERNEL_TAPS - 1 + CHUNK_SIZE] {};
+
+   // Q branch history and current chunk
+   alignas(16) float qbuf[DELAY_TAPS + CHUNK_SIZE] {};
+
+   Impl(float scale, float offset) : scale(scale), initial(offset), dc(offset), center(HALF_BAND_KERNEL[HALF_BAND_KERNEL.size() / 2])
+   {
+      for (int i = 0; i < KERNEL_TAPS / 2; i++)
+         taps[i] = HALF_BAND_KERNEL[i * 2];
+   }
+
+   void reset()
+   {
+      dc = initial;
+      position = 0;
+
+      std::memset(ibuf, 0, sizeof(ibuf));
+      std::memset(qbuf, 0, sizeof(qbuf));
+   }
+
+   unsigned int process(const short *samples, unsigned int count, float *iq, float *magnitude)
+   {
+      unsigned int total = count / 2;
+
+      double sum = 0;
+
+      for (unsigned int base = 0; base < total; base += CHUNK_SIZE)
+      {
+         unsigned int length = std::min((unsigned int) CHUNK_SIZE, total - base);
+
+         // Fs/4 translation is -1, -j, 1, j over input samples, so sign flips on each output sample
+         float sign = position & 1 ? scale : -scale;
+
+         sum += split(samples + base * 2, ibuf + KERNEL_TAPS - 1, qbuf + DELAY_TAPS, length, sign);
+
+         filter(ibuf + KERNEL_TAPS - 1, qbuf + DELAY_TAPS, iq + base * 2, magnitude ? magnitude + base : nullptr, length);
+
+         // keep filter history for next chunk
+         std::memmove(ibuf, ibuf + length, (KERNEL_TAPS - 1) * sizeof(float));
+         std::memmove(qbuf, qbuf + length, DELAY_TAPS * sizeof(float));
+
+         position += length;
+      }
+
+      if (total > 0)
+         dc += (float(sum / (total * 2)) - dc) * DC_SMOOTH;
+
+      return total;
+   }
+
+   /*
+    * remove DC, split even / odd samples into I / Q branches and apply Fs/4 rotation, returns sum of raw samples
+    */
+   float split(const short *src, float *ip, float *qp, unsigned int length, float sign) const
+   {
+      unsigned int i = 0;
+
+      float sum = 0;
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+      __m128 vdc = _mm_set1_ps(dc);
+      __m128 vsg = _mm_setr_ps(sign, -sign, sign, -sign);
+      __m128 acc = _mm_setzero_ps();
+
+      for (; i + 4 <= length; i += 4)
+      {
+         // load 8 samples, 4 outputs
+         __m128i v = _mm_loadu_si128((const __m128i *) (src + i * 2));
+
+         // sign extend to 32 bits and convert to float
+         __m128 a = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)); // x0, x1, x2, x3
+         __m128 b = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)); // x4, x5, x6, x7
+
+         acc = _mm_add_ps(acc, _mm_add_ps(a, b));
+
+         __m128 vi = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)); // x0, x2, x4, x6
+         __m128 vq = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)); // x1, x3, x5, x7
+
+         _mm_storeu_ps(ip + i, _mm_mul_ps(_mm_sub_ps(vi, vdc), vsg));
+         _mm_storeu_ps(qp + i, _mm_mul_ps(_mm_sub_ps(vq, vdc), vsg));
+      }
+
+      alignas(16) float part[4];
+
+      _mm_store_ps(part, acc);
+
+      sum = part[0] + part[1] + part[2] + part[3];
+#endif
+
+      for (; i < length; i++)
+      {
+         float s = i & 1 ? -sign : sign;
+
+         ip[i] = (float(src[i * 2 + 0]) - dc) * s;
+         qp[i] = (float(src[i * 2 + 1]) - dc) * s;
+
+         sum += float(src[i * 2 + 0]) + float(src[i * 2 + 1]);
+      }
+
+      return sum;
+   }
+
+   /*
+    * half-band filter on I branch, delay on Q branch, interleave and compute magnitude
+    */
+   void filter(const float *ip, const float *qp, float *iq, float *magnitude, int length) const
+   {
+      int i = 0;
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+      __m128 vc = _mm_set1_ps(center);
+
+      for (; i + 4 <= length; i += 4)
+      {
+         // symmetric kernel, fold both halves before multiply
+         __m128 vi = _mm_setzero_ps();
+
+         for (int j = 0; j < KERNEL_TAPS / 2; j++)
+         {
+            __m128 s = _mm_add_ps(_mm_loadu_ps(ip + i - j), _mm_loadu_ps(ip + i - (KERNEL_TAPS - 1) + j));
+
+            vi = _mm_add_ps(vi, _mm_mul_ps(_mm_set1_ps(taps[j]), s));
+         }
+
+         __m128 vq = _mm_mul_ps(vc, _mm_loadu_ps(qp + i - DELAY_TAPS));
+
+         _mm_storeu_ps(iq + i * 2 + 0, _mm_unpacklo_ps(vi, vq)); // I0, Q0, I1, Q1
+         _mm_storeu_ps(iq + i * 2 + 4, _mm_unpackhi_ps(vi, vq)); // I2, Q2, I3, Q3
+
+         if (magnitude)
+            _mm_storeu_ps(magnitude + i, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(vi, vi), _mm_mul_ps(vq, vq))));
+      }
+#endif
+
+      for (; i < length; i++)
+      {
+         float vi = 0;
+
+         for (int j = 0; j < KERNEL_TAPS / 2; j++)
+            vi += taps[j] * (ip[i - j] + ip[i - (KERNEL_TAPS - 1) + j]);
+
+         float vq = center * qp[i - DELAY_TAPS];
+
+         iq[i * 2 + 0] = vi;
+         iq[i * 2 + 1] = vq;
+
+         if (magnitude)
+            magnitude[i] = std::sqrt(vi * vi + vq * vq);
+      }
+   }
+};
+
+IqConverter::IqConverter(float scale, float offset) : impl(std::make_shared<Impl>(scale, offset))
+{
+}
+
+unsigned int IqConverter::process(const short *samples, unsigned int count, float *iq, float *magnitude)
+{
+   return impl->process(samples, count, iq, magnitude);
+}
+
+void IqConverter::reset()
+{
+   impl->reset();
+}
+
+float IqConverter::offset() const
+{
+   return impl->dc;
+}
+
+const std::vector<float> &IqConverter::kernel()
+{
+   return HALF_BAND_KERNEL;
+}
+
+}
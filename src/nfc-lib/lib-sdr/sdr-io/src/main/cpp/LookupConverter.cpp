@@ -0,0 +1,112 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+
+#include <x86intrin.h>
+
+#endif
+
+#include <cmath>
+
+#include <sdr/LookupConverter.h>
+
+namespace sdr {
+
+struct LookupConverter::Impl
+{
+   // converted value for each possible sample, fits in L1 cache
+   alignas(16) float table[256];
+
+   Impl(float scale, float offset, float bias)
+   {
+      for (int i = 0; i < 256; i++)
+         table[i] = float((i - offset) * scale) + bias;
+   }
+
+   unsigned int process(const unsigned char *samples, unsigned int count, float *iq, float *magnitude) const
+   {
+      unsigned int total = count / 2;
+      unsigned int i = 0;
+
+      if (magnitude)
+      {
+#if defined(__SSE2__) && defined(USE_SSE2)
+         for (; i + 4 <= total; i += 4)
+         {
+            const unsigned char *src = samples + i * 2;
+
+            // table lookup for 4 I/Q pairs
+            __m128 a = _mm_setr_ps(table[src[0]], table[src[1]], table[src[2]], table[src[3]]); // I0, Q0, I1, Q1
+            __m128 b = _mm_setr_ps(table[src[4]], table[src[5]], table[src[6]], table[src[7]]); // I2, Q2, I3, Q3
+
+            _mm_storeu_ps(iq + i * 2 + 0, a);
+            _mm_storeu_ps(iq + i * 2 + 4, b);
+
+            __m128 p1 = _mm_mul_ps(a, a);
+            __m128 p2 = _mm_mul_ps(b, b);
+
+            // I^2 + Q^2 and square root
+            _mm_storeu_ps(magnitude + i, _mm_sqrt_ps(_mm_add_ps(_mm_shuffle_ps(p1, p2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(3, 1, 3, 1)))));
+         }
+#endif
+         for (; i < total; i++)
+         {
+            float vi = table[samples[i * 2 + 0]];
+            float vq = table[samples[i * 2 + 1]];
+
+            iq[i * 2 + 0] = vi;
+            iq[i * 2 + 1] = vq;
+
+            magnitude[i] = std::sqrt(vi * vi + vq * vq);
+         }
+      }
+      else
+      {
+#pragma GCC ivdep
+         for (unsigned int j = 0; j < total * 2; j++)
+         {
+            iq[j] = table[samples[j]];
+         }
+      }
+
+      return total;
+   }
+};
+
+LookupConverter::LookupConverter(float scale, float offset, float bias) : impl(std::make_shared<Impl>(scale, offset, bias))
+{
+}
+
+unsigned int LookupConverter::process(const unsigned char *samples, unsigned int count, float *iq, float *magnitude) const
+{
+   return impl->process(samples, count, iq, magnitude);
+}
+
+float LookupConverter::value(unsigned char sample) const
+{
+   return impl->table[sample];
+}
+
+}
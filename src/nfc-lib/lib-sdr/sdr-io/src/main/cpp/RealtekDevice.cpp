@@ -36,20 +36,27 @@
 #include <rtl-sdr.h>
 
 #include <rt/Logger.h>
+#include <rt/Latency.h>
 
 #include <sdr/SignalType.h>
 #include <sdr/SignalBuffer.h>
+#include <sdr/LookupConverter.h>
 #include <sdr/RealtekDevice.h>
 
 #define READER_SAMPLES 2048
 #define BUFFER_SAMPLES 65536
 
+// USB transfers in flight for asynchronous streaming
+#define ASYNC_BUFFERS 8
+
 #define MAX_QUEUE_SIZE 4
 
 typedef struct rtlsdr_dev *rtldev;
 
 namespace sdr {
 
+void process_transfer(unsigned char *data, uint32_t length, void *ctx);
+
 struct RealtekDevice::Impl
 {
    rt::Logger log {"RealtekDevice"};
@@ -78,6 +85,9 @@ struct RealtekDevice::Impl
    std::atomic_bool workerStreaming {false};
    std::thread workerThread;
 
+   // u8 samples to float conversion
+   LookupConverter sampleConverter;
+
    std::mutex streamMutex;
    std::queue<SignalBuffer> streamQueue;
    RadioDevice::StreamHandler streamCallback;
@@ -265,6 +275,9 @@ struct RealtekDevice::Impl
          // signal finish to running thread
          workerStreaming = false;
 
+         // wake up asynchronous reader, if not yet started it is cancelled on first transfer
+         rtlsdr_cancel_async(rtldev(rtlsdrHandle));
+
          // wait until worker is finished
          std::lock_guard<std::mutex> lock(workerMutex);
 
@@ -561,9 +574,6 @@ struct RealtekDevice::Impl
 
    void streamWorker()
    {
-      float scaled[READER_SAMPLES * 2];
-      unsigned char data[READER_SAMPLES * 2];
-
 #ifdef _WIN32
       SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
 #else
@@ -577,27 +587,33 @@ struct RealtekDevice::Impl
 
       log.info("stream worker started for device {}", {deviceName});
 
+      // asynchronous streaming keeps several USB transfers in flight, returns when cancelled
+      if ((rtlsdrResult = rtlsdr_read_async(rtldev(rtlsdrHandle), process_transfer, this, ASYNC_BUFFERS, BUFFER_SAMPLES * 2)) < 0)
+      {
+         log.warn("failed rtlsdr_read_async: [{}], using synchronous reads", {rtlsdrResult});
+
+         streamSync();
+      }
+
+      log.info("stream worker finished for device {}", {deviceName});
+   }
+
+   void streamSync()
+   {
+      unsigned char data[READER_SAMPLES * 2];
+
       while (workerStreaming)
       {
          int length;
 
          SignalBuffer buffer = SignalBuffer(BUFFER_SAMPLES * 2, 2, sampleRate, samplesReceived, 0, SignalType::SAMPLE_IQ);
 
-         while (buffer.available() > READER_SAMPLES && (rtlsdr_read_sync(rtldev(rtlsdrHandle), data, sizeof(data), &length) == 0))
+         while (buffer.available() >= sizeof(data) && (rtlsdr_read_sync(rtldev(rtlsdrHandle), data, sizeof(data), &length) == 0))
          {
             int dropped = sizeof(data) - length;
 
-#pragma GCC ivdep
-            for (int i = 0; i < length; i += 4)
-            {
-               scaled[i + 0] = float((data[i + 0] - 128) / 256.0) + 0.0025f;
-               scaled[i + 1] = float((data[i + 1] - 128) / 256.0) + 0.0025f;
-               scaled[i + 2] = float((data[i + 2] - 128) / 256.0) + 0.0025f;
-               scaled[i + 3] = float((data[i + 3] - 128) / 256.0) + 0.0025f;
-            }
-
-            // add data to buffer
-            buffer.put(scaled, length);
+            // convert samples directly into buffer
+            sampleConverter.process(data, length, buffer.pull(length), nullptr);
 
             // update counters
             samplesReceived += length >> 1;
@@ -608,34 +624,61 @@ struct RealtekDevice::Impl
                log.warn("dropped samples {}", {samplesDropped});
          }
 
-         // flip buffer contents
-         buffer.flip();
+         streamBuffer(buffer, rt::Latency::now());
+      }
+   }
 
-         // stream to buffer callback
-         if (streamCallback)
-         {
-            streamCallback(buffer);
-         }
+   void streamTransfer(const unsigned char *data, unsigned int length)
+   {
+      // stop requested before reader was running
+      if (!workerStreaming)
+      {
+         rtlsdr_cancel_async(rtldev(rtlsdrHandle));
+         return;
+      }
 
-            // or store buffer in receive queue
-         else
-         {
-            // lock buffer access
-            std::lock_guard<std::mutex> lock(streamMutex);
+      // transfer completion time, first hop of latency tracing
+      long long captureTime = rt::Latency::now();
 
-            // discard oldest buffers
-            if (streamQueue.size() >= MAX_QUEUE_SIZE)
-            {
-               samplesDropped += streamQueue.front().elements();
-               streamQueue.pop();
-            }
+      SignalBuffer buffer = SignalBuffer(length, 2, sampleRate, samplesReceived, 0, SignalType::SAMPLE_IQ);
 
-            // queue new sample buffer
-            streamQueue.push(buffer);
-         }
+      // convert USB transfer directly into pooled buffers
+      sampleConverter.process(data, length, buffer.pull(length), nullptr);
+
+      // update counters
+      samplesReceived += length >> 1;
+
+      streamBuffer(buffer, captureTime);
+   }
+
+   void streamBuffer(SignalBuffer &buffer, long long captureTime)
+   {
+      // flip buffer contents
+      buffer.flip();
+      buffer.setCaptureTime(captureTime);
+
+      // stream to buffer callback
+      if (streamCallback)
+      {
+         streamCallback(buffer);
       }
 
-      log.info("stream worker finished for device {}", {deviceName});
+         // or store buffer in receive queue
+      else
+      {
+         // lock buffer access
+         std::lock_guard<std::mutex> lock(streamMutex);
+
+         // discard oldest buffers
+         if (streamQueue.size() >= MAX_QUEUE_SIZE)
+         {
+            samplesDropped += streamQueue.front().elements();
+            streamQueue.pop();
+         }
+
+         // queue new sample buffer
+         streamQueue.push(buffer);
+      }
    }
 };
 
@@ -873,4 +916,14 @@ int RealtekDevice::write(SignalBuffer &buffer)
 {
    return impl->write(buffer);
 }
-}
\ No newline at end of file
+
+void process_transfer(unsigned char *data, uint32_t length, void *ctx)
+{
+   // check device validity
+   if (auto *device = static_cast<RealtekDevice::Impl *>(ctx))
+   {
+      device->streamTransfer(data, length);
+   }
+}
+
+}
@@ -26,19 +26,66 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#define USE_POSIX_IO
+#endif
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+#include <x86intrin.h>
+#endif
+
 #include <queue>
+#include <mutex>
+#include <thread>
+#include <atomic>
 #include <fstream>
 #include <iostream>
+#include <cmath>
+#include <climits>
 #include <cstring>
 #include <utility>
+#include <algorithm>
+#include <condition_variable>
 
 #include <rt/Logger.h>
+#include <rt/Buffer.h>
+#include <rt/Throughput.h>
 
 #include <sdr/SignalBuffer.h>
+#include <sdr/SignalKernel.h>
 #include <sdr/RecordDevice.h>
+#include <sdr/RecordIndex.h>
+
+#include "SampleCodec.h"
 
 #define BUFFER_SIZE (1024)
 
+// read-ahead window requested to kernel for mapped files
+#define READ_AHEAD (4 * 1024 * 1024)
+
+// size of each staging block for asynchronous writes
+#define STAGING_SIZE (4 * 1024 * 1024)
+
+// maximum number of staging blocks in flight
+#define STAGING_BLOCKS 16
+
+// file space reserved ahead of written data
+#define PREALLOCATE_SIZE (256 * 1024 * 1024)
+
+// samples per channel summarized in each index entry
+#define INDEX_BLOCK 65536
+
+// maximum size for 32 bit RIFF chunks, larger files are written as RF64
+#define RIFF_MAX_SIZE 0xFFFFFFFFLL
+
+// samples per channel in each compressed chunk
+#define NFCZ_CHUNK_FRAMES 65536
+
+// compressed chunks queued per codec thread
+#define NFCZ_QUEUE_DEPTH 2
+
 namespace sdr {
 
 struct chunk
@@ -70,218 +117,1265 @@ struct WAVEChunk
    unsigned short bitsPerSample; // 2 bytes
 };
 
-struct LISTChunk
-{
-   chunk desc;
-   DATEInfo time;
-};
+struct DS64Chunk
+{
+   chunk desc; // 8 bytes
+   unsigned int riffSizeLow; // 4 bytes
+   unsigned int riffSizeHigh; // 4 bytes
+   unsigned int dataSizeLow; // 4 bytes
+   unsigned int dataSizeHigh; // 4 bytes
+   unsigned int sampleCountLow; // 4 bytes
+   unsigned int sampleCountHigh; // 4 bytes
+   unsigned int tableLength; // 4 bytes
+};
+
+struct LISTChunk
+{
+   chunk desc;
+   DATEInfo time;
+};
+
+struct DATAChunk
+{
+   chunk desc;
+};
+
+struct FILEHeader
+{
+   RIFFChunk riff; // 12 bytes
+   DS64Chunk ds64; // 36 bytes, written as JUNK until file exceeds 4GB
+   WAVEChunk wave; // 24 bytes
+   LISTChunk list; // 16 bytes
+   DATAChunk data; // 8 bytes
+};
+
+/*
+ * Compressed recording layout: header, sequence of independent chunks and chunk table at end of file
+ */
+struct NFCZHeader
+{
+   char id[4]; // 4 bytes, "NFCZ"
+   unsigned int version; // 4 bytes
+   unsigned int sampleRate; // 4 bytes
+   unsigned short channelCount; // 2 bytes
+   unsigned short sampleSize; // 2 bytes
+   unsigned int streamTime; // 4 bytes
+   unsigned int chunkFrames; // 4 bytes
+   long long sampleCount; // 8 bytes
+   long long tableOffset; // 8 bytes, zero if recording was not closed
+   unsigned int chunkCount; // 4 bytes
+   unsigned int reserved; // 4 bytes
+};
+
+struct NFCZChunk
+{
+   char id[4]; // 4 bytes, "CHNK"
+   unsigned int size; // 4 bytes, encoded payload size
+   unsigned int frames; // 4 bytes, samples per channel
+};
+
+struct NFCZEntry
+{
+   long long offset; // 8 bytes, chunk header file offset
+   unsigned int size; // 4 bytes
+   unsigned int frames; // 4 bytes
+};
+
+/*
+ * float to PCM conversion kernels, scale is full range
+ */
+template<typename T>
+inline void convert(const float *src, T *dst, unsigned int count, float scale)
+{
+   unsigned int i = 0;
+
+   // full scale is not representable, highest value is scale - 1 or the largest float below scale when scale - 1 rounds to scale
+   float lower = -scale;
+   float upper = scale - 1 < scale ? scale - 1 : std::nextafter(scale, 0.0f);
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+   __m128 k = _mm_set1_ps(scale);
+   __m128 lo = _mm_set1_ps(lower);
+   __m128 hi = _mm_set1_ps(upper);
+
+   // clamp before conversion, out of range values would convert to INT_MIN
+   auto scaled = [k, lo, hi](const float *ptr) {
+      return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(ptr), k), lo), hi));
+   };
+
+   if constexpr (sizeof(T) == 1)
+   {
+      for (; i + 16 <= count; i += 16)
+      {
+         __m128i a = scaled(src + i + 0);
+         __m128i b = scaled(src + i + 4);
+         __m128i c = scaled(src + i + 8);
+         __m128i d = scaled(src + i + 12);
+
+         // saturated pack 32 bit to 8 bit
+         _mm_storeu_si128((__m128i *) (dst + i), _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+      }
+   }
+   else if constexpr (sizeof(T) == 2)
+   {
+      for (; i + 8 <= count; i += 8)
+      {
+         __m128i a = scaled(src + i + 0);
+         __m128i b = scaled(src + i + 4);
+
+         // saturated pack 32 bit to 16 bit
+         _mm_storeu_si128((__m128i *) (dst + i), _mm_packs_epi32(a, b));
+      }
+   }
+   else
+   {
+      for (; i + 4 <= count; i += 4)
+      {
+         _mm_storeu_si128((__m128i *) (dst + i), scaled(src + i));
+      }
+   }
+#endif
+
+   for (; i < count; i++)
+      dst[i] = (T) std::clamp(src[i] * scale, lower, upper);
+}
+
+/*
+ * Asynchronous file writer, staging blocks are written in order from a dedicated I/O thread
+ */
+struct AsyncWriter
+{
+   rt::Logger log {"AsyncWriter"};
+
+#ifdef USE_POSIX_IO
+   int fd = -1;
+#else
+   std::fstream file;
+#endif
+
+   std::thread thread;
+   std::mutex mutex;
+   std::condition_variable sync;
+
+   // blocks waiting to be written and free blocks
+   std::deque<rt::Buffer<unsigned char>> pending;
+   std::vector<rt::Buffer<unsigned char>> available;
+
+   // number of staging blocks allocated
+   int allocated = 0;
+
+   // I/O thread running flag and error status
+   bool running = false;
+   bool failed = false;
+
+   // next data write offset and end of reserved file space
+   long long writeOffset = 0;
+   long long reserved = 0;
+
+   // bytes queued but not yet written
+   std::atomic<long long> backlog {0};
+
+   // average write rate in bytes per second
+   std::atomic<double> rate {0};
+
+   rt::Throughput throughput;
+
+   ~AsyncWriter()
+   {
+      close();
+   }
+
+   bool open(const std::string &path, long long offset)
+   {
+#ifdef USE_POSIX_IO
+      fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+      if (fd < 0)
+         return false;
+#else
+      file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+
+      if (!file.is_open())
+         return false;
+#endif
+
+      writeOffset = offset;
+      reserved = 0;
+      failed = false;
+      running = true;
+      backlog = 0;
+      rate = 0;
+
+      thread = std::thread([this] { run(); });
+
+      return true;
+   }
+
+   void close()
+   {
+      if (thread.joinable())
+      {
+         {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            running = false;
+
+            sync.notify_all();
+         }
+
+         thread.join();
+      }
+
+#ifdef USE_POSIX_IO
+      if (fd >= 0)
+      {
+         ::close(fd);
+
+         fd = -1;
+      }
+#else
+      file.close();
+#endif
+
+      pending.clear();
+      available.clear();
+      allocated = 0;
+   }
+
+   bool isOpen() const
+   {
+#ifdef USE_POSIX_IO
+      return fd >= 0;
+#else
+      return file.is_open();
+#endif
+   }
+
+   bool isGood() const
+   {
+      return isOpen() && !failed;
+   }
+
+   /*
+    * Returns a free staging block, waiting for the I/O thread when all blocks are in flight
+    */
+   rt::Buffer<unsigned char> acquire()
+   {
+      std::unique_lock<std::mutex> lock(mutex);
+
+      if (available.empty() && allocated < STAGING_BLOCKS)
+      {
+         allocated++;
+
+         return rt::Buffer<unsigned char>(STAGING_SIZE);
+      }
+
+      sync.wait(lock, [this] { return !available.empty() || !running; });
+
+      if (available.empty())
+         return {};
+
+      auto block = available.back();
+
+      available.pop_back();
+
+      return block.clear();
+   }
+
+   /*
+    * Queue staging block for writing, block contents are [0, position)
+    */
+   void submit(rt::Buffer<unsigned char> &block)
+   {
+      block.flip();
+
+      std::lock_guard<std::mutex> lock(mutex);
+
+      backlog += block.limit();
+
+      pending.push_back(block);
+
+      sync.notify_all();
+   }
+
+   /*
+    * Wait until all queued blocks are written
+    */
+   void flush()
+   {
+      std::unique_lock<std::mutex> lock(mutex);
+
+      sync.wait(lock, [this] { return pending.empty() || !running; });
+   }
+
+   /*
+    * Synchronous write at given file offset, used for headers
+    */
+   bool writeAt(long long offset, const void *data, unsigned int size)
+   {
+#ifdef USE_POSIX_IO
+      auto ptr = static_cast<const char *>(data);
+
+      while (size > 0)
+      {
+         ssize_t written = pwrite(fd, ptr, size, offset);
+
+         if (written <= 0)
+            return false;
+
+         ptr += written;
+         offset += written;
+         size -= written;
+      }
+
+      return true;
+#else
+      file.seekp(offset);
+      file.write(static_cast<const char *>(data), size);
+
+      return file.good();
+#endif
+   }
+
+   void run()
+   {
+      log.debug("writer thread started");
+
+      std::unique_lock<std::mutex> lock(mutex);
+
+      while (true)
+      {
+         sync.wait(lock, [this] { return !pending.empty() || !running; });
+
+         if (pending.empty())
+            break;
+
+         auto block = pending.front();
+
+         lock.unlock();
+
+         throughput.begin();
+
+         reserve(writeOffset + block.limit());
+
+         if (!writeAt(writeOffset, block.data(), block.limit()))
+         {
+            if (!failed)
+               log.error("write failed at offset {}", {writeOffset});
+
+            failed = true;
+         }
+
+         writeOffset += block.limit();
+
+         throughput.update(block.limit());
+
+         rate = throughput.average();
+
+         lock.lock();
+
+         pending.pop_front();
+
+         available.push_back(block);
+
+         backlog -= block.limit();
+
+         sync.notify_all();
+      }
+
+      log.debug("writer thread finished");
+   }
+
+   /*
+    * Reserve file space ahead of writes to avoid fragmentation and metadata updates on each block
+    */
+   void reserve(long long offset)
+   {
+#if defined(USE_POSIX_IO) && defined(__linux__)
+      if (offset > reserved)
+      {
+         if (fallocate(fd, FALLOC_FL_KEEP_SIZE, reserved, offset - reserved + PREALLOCATE_SIZE) == 0)
+            reserved = offset + PREALLOCATE_SIZE;
+         else
+            reserved = LLONG_MAX; // not supported by filesystem, don't try again
+      }
+#endif
+   }
+};
+
+struct RecordDevice::Impl
+{
+   rt::Logger log {"RecordDevice"};
+
+   std::string name {};
+   std::string version {};
+   int fileDesc {};
+   int frequency {};
+   int openMode {};
+   int sampleRate {};
+   int sampleSize {};
+   int sampleType {};
+   long long sampleCount {};
+   long long sampleOffset {};
+   int channelCount {};
+   int streamTime {};
+
+   // data chunk location in file
+   long long dataStart {};
+   long long dataSize {};
+
+   // memory mapped file contents for read mode
+   unsigned char *mapData = nullptr;
+   size_t mapSize = 0;
+
+   // asynchronous writer and current staging block for write mode
+   AsyncWriter writer;
+   rt::Buffer<unsigned char> staging;
+
+   // recording file path
+   std::string path;
+
+   // block index, written as sidecar file
+   RecordIndex index;
+   bool indexEnabled = true;
+
+   // compressed recording state
+   bool compressed = false;
+   std::shared_ptr<CodecPool> codecPool;
+   std::vector<NFCZEntry> chunkTable;
+   std::vector<long long> chunkStart;
+
+   // chunk being filled and chunks waiting for compression in write mode
+   std::vector<short> chunkSamples;
+   std::deque<std::pair<unsigned int, std::future<std::vector<unsigned char>>>> encodeQueue;
+   long long chunkOffset = 0;
+
+   // chunks being decompressed ahead of read position and current decoded chunk in read mode
+   std::deque<std::future<rt::Buffer<float>>> decodeQueue;
+   rt::Buffer<float> chunkBuffer;
+   unsigned int nextChunk = 0;
+   unsigned int chunkSkip = 0;
+
+   std::fstream file;
+
+   explicit Impl(std::string name) : name(std::move(name)), sampleSize(16), sampleRate(44100), sampleType(1), channelCount(1)
+   {
+      log.debug("created RecordDevice for name [{}]", {this->name});
+   }
+
+   ~Impl()
+   {
+      close();
+
+      log.debug("destroy RecordDevice for name {}]", {name});
+   }
+
+   bool open(SignalDevice::OpenMode mode)
+   {
+      log.debug("open RecordDevice for name [{}]", {name});
+
+      if (name.find("://") != -1 && name.find("record://") == -1)
+      {
+         log.warn("invalid device name [{}]", {name});
+         return false;
+      }
+
+      std::string id = name.find("record://") == 0 ? name.substr(9) : name;
+
+      close();
+
+      openMode = mode;
+      path = id;
+      compressed = false;
+
+      // initialize
+      sampleCount = 0;
+      sampleOffset = 0;
+
+      switch (mode)
+      {
+         case SignalDevice::Write:
+         {
+            // compressed recordings are selected by file extension, always stored as 16 bit samples
+            compressed = id.size() > 5 && id.compare(id.size() - 5, 5, ".nfcz") == 0;
+
+            if (compressed)
+            {
+               sampleSize = 16;
+               chunkOffset = sizeof(NFCZHeader);
+               codecPool = std::make_shared<CodecPool>();
+            }
+
+            long long dataOffset = compressed ? sizeof(NFCZHeader) : sizeof(FILEHeader);
+
+            if (writer.open(id, dataOffset))
+            {
+               streamTime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+               if (!(compressed ? writeCompressedHeader(0) : writeHeader()))
+               {
+                  writer.close();
+               }
+
+               index = RecordIndex(INDEX_BLOCK, channelCount, sampleSize, sampleRate, dataOffset);
+            }
+
+            return writer.isOpen();
+         }
+
+         case SignalDevice::Read:
+         {
+            file.open(id, std::ios::in | std::ios::binary);
+
+            if (file.is_open())
+            {
+               if (!readCompressedHeader() && !readHeader())
+               {
+                  file.close();
+               }
+               else
+               {
+                  mapFile(id);
+
+                  // load existing index if present, otherwise is built on first use
+                  index = RecordIndex(INDEX_BLOCK, channelCount, sampleSize, sampleRate, dataStart);
+
+                  if (index.load(RecordIndex::path(id), sampleCount))
+                     log.debug("loaded index with {} blocks", {index.entries().size()});
+               }
+            }
+
+            return file.is_open();
+         }
+
+         case SignalDevice::Duplex:
+         {
+         }
+      }
+
+      return false;
+   }
+
+   void close()
+   {
+      // wait for running decompression jobs before releasing mapped file
+      clearDecodeQueue();
+
+      unmapFile();
+
+      if (writer.isOpen())
+      {
+         log.debug("close RecordDevice for name [{}]", {name});
+
+         // compress last partial chunk and store all pending chunks
+         if (compressed)
+         {
+            if (!chunkSamples.empty())
+               encodeChunk();
+
+            while (!encodeQueue.empty())
+               storeChunk();
+         }
+
+         // write last partial block and wait for pending writes
+         if (staging && staging.position())
+            writer.submit(staging);
+
+         staging.reset();
+
+         writer.flush();
+
+         if (compressed)
+            writeChunkTable();
+         else
+            writeHeader();
+
+         writer.close();
+
+         if (indexEnabled)
+         {
+            index.finish();
+
+            if (!index.save(RecordIndex::path(path)))
+               log.warn("unable to write index for name [{}]", {name});
+         }
+      }
+
+      if (file.is_open())
+      {
+         log.debug("close RecordDevice for name [{}]", {name});
+
+         file.close();
+      }
+
+      index = {};
+      codecPool.reset();
+      chunkTable.clear();
+      chunkStart.clear();
+      chunkSamples.clear();
+      chunkBuffer.reset();
+   }
+
+   bool isOpen() const
+   {
+      return file.is_open() || writer.isOpen();
+   }
+
+   bool isEof() const
+   {
+      if (compressed)
+         return sampleOffset >= sampleCount * channelCount;
+
+      if (mapData)
+         return sampleOffset >= dataSize / (sampleSize / 8);
+
+      return file.eof();
+   }
+
+   bool isReady() const
+   {
+      if (writer.isOpen())
+         return writer.isGood();
+
+      return file.good();
+   }
+
+   bool isStreaming() const
+   {
+      return false;
+   }
+
+   int read(SignalBuffer &buffer)
+   {
+      if (compressed)
+         return readCompressed(buffer);
+
+      if (mapData)
+      {
+         switch (sampleSize)
+         {
+            case 8:
+               return readMapped<char>(buffer);
+
+            case 16:
+               return readMapped<short>(buffer);
+
+            case 32:
+               return readMapped<int>(buffer);
+         }
+      }
+
+      switch (sampleSize)
+      {
+         case 8:
+            return readSamples<char>(buffer);
+
+         case 16:
+            return readSamples<short>(buffer);
+
+         case 32:
+            return readSamples<int>(buffer);
+      }
+
+      buffer.flip();
+
+      return buffer.limit();
+   }
+
+   int write(SignalBuffer &buffer)
+   {
+      if (compressed)
+         return writeCompressed(buffer);
+
+      switch (sampleSize)
+      {
+         case 8:
+            return writeSamples<char>(buffer);
+
+         case 16:
+            return writeSamples<short>(buffer);
+
+         case 32:
+            return writeSamples<int>(buffer);
+      }
+
+      return buffer.position();
+   }
+
+   template<typename T>
+   int readSamples(SignalBuffer &buffer)
+   {
+      T block[BUFFER_SIZE];
+
+      // converted samples
+      float vector[BUFFER_SIZE];
+
+      // sample scale from float
+      float scale = 1.0f / float(1u << (8 * sizeof(T) - 1));
+
+      while (buffer.available() && file)
+      {
+         // read one block of samples up to BUFFER_SIZE
+         file.read(reinterpret_cast<char *>(block), (buffer.available() < BUFFER_SIZE ? buffer.available() : BUFFER_SIZE) * sizeof(T));
+
+         // number of samples readed
+         int samples = file.gcount() / sizeof(T);
+
+         // convert readed samples to float
+         SignalKernel::convert(block, vector, samples, scale);
+
+         // and store in buffer
+         buffer.put(vector, samples);
+      }
+
+      buffer.flip();
+
+      sampleOffset += buffer.limit();
+
+      return buffer.limit();
+   }
+
+   template<typename T>
+   int readMapped(SignalBuffer &buffer)
+   {
+      // sample scale from float
+      float scale = 1.0f / float(1u << (8 * sizeof(T) - 1));
+
+      // total samples in data chunk
+      long long total = dataSize / (long long) sizeof(T);
+
+      auto samples = reinterpret_cast<const T *>(mapData + dataStart);
+
+      auto output = buffer.writable(buffer.available());
+
+      // number of samples to convert
+      unsigned int count = sampleOffset < total ? (unsigned int) std::min<long long>(output.size(), total - sampleOffset) : 0;
+
+      // convert directly from mapped file to destination buffer
+      SignalKernel::convert(samples + sampleOffset, output.data(), count, scale);
+
+      buffer.commit(count);
+
+      buffer.flip();
+
+      sampleOffset += buffer.limit();
+
+      // request kernel to prefetch next window
+      readAhead();
+
+      return buffer.limit();
+   }
+
+   void readAhead()
+   {
+#ifdef USE_POSIX_IO
+      long pageSize = sysconf(_SC_PAGESIZE);
+
+      // next byte offset to be read, aligned to page
+      size_t start = ((dataStart + sampleOffset * (sampleSize / 8)) / pageSize) * pageSize;
+
+      if (start < mapSize)
+      {
+         madvise(mapData + start, std::min<size_t>(READ_AHEAD, mapSize - start), MADV_WILLNEED);
+      }
+#endif
+   }
+
+   void mapFile(const std::string &path)
+   {
+#ifdef USE_POSIX_IO
+      int fd = ::open(path.c_str(), O_RDONLY);
+
+      if (fd < 0)
+         return;
+
+      struct stat st {};
+
+      if (fstat(fd, &st) == 0 && st.st_size >= dataStart + dataSize)
+      {
+         void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+         if (data != MAP_FAILED)
+         {
+            mapData = static_cast<unsigned char *>(data);
+            mapSize = st.st_size;
+
+            madvise(mapData, mapSize, MADV_SEQUENTIAL);
+
+            readAhead();
+
+            log.debug("file mapped in memory, {} bytes", {mapSize});
+         }
+      }
+
+      // mapping remains valid after descriptor is closed
+      ::close(fd);
+#endif
+   }
+
+   void unmapFile()
+   {
+#ifdef USE_POSIX_IO
+      if (mapData)
+      {
+         munmap(mapData, mapSize);
+
+         mapData = nullptr;
+         mapSize = 0;
+      }
+#endif
+   }
+
+   const RecordIndex &recordIndex()
+   {
+      if (index.isEmpty() && openMode == SignalDevice::Read && file.is_open())
+      {
+         log.info("building index for name [{}]", {name});
+
+         long long offset = sampleOffset;
+
+         seek(0);
+
+         while (!isEof())
+         {
+            SignalBuffer buffer(65536 * channelCount, channelCount, sampleRate, 0, 0, 0);
+
+            if (read(buffer) <= 0)
+               break;
+
+            index.update(buffer.data(), buffer.limit());
+         }
+
+         index.finish();
+
+         // restore read position
+         seek(offset / channelCount);
+
+         if (indexEnabled && !index.save(RecordIndex::path(path)))
+            log.warn("unable to write index for name [{}]", {name});
+      }
+
+      return index;
+   }
+
+   int seek(long long sample)
+   {
+      if (openMode != SignalDevice::Read || !file.is_open() || sample < 0 || sample > sampleCount)
+         return -1;
+
+      // sample offset is expressed in values, including all channels
+      sampleOffset = sample * channelCount;
+
+      if (compressed)
+      {
+         clearDecodeQueue();
+
+         // locate chunk containing requested sample, decoding restarts from there
+         auto it = std::upper_bound(chunkStart.begin(), chunkStart.end(), sample);
+
+         nextChunk = it != chunkStart.begin() ? (unsigned int) (it - chunkStart.begin() - 1) : 0;
+         chunkSkip = nextChunk < chunkStart.size() ? (unsigned int) (sample - chunkStart[nextChunk]) * channelCount : 0;
+      }
+      else if (!mapData)
+      {
+         file.clear();
+         file.seekg(dataStart + sampleOffset * (sampleSize / 8));
+      }
+      else
+      {
+         readAhead();
+      }
+
+      return 0;
+   }
+
+   template<typename T>
+   int writeSamples(SignalBuffer &buffer)
+   {
+      // sample scale to float
+      float scale = float(1u << (8 * sizeof(T) - 1));
+
+      auto input = buffer.readable();
+
+      unsigned int converted = 0;
+
+      while (converted < input.size())
+      {
+         // get next staging block, waits if all blocks are in flight
+         if (!staging && !(staging = writer.acquire()))
+         {
+            log.error("writer stopped, {} samples lost", {input.size() - converted});
+
+            return -1;
+         }
+
+         unsigned int count = std::min<unsigned int>(input.size() - converted, staging.available() / sizeof(T));
+
+         // convert float samples directly into staging block
+         convert(input.data() + converted, reinterpret_cast<T *>(staging.data() + staging.position()), count, scale);
+
+         staging.commit(count * sizeof(T));
+
+         converted += count;
+
+         // queue full staging block
+         if (staging.available() < sizeof(T))
+         {
+            writer.submit(staging);
+
+            staging.reset();
+         }
+      }
+
+      if (indexEnabled)
+         index.update(input.data(), converted);
+
+      sampleCount += converted / channelCount;
+      sampleOffset += converted;
+
+      return converted;
+   }
+
+   int writeCompressed(SignalBuffer &buffer)
+   {
+      auto input = buffer.readable();
+
+      unsigned int chunkSize = NFCZ_CHUNK_FRAMES * channelCount;
+
+      unsigned int converted = 0;
+
+      while (converted < input.size())
+      {
+         unsigned int start = chunkSamples.size();
+
+         unsigned int count = std::min<unsigned int>(input.size() - converted, chunkSize - start);
+
+         chunkSamples.resize(start + count);
+
+         convert(input.data() + converted, chunkSamples.data() + start, count, 32768.0f);
+
+         converted += count;
+
+         // compress full chunk in background
+         if (chunkSamples.size() == chunkSize)
+            encodeChunk();
+      }
+
+      if (indexEnabled)
+         index.update(input.data(), converted);
+
+      sampleCount += converted / channelCount;
+      sampleOffset += converted;
+
+      return converted;
+   }
+
+   /*
+    * Queue current chunk for compression, completed chunks are stored in submission order
+    */
+   void encodeChunk()
+   {
+      auto samples = std::make_shared<std::vector<short>>(std::move(chunkSamples));
+
+      unsigned int channels = channelCount;
+      unsigned int frames = samples->size() / channels;
+
+      chunkSamples = {};
+      chunkSamples.reserve(NFCZ_CHUNK_FRAMES * channels);
+
+      encodeQueue.emplace_back(frames, codecPool->submit<std::vector<unsigned char>>([samples, frames, channels] {
+         std::vector<unsigned char> data;
+         SampleCodec::encode(samples->data(), frames, channels, data);
+         return data;
+      }));
+
+      // store finished chunks, blocks only when codec threads can't keep up
+      while (!encodeQueue.empty())
+      {
+         if (encodeQueue.size() <= codecPool->threads() * NFCZ_QUEUE_DEPTH && encodeQueue.front().second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            break;
+
+         storeChunk();
+      }
+   }
+
+   void storeChunk()
+   {
+      auto frames = encodeQueue.front().first;
+      auto data = encodeQueue.front().second.get();
+
+      encodeQueue.pop_front();
+
+      NFCZChunk header {{'C', 'H', 'N', 'K'}, toLittleEndian<unsigned int>(data.size()), toLittleEndian<unsigned int>(frames)};
+
+      chunkTable.push_back({chunkOffset, (unsigned int) data.size(), frames});
+
+      writeBytes(&header, sizeof(header));
+      writeBytes(data.data(), data.size());
+
+      chunkOffset += sizeof(header) + data.size();
+   }
+
+   void writeBytes(const void *data, unsigned int size)
+   {
+      auto ptr = static_cast<const unsigned char *>(data);
+
+      while (size > 0)
+      {
+         if (!staging && !(staging = writer.acquire()))
+         {
+            log.error("writer stopped, {} bytes lost", {size});
+
+            return;
+         }
 
-struct DATAChunk
-{
-   chunk desc;
-};
+         unsigned int count = std::min(size, staging.available());
 
-struct FILEHeader
-{
-   RIFFChunk riff; // 12 bytes
-   WAVEChunk wave; // 24 bytes
-   LISTChunk list; // 8 bytes
-   DATAChunk data; // 8 bytes
-};
+         std::memcpy(staging.data() + staging.position(), ptr, count);
 
-struct RecordDevice::Impl
-{
-   rt::Logger log {"RecordDevice"};
+         staging.commit(count);
 
-   std::string name {};
-   std::string version {};
-   int fileDesc {};
-   int frequency {};
-   int openMode {};
-   int sampleRate {};
-   int sampleSize {};
-   int sampleType {};
-   int sampleCount {};
-   int sampleOffset {};
-   int channelCount {};
-   int streamTime {};
+         ptr += count;
+         size -= count;
 
-   std::fstream file;
+         if (!staging.available())
+         {
+            writer.submit(staging);
 
-   explicit Impl(std::string name) : name(std::move(name)), sampleSize(16), sampleRate(44100), sampleType(1), channelCount(1)
+            staging.reset();
+         }
+      }
+   }
+
+   bool writeChunkTable()
    {
-      log.debug("created RecordDevice for name [{}]", {this->name});
+      std::vector<NFCZEntry> table;
+
+      for (const auto &entry: chunkTable)
+      {
+         table.push_back({toLittleEndian<long long>(entry.offset), toLittleEndian<unsigned int>(entry.size), toLittleEndian<unsigned int>(entry.frames)});
+      }
+
+      if (!writer.writeAt(chunkOffset, table.data(), table.size() * sizeof(NFCZEntry)))
+         return false;
+
+      return writeCompressedHeader(chunkOffset);
    }
 
-   ~Impl()
+   bool writeCompressedHeader(long long tableOffset)
    {
-      close();
+      NFCZHeader header {{'N', 'F', 'C', 'Z'}};
 
-      log.debug("destroy RecordDevice for name {}]", {name});
+      log.debug("write RecordDevice compressed header for name [{}]", {name});
+
+      header.version = toLittleEndian<unsigned int>(1);
+      header.sampleRate = toLittleEndian<unsigned int>(sampleRate);
+      header.channelCount = toLittleEndian<unsigned short>(channelCount);
+      header.sampleSize = toLittleEndian<unsigned short>(sampleSize);
+      header.streamTime = toLittleEndian<unsigned int>(streamTime);
+      header.chunkFrames = toLittleEndian<unsigned int>(NFCZ_CHUNK_FRAMES);
+      header.sampleCount = toLittleEndian<long long>(sampleCount);
+      header.tableOffset = toLittleEndian<long long>(tableOffset);
+      header.chunkCount = toLittleEndian<unsigned int>(tableOffset ? chunkTable.size() : 0);
+
+      return writer.writeAt(0, &header, sizeof(header));
    }
 
-   bool open(SignalDevice::OpenMode mode)
+   bool readCompressedHeader()
    {
-      log.debug("open RecordDevice for name [{}]", {name});
+      NFCZHeader header {};
 
-      if (name.find("://") != -1 && name.find("record://") == -1)
+      file.seekg(0);
+
+      if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) || std::memcmp(header.id, "NFCZ", 4) != 0)
       {
-         log.warn("invalid device name [{}]", {name});
+         file.clear();
          return false;
       }
 
-      std::string id = name.find("record://") == 0 ? name.substr(9) : name;
-
-      close();
+      log.debug("read RecordDevice compressed header for name [{}]", {name});
 
-      openMode = mode;
+      if (fromLittleEndian<unsigned int>(header.version) != 1 || fromLittleEndian<unsigned short>(header.sampleSize) != 16)
+         return false;
 
-      // initialize
-      sampleCount = 0;
-      sampleOffset = 0;
+      unsigned int channels = fromLittleEndian<unsigned short>(header.channelCount);
 
-      switch (mode)
+      if (channels != 1 && channels != 2)
       {
-         case SignalDevice::Write:
-         {
-            file.open(id, std::ios::out | std::ios::binary | std::ios::trunc);
+         log.error("invalid channel count {} in file [{}]", {channels, name});
+         return false;
+      }
 
-            if (file.is_open())
-            {
-               streamTime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+      compressed = true;
+      sampleType = SignalDevice::Integer;
+      sampleSize = 16;
+      sampleRate = fromLittleEndian<unsigned int>(header.sampleRate);
+      channelCount = channels;
+      streamTime = fromLittleEndian<unsigned int>(header.streamTime);
+      dataStart = sizeof(NFCZHeader);
+      dataSize = 0;
 
-               if (!writeHeader())
-               {
-                  file.close();
-               }
-            }
+      long long tableOffset = fromLittleEndian<long long>(header.tableOffset);
+      unsigned int chunkCount = fromLittleEndian<unsigned int>(header.chunkCount);
+      unsigned int chunkFrames = std::min<unsigned int>(fromLittleEndian<unsigned int>(header.chunkFrames), NFCZ_CHUNK_FRAMES);
 
-            return file.is_open();
-         }
+      file.seekg(0, std::ios_base::end);
 
-         case SignalDevice::Read:
-         {
-            file.open(id, std::ios::in | std::ios::binary);
+      long long length = file.tellg();
 
-            if (file.is_open())
-            {
-               if (!readHeader())
-               {
-                  file.close();
-               }
-            }
+      if (tableOffset == 0)
+      {
+         log.warn("compressed file was not closed properly, scanning chunks");
 
-            return file.is_open();
-         }
+         scanChunkTable(length, chunkFrames);
+      }
+      else if (!readChunkTable(length, tableOffset, chunkCount, chunkFrames))
+      {
+         log.warn("invalid chunk table in file [{}], scanning chunks", {name});
 
-         case SignalDevice::Duplex:
-         {
-         }
+         scanChunkTable(length, chunkFrames);
       }
 
-      return false;
-   }
+      // first sample of each chunk, used for seek
+      chunkStart.clear();
 
-   void close()
-   {
-      if (file.is_open())
-      {
-         log.debug("close RecordDevice for name [{}]", {name});
+      sampleCount = 0;
 
-         if (openMode == SignalDevice::Write)
-         {
-            writeHeader();
-         }
+      for (const auto &entry: chunkTable)
+      {
+         chunkStart.push_back(sampleCount);
 
-         file.close();
+         sampleCount += entry.frames;
       }
-   }
 
-   bool isOpen() const
-   {
-      return file.is_open();
-   }
+      sampleOffset = 0;
+      nextChunk = 0;
+      chunkSkip = 0;
 
-   bool isEof() const
-   {
-      return file.eof();
+      return true;
    }
 
-   bool isReady() const
+   /*
+    * Load chunk table from end of file, header values are checked before any allocation
+    */
+   bool readChunkTable(long long length, long long tableOffset, unsigned int chunkCount, unsigned int chunkFrames)
    {
-      return file.good();
-   }
+      chunkTable.clear();
 
-   bool isStreaming() const
-   {
-      return false;
-   }
+      // table fills the rest of file after last chunk
+      if (tableOffset < (long long) sizeof(NFCZHeader) || tableOffset > length || (long long) chunkCount * (long long) sizeof(NFCZEntry) != length - tableOffset)
+         return false;
 
-   int read(SignalBuffer &buffer)
-   {
-      switch (sampleSize)
+      std::vector<NFCZEntry> table(chunkCount);
+
+      file.seekg(tableOffset);
+
+      if (!file.read(reinterpret_cast<char *>(table.data()), chunkCount * sizeof(NFCZEntry)))
       {
-         case 8:
-            return readSamples<char>(buffer);
+         file.clear();
+         return false;
+      }
 
-         case 16:
-            return readSamples<short>(buffer);
+      for (auto &entry: table)
+      {
+         entry.offset = fromLittleEndian<long long>(entry.offset);
+         entry.size = fromLittleEndian<unsigned int>(entry.size);
+         entry.frames = fromLittleEndian<unsigned int>(entry.frames);
 
-         case 32:
-            return readSamples<int>(buffer);
+         // chunks are stored between header and table
+         if (entry.frames > chunkFrames || entry.offset < (long long) sizeof(NFCZHeader) || entry.offset + (long long) sizeof(NFCZChunk) + entry.size > tableOffset)
+            return false;
       }
 
-      buffer.flip();
+      chunkTable = std::move(table);
 
-      return buffer.limit();
+      return true;
    }
 
-   int write(SignalBuffer &buffer)
+   /*
+    * Rebuild chunk table from all complete chunks found after header
+    */
+   void scanChunkTable(long long length, unsigned int chunkFrames)
    {
-      switch (sampleSize)
+      NFCZChunk chunk {};
+
+      long long offset = sizeof(NFCZHeader);
+
+      chunkTable.clear();
+
+      file.clear();
+      file.seekg(offset);
+
+      while (file.read(reinterpret_cast<char *>(&chunk), sizeof(chunk)) && std::memcmp(chunk.id, "CHNK", 4) == 0)
       {
-         case 8:
-            return writeSamples<char>(buffer);
+         unsigned int size = fromLittleEndian<unsigned int>(chunk.size);
+         unsigned int frames = fromLittleEndian<unsigned int>(chunk.frames);
 
-         case 16:
-            return writeSamples<short>(buffer);
+         if (frames > chunkFrames || offset + (long long) sizeof(chunk) + size > length || !file.seekg(size, std::ios_base::cur))
+            break;
 
-         case 32:
-            return writeSamples<int>(buffer);
+         chunkTable.push_back({offset, size, frames});
+
+         offset += sizeof(chunk) + size;
       }
 
-      return buffer.position();
+      file.clear();
    }
 
-   template<typename T>
-   int readSamples(SignalBuffer &buffer)
+   int readCompressed(SignalBuffer &buffer)
    {
-      T block[BUFFER_SIZE];
-
-      // converted samples
-      float vector[BUFFER_SIZE];
+      auto output = buffer.writable(buffer.available());
 
-      // sample scale from float
-      float scale = 1 << (8 * sizeof(T) - 1);
+      unsigned int copied = 0;
 
-      while (buffer.available() && file)
+      while (copied < output.size())
       {
-         // read one block of samples up to BUFFER_SIZE
-         file.read(reinterpret_cast<char *>(block), (buffer.available() < BUFFER_SIZE ? buffer.available() : BUFFER_SIZE) * sizeof(T));
+         // take next decoded chunk
+         if (!chunkBuffer || !chunkBuffer.available())
+         {
+            fillDecodeQueue();
 
-         // number of samples readed
-         int samples = file.gcount() / sizeof(T);
+            if (decodeQueue.empty())
+               break;
 
-         // convert readed samples to float
-         for (int i = 0; i < samples; i++)
-         {
-            vector[i] = fromLittleEndian<T>(block[i]) / scale;
+            chunkBuffer = decodeQueue.front().get();
+
+            decodeQueue.pop_front();
+
+            fillDecodeQueue();
+
+            if (!chunkBuffer)
+            {
+               log.error("corrupted chunk in file [{}]", {name});
+
+               // stop reading
+               sampleOffset = sampleCount * channelCount;
+
+               break;
+            }
+
+            // discard samples before seek position
+            if (chunkSkip)
+            {
+               chunkBuffer.advance(std::min(chunkSkip, chunkBuffer.available()));
+
+               chunkSkip = 0;
+            }
          }
 
-         // and store in buffer
-         buffer.put(vector, samples);
+         auto chunk = chunkBuffer.readable();
+
+         unsigned int count = std::min<unsigned int>(output.size() - copied, chunk.size());
+
+         std::copy_n(chunk.data(), count, output.data() + copied);
+
+         chunkBuffer.advance(count);
+
+         copied += count;
       }
 
+      buffer.commit(copied);
+
       buffer.flip();
 
       sampleOffset += buffer.limit();
@@ -289,44 +1383,70 @@ struct RecordDevice::Impl
       return buffer.limit();
    }
 
-   template<typename T>
-   int writeSamples(SignalBuffer &buffer)
+   /*
+    * Submit decompression of next chunks to codec threads
+    */
+   void fillDecodeQueue()
    {
-      T block[BUFFER_SIZE];
+      if (!codecPool)
+         codecPool = std::make_shared<CodecPool>();
 
-      // sample scale to float
-      float scale = 1 << (8 * sizeof(T) - 1);
+      while (decodeQueue.size() < codecPool->threads() * NFCZ_QUEUE_DEPTH && nextChunk < chunkTable.size())
+      {
+         const NFCZEntry &entry = chunkTable[nextChunk++];
 
-      // number of samples converted
-      int converted = 0;
+         unsigned int channels = channelCount;
+         unsigned int frames = entry.frames;
+         unsigned int size = entry.size;
 
-      // process all buffer contents
-      buffer.stream([this, &scale, &converted, &block](const float *value, int stride) {
+         // chunk payload is decoded directly from mapped file, otherwise read here
+         const unsigned char *data = nullptr;
 
-         for (int c = 0; c < stride; c++)
+         std::shared_ptr<std::vector<unsigned char>> storage;
+
+         if (mapData && entry.offset + sizeof(NFCZChunk) + size <= mapSize)
+         {
+            data = mapData + entry.offset + sizeof(NFCZChunk);
+         }
+         else
          {
-            // convert float sample to WAV sample
-            block[converted++] = toLittleEndian<T>((T) (value[c] * scale));
+            storage = std::make_shared<std::vector<unsigned char>>(size);
 
-            // write buffered block
-            if (converted == BUFFER_SIZE)
-            {
-               file.write(reinterpret_cast<const char *>(block), sizeof(block));
-               converted = 0;
-            }
+            file.clear();
+            file.seekg(entry.offset + sizeof(NFCZChunk));
+            file.read(reinterpret_cast<char *>(storage->data()), size);
+
+            data = storage->data();
          }
-      });
 
-      // write last remaining block
-      if (converted)
+         decodeQueue.push_back(codecPool->submit<rt::Buffer<float>>([data, storage, size, frames, channels] {
+            std::vector<short> samples(frames * channels);
+
+            if (!SampleCodec::decode(data, size, samples.data(), frames, channels))
+               return rt::Buffer<float>();
+
+            rt::Buffer<float> result(frames * channels);
+
+            SignalKernel::convert(samples.data(), result.writable(samples.size()).data(), samples.size(), 1.0f / 32768.0f);
+
+            result.commit(samples.size());
+
+            return result.flip();
+         }));
+      }
+   }
+
+   void clearDecodeQueue()
+   {
+      // jobs may reference mapped file, wait until all finish
+      for (auto &future: decodeQueue)
       {
-         file.write(reinterpret_cast<const char *>(block), converted * sizeof(T));
+         future.wait();
       }
 
-      sampleCount += buffer.position();
-      sampleOffset += buffer.position();
+      decodeQueue.clear();
 
-      return buffer.position();
+      chunkBuffer.reset();
    }
 
    bool readHeader()
@@ -342,12 +1462,15 @@ struct RecordDevice::Impl
       if (!file.read(reinterpret_cast<char *>(&riff), sizeof(riff)))
          return false;
 
-      if (std::memcmp(&riff.desc.id, "RIFF", 4) != 0)
+      if (std::memcmp(&riff.desc.id, "RIFF", 4) != 0 && std::memcmp(&riff.desc.id, "RF64", 4) != 0)
          return false;
 
       if (std::memcmp(&riff.type, "WAVE", 4) != 0)
          return false;
 
+      // 64 bit data size from RF64 ds64 chunk
+      long long dataSize64 = -1;
+
       chunk entry {};
 
       while (file.read(reinterpret_cast<char *>(&entry), sizeof(chunk)))
@@ -407,12 +1530,34 @@ struct RecordDevice::Impl
             // if not date found, skip remain list chuck
             if (!file.seekg(entry.size, std::ios_base::cur))
                return false;
+         }
+            // process RF64 size chunk
+         else if (std::memcmp(&entry.id, "ds64", 4) == 0)
+         {
+            DS64Chunk ds64 {};
+
+            if (entry.size < sizeof(ds64) - 8)
+               return false;
+
+            file.seekg(-(int) sizeof(chunk), std::ios_base::cur);
+
+            if (!file.read(reinterpret_cast<char *>(&ds64), sizeof(ds64)))
+               return false;
+
+            if (!file.seekg(entry.size - (sizeof(ds64) - 8), std::ios_base::cur))
+               return false;
+
+            dataSize64 = (long long) fromLittleEndian<unsigned int>(ds64.dataSizeHigh) << 32 | fromLittleEndian<unsigned int>(ds64.dataSizeLow);
          }
             // process DATA chuck
          else if (std::memcmp(&entry.id, "data", 4) == 0)
          {
+            // data location, used for seek and memory mapped read
+            dataStart = file.tellg();
+            dataSize = entry.size == RIFF_MAX_SIZE && dataSize64 >= 0 ? dataSize64 : entry.size;
+
             // initialize values
-            sampleCount = entry.size / (channelCount * sampleSize / 8);
+            sampleCount = dataSize / (channelCount * sampleSize / 8);
             sampleOffset = 0;
 
             if (streamTime == 0)
@@ -420,17 +1565,18 @@ struct RecordDevice::Impl
                log.info("the file does not have a timestamp stored, it will default to the creation date");
 
                // read default stream time from file creation date
-               if (stat(name.c_str(), &st) == 0)
+               if (stat(path.c_str(), &st) == 0)
                   streamTime = st.st_ctime;
             }
 
             return true;
          }
 
-            // unknown chuck
+            // skip unknown chuck, including JUNK padding reserved for ds64
          else
          {
-            break;
+            if (!file.seekg(entry.size + (entry.size & 1), std::ios_base::cur))
+               return false;
          }
       }
 
@@ -441,6 +1587,7 @@ struct RecordDevice::Impl
    {
       FILEHeader header = {
             {{{'R', 'I', 'F', 'F'}, 0}, {'W', 'A', 'V', 'E'}},
+            {{{'J', 'U', 'N', 'K'}, 0}, 0, 0, 0, 0, 0, 0, 0},
             {{{'f', 'm', 't', ' '}, 0}, 0, 0, 0, 0, 0, 0},
             {{{'L', 'I', 'S', 'T'}, 0}, {{'d', 'a', 't', 'e'}, 0}},
             {{{'d', 'a', 't', 'a'}, 0}}
@@ -448,11 +1595,35 @@ struct RecordDevice::Impl
 
       log.debug("write RecordDevice header for name [{}]", {name});
 
-      // get current file offset written
-      int length = file.tellp();
+      // get current file length, header and written samples
+      long long length = sizeof(FILEHeader) + (long long) sampleCount * channelCount * (sampleSize / 8);
+
+      long long riffSize = length > sizeof(RIFFChunk) ? length - sizeof(RIFFChunk) + 4 : 0;
+      long long dataSize = length > sizeof(FILEHeader) ? length - sizeof(FILEHeader) : 0;
+
+      // reserved space for ds64 chunk
+      header.ds64.desc.size = toLittleEndian<unsigned int>(sizeof(DS64Chunk) - 8);
 
-      // calculate overall file size
-      header.riff.desc.size = toLittleEndian<unsigned int>(length > sizeof(RIFFChunk) ? length - sizeof(RIFFChunk) + 4 : 0);
+      // promote to RF64 when sizes do not fit in 32 bits
+      if (riffSize > RIFF_MAX_SIZE)
+      {
+         log.info("file size exceeds 4GB, writing RF64 header");
+
+         std::memcpy(header.riff.desc.id, "RF64", 4);
+         std::memcpy(header.ds64.desc.id, "ds64", 4);
+
+         header.riff.desc.size = toLittleEndian<unsigned int>(RIFF_MAX_SIZE);
+         header.ds64.riffSizeLow = toLittleEndian<unsigned int>(riffSize & 0xFFFFFFFF);
+         header.ds64.riffSizeHigh = toLittleEndian<unsigned int>(riffSize >> 32);
+         header.ds64.dataSizeLow = toLittleEndian<unsigned int>(dataSize & 0xFFFFFFFF);
+         header.ds64.dataSizeHigh = toLittleEndian<unsigned int>(dataSize >> 32);
+         header.ds64.sampleCountLow = toLittleEndian<unsigned int>(sampleCount & 0xFFFFFFFF);
+         header.ds64.sampleCountHigh = toLittleEndian<unsigned int>(sampleCount >> 32);
+      }
+      else
+      {
+         header.riff.desc.size = toLittleEndian<unsigned int>(riffSize);
+      }
 
       // update wave format chunk
       header.wave.desc.size = toLittleEndian<unsigned int>(16);
@@ -468,15 +1639,10 @@ struct RecordDevice::Impl
       header.list.time.epoch = toLittleEndian<unsigned int>(streamTime);
 
       // update data format chunk
-      header.data.desc.size = toLittleEndian<unsigned int>(length > sizeof(FILEHeader) ? length - sizeof(FILEHeader) : 0);
+      header.data.desc.size = toLittleEndian<unsigned int>(dataSize > RIFF_MAX_SIZE ? RIFF_MAX_SIZE : dataSize);
 
-      // jump to file start
-      file.seekp(0);
-
-      // write file header
-      file.write(reinterpret_cast<char *>(&header), sizeof(header));
-
-      return file.good();
+      // write file header at file start
+      return writer.writeAt(0, &header, sizeof(header));
    }
 
    template<typename T>
@@ -536,16 +1702,51 @@ bool RecordDevice::isStreaming() const
    return impl->isStreaming();
 }
 
-int RecordDevice::sampleCount() const
+long long RecordDevice::sampleCount() const
 {
    return impl->sampleCount;
 }
 
-int RecordDevice::sampleOffset() const
+long long RecordDevice::sampleOffset() const
 {
    return impl->sampleOffset;
 }
 
+long long RecordDevice::writeBacklog() const
+{
+   return impl->writer.backlog;
+}
+
+double RecordDevice::writeRate() const
+{
+   return impl->writer.rate;
+}
+
+int RecordDevice::seek(long long sample)
+{
+   return impl->seek(sample);
+}
+
+const RecordIndex &RecordDevice::index() const
+{
+   return impl->recordIndex();
+}
+
+bool RecordDevice::isIndexEnabled() const
+{
+   return impl->indexEnabled;
+}
+
+void RecordDevice::setIndexEnabled(bool enabled)
+{
+   impl->indexEnabled = enabled;
+}
+
+int RecordDevice::seekTime(double time)
+{
+   return impl->seek((long long) (time * impl->sampleRate));
+}
+
 int RecordDevice::sampleSize() const
 {
    return impl->sampleSize;
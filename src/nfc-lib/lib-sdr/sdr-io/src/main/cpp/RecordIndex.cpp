@@ -0,0 +1,244 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cmath>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+#include <sdr/RecordIndex.h>
+
+// minimum mean envelope for a block to be considered with carrier
+#define CARRIER_LEVEL 0.01f
+
+namespace sdr {
+
+struct IndexHeader
+{
+   char magic[4]; // "NFCI"
+   unsigned int version; // index format version
+   unsigned int blockSize; // samples per block, per channel
+   unsigned int channelCount; // recording channels
+   unsigned int sampleSize; // recording sample size in bits
+   unsigned int sampleRate; // recording sample rate
+   long long sampleCount; // recording samples, per channel
+   long long entryCount; // number of index entries
+};
+
+struct RecordIndex::Impl
+{
+   unsigned int blockSize = 0;
+   unsigned int channelCount = 1;
+   unsigned int sampleSize = 16;
+   unsigned int sampleRate = 0;
+   long long dataStart = 0;
+
+   // indexed samples, per channel
+   long long sampleCount = 0;
+
+   std::vector<Entry> entries;
+
+   // current block accumulators
+   unsigned int blockSamples = 0;
+   float blockMinimum = 0;
+   float blockMaximum = 0;
+   double blockSum = 0;
+
+   void update(const float *samples, unsigned int count)
+   {
+      for (unsigned int i = 0; i + channelCount <= count; i += channelCount)
+      {
+         // signal envelope, magnitude for IQ or absolute value for real samples
+         float value = channelCount == 2 ? std::sqrt(samples[i] * samples[i] + samples[i + 1] * samples[i + 1]) : std::fabs(samples[i]);
+
+         if (blockSamples == 0)
+         {
+            blockMinimum = value;
+            blockMaximum = value;
+            blockSum = 0;
+         }
+
+         blockMinimum = std::min(blockMinimum, value);
+         blockMaximum = std::max(blockMaximum, value);
+         blockSum += value;
+
+         if (++blockSamples == blockSize)
+            finish();
+      }
+   }
+
+   void finish()
+   {
+      if (blockSamples == 0)
+         return;
+
+      long long first = sampleCount;
+
+      Entry entry {};
+
+      entry.sampleOffset = first;
+      entry.byteOffset = dataStart + first * channelCount * (sampleSize / 8);
+      entry.minimum = blockMinimum;
+      entry.maximum = blockMaximum;
+      entry.average = float(blockSum / blockSamples);
+      entry.flags = entry.average > CARRIER_LEVEL ? Carrier : 0;
+
+      entries.push_back(entry);
+
+      sampleCount += blockSamples;
+      blockSamples = 0;
+   }
+};
+
+RecordIndex::RecordIndex() : impl(std::make_shared<Impl>())
+{
+}
+
+RecordIndex::RecordIndex(unsigned int blockSize, unsigned int channelCount, unsigned int sampleSize, unsigned int sampleRate, long long dataStart) : impl(std::make_shared<Impl>())
+{
+   impl->blockSize = blockSize;
+   impl->channelCount = channelCount;
+   impl->sampleSize = sampleSize;
+   impl->sampleRate = sampleRate;
+   impl->dataStart = dataStart;
+}
+
+bool RecordIndex::isEmpty() const
+{
+   return impl->entries.empty();
+}
+
+unsigned int RecordIndex::blockSize() const
+{
+   return impl->blockSize;
+}
+
+long long RecordIndex::sampleCount() const
+{
+   return impl->sampleCount;
+}
+
+const std::vector<RecordIndex::Entry> &RecordIndex::entries() const
+{
+   return impl->entries;
+}
+
+int RecordIndex::find(long long sample) const
+{
+   if (sample < 0 || sample >= impl->sampleCount || !impl->blockSize)
+      return -1;
+
+   // all blocks are full except last one
+   return (int) (sample / impl->blockSize);
+}
+
+long long RecordIndex::nextCarrier(long long sample) const
+{
+   int index = find(sample);
+
+   if (index < 0)
+      return -1;
+
+   for (int i = index; i < impl->entries.size(); i++)
+   {
+      if (impl->entries[i].flags & Carrier)
+         return i == index ? sample : impl->entries[i].sampleOffset;
+   }
+
+   return -1;
+}
+
+void RecordIndex::update(const float *samples, unsigned int count)
+{
+   impl->update(samples, count);
+}
+
+void RecordIndex::finish()
+{
+   impl->finish();
+}
+
+void RecordIndex::clear()
+{
+   impl->entries.clear();
+   impl->sampleCount = 0;
+   impl->blockSamples = 0;
+}
+
+bool RecordIndex::load(const std::string &file, long long sampleCount)
+{
+   std::ifstream stream(file, std::ios::in | std::ios::binary);
+
+   if (!stream.is_open())
+      return false;
+
+   IndexHeader header {};
+
+   if (!stream.read(reinterpret_cast<char *>(&header), sizeof(header)))
+      return false;
+
+   if (std::memcmp(header.magic, "NFCI", 4) != 0 || header.version != 1)
+      return false;
+
+   // index must match current recording layout
+   if (header.blockSize != impl->blockSize || header.channelCount != impl->channelCount || header.sampleSize != impl->sampleSize || header.sampleRate != impl->sampleRate || header.sampleCount != sampleCount)
+      return false;
+
+   // one entry per block, last one may be partial, checked before allocating from untrusted size
+   if (header.blockSize == 0 || header.entryCount < 0 || header.entryCount != (header.sampleCount + header.blockSize - 1) / header.blockSize)
+      return false;
+
+   std::vector<Entry> entries(header.entryCount);
+
+   if (!stream.read(reinterpret_cast<char *>(entries.data()), entries.size() * sizeof(Entry)))
+      return false;
+
+   impl->entries = std::move(entries);
+   impl->sampleCount = header.sampleCount;
+   impl->blockSamples = 0;
+
+   return true;
+}
+
+bool RecordIndex::save(const std::string &file) const
+{
+   std::ofstream stream(file, std::ios::out | std::ios::binary | std::ios::trunc);
+
+   if (!stream.is_open())
+      return false;
+
+   IndexHeader header {{'N', 'F', 'C', 'I'}, 1, impl->blockSize, impl->channelCount, impl->sampleSize, impl->sampleRate, impl->sampleCount, (long long) impl->entries.size()};
+
+   stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+   stream.write(reinterpret_cast<const char *>(impl->entries.data()), impl->entries.size() * sizeof(Entry));
+
+   return stream.good();
+}
+
+std::string RecordIndex::path(const std::string &file)
+{
+   return file + ".idx";
+}
+
+}
@@ -0,0 +1,381 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <condition_variable>
+
+#include "SampleCodec.h"
+
+// samples per Rice partition
+#define PARTITION_SIZE 256
+
+// maximum fixed predictor order
+#define MAX_ORDER 3
+
+// unary quotient limit, larger values are stored raw
+#define ESCAPE_CODE 24
+
+// maximum codec threads
+#define MAX_THREADS 4
+
+namespace sdr {
+
+/*
+ * MSB-first bit writer
+ */
+struct BitWriter
+{
+   std::vector<unsigned char> &output;
+
+   uint64_t value = 0;
+   int count = 0;
+
+   explicit BitWriter(std::vector<unsigned char> &output) : output(output)
+   {
+   }
+
+   inline void put(uint32_t bits, int length)
+   {
+      value = (value << length) | bits;
+      count += length;
+
+      while (count >= 8)
+      {
+         count -= 8;
+         output.push_back((unsigned char) (value >> count));
+      }
+   }
+
+   inline void flush()
+   {
+      if (count > 0)
+         put(0, 8 - count);
+   }
+};
+
+/*
+ * MSB-first bit reader
+ */
+struct BitReader
+{
+   const unsigned char *data;
+   unsigned int size;
+   uint64_t position = 0; // in bits
+
+   BitReader(const unsigned char *data, unsigned int size) : data(data), size(size)
+   {
+   }
+
+   // next 64 bits from current position
+   inline uint64_t window() const
+   {
+      uint64_t offset = position >> 3;
+      uint64_t value = 0;
+
+      if (offset + 8 <= size)
+      {
+         std::memcpy(&value, data + offset, 8);
+         value = __builtin_bswap64(value);
+      }
+      else
+      {
+         for (int i = 0; i < 8; i++)
+            value = (value << 8) | (offset + i < size ? data[offset + i] : 0);
+      }
+
+      return value << (position & 7);
+   }
+
+   inline uint32_t get(int length)
+   {
+      uint32_t bits = (uint32_t) (window() >> (64 - length));
+
+      position += length;
+
+      return bits;
+   }
+
+   // count zeros before next one bit, up to limit
+   inline int zeros(int limit)
+   {
+      uint64_t w = window();
+
+      int n = w ? __builtin_clzll(w) : 64;
+
+      if (n >= limit)
+      {
+         position += limit;
+         return limit;
+      }
+
+      position += n + 1;
+
+      return n;
+   }
+
+   inline bool overflow() const
+   {
+      return position > (uint64_t) size * 8;
+   }
+};
+
+inline uint32_t zigzag(int32_t value)
+{
+   return (uint32_t) (value << 1) ^ (uint32_t) (value >> 31);
+}
+
+inline int32_t unzigzag(uint32_t value)
+{
+   return (int32_t) (value >> 1) ^ -(int32_t) (value & 1);
+}
+
+// fixed polynomial predictors
+inline int32_t predict(int order, const int32_t *x, int i)
+{
+   switch (order)
+   {
+      case 1:
+         return x[i - 1];
+      case 2:
+         return 2 * x[i - 1] - x[i - 2];
+      case 3:
+         return 3 * x[i - 1] - 3 * x[i - 2] + x[i - 3];
+      default:
+         return 0;
+   }
+}
+
+void SampleCodec::encode(const short *samples, unsigned int frames, unsigned int channels, std::vector<unsigned char> &output)
+{
+   BitWriter writer(output);
+
+   std::vector<int32_t> x(frames);
+   std::vector<uint32_t> r(frames);
+
+   for (unsigned int c = 0; c < channels; c++)
+   {
+      // deinterleave channel
+      for (unsigned int i = 0; i < frames; i++)
+         x[i] = samples[i * channels + c];
+
+      // select predictor with lowest residual energy
+      int order = 0;
+      uint64_t best = UINT64_MAX;
+
+      for (int o = 0; o <= MAX_ORDER && o < (int) frames; o++)
+      {
+         uint64_t sum = 0;
+
+         for (unsigned int i = o; i < frames; i++)
+            sum += std::abs(x[i] - predict(o, x.data(), i));
+
+         if (sum < best)
+         {
+            best = sum;
+            order = o;
+         }
+      }
+
+      writer.put(order, 2);
+
+      // warm-up samples
+      for (int i = 0; i < order && i < frames; i++)
+         writer.put((uint16_t) x[i], 16);
+
+      for (unsigned int i = order; i < frames; i++)
+         r[i] = zigzag(x[i] - predict(order, x.data(), i));
+
+      // Rice coded partitions
+      for (unsigned int p = order; p < frames; p += PARTITION_SIZE)
+      {
+         unsigned int end = std::min<unsigned int>(p + PARTITION_SIZE, frames);
+
+         uint64_t sum = 0;
+
+         for (unsigned int i = p; i < end; i++)
+            sum += r[i];
+
+         // Rice parameter from partition mean
+         uint64_t mean = sum / (end - p);
+
+         int k = 0;
+
+         while (k < 30 && (1ull << (k + 1)) <= mean + 1)
+            k++;
+
+         writer.put(k, 5);
+
+         for (unsigned int i = p; i < end; i++)
+         {
+            uint32_t q = r[i] >> k;
+
+            if (q < ESCAPE_CODE)
+            {
+               writer.put(1, q + 1);
+
+               if (k)
+                  writer.put(r[i] & ((1u << k) - 1), k);
+            }
+            else
+            {
+               writer.put(0, ESCAPE_CODE);
+               writer.put(r[i], 32);
+            }
+         }
+      }
+   }
+
+   writer.flush();
+}
+
+bool SampleCodec::decode(const unsigned char *data, unsigned int size, short *samples, unsigned int frames, unsigned int channels)
+{
+   BitReader reader(data, size);
+
+   std::vector<int32_t> x(frames);
+
+   for (unsigned int c = 0; c < channels; c++)
+   {
+      int order = (int) reader.get(2);
+
+      for (int i = 0; i < order && i < frames; i++)
+         x[i] = (int16_t) reader.get(16);
+
+      for (unsigned int p = order; p < frames; p += PARTITION_SIZE)
+      {
+         unsigned int end = std::min<unsigned int>(p + PARTITION_SIZE, frames);
+
+         int k = (int) reader.get(5);
+
+         for (unsigned int i = p; i < end; i++)
+         {
+            uint32_t u;
+
+            int q = reader.zeros(ESCAPE_CODE);
+
+            if (q < ESCAPE_CODE)
+               u = ((uint32_t) q << k) | (k ? reader.get(k) : 0);
+            else
+               u = reader.get(32);
+
+            x[i] = unzigzag(u) + predict(order, x.data(), i);
+         }
+
+         if (reader.overflow())
+            return false;
+      }
+
+      // interleave channel
+      for (unsigned int i = 0; i < frames; i++)
+         samples[i * channels + c] = (short) x[i];
+   }
+
+   return !reader.overflow();
+}
+
+struct CodecPool::Impl
+{
+   std::vector<std::thread> workers;
+   std::deque<std::function<void()>> jobs;
+   std::mutex mutex;
+   std::condition_variable sync;
+   bool running = true;
+
+   explicit Impl(int threads)
+   {
+      if (threads <= 0)
+         threads = std::max(1, std::min<int>(MAX_THREADS, (int) std::thread::hardware_concurrency()));
+
+      for (int i = 0; i < threads; i++)
+      {
+         workers.emplace_back([this] { run(); });
+      }
+   }
+
+   ~Impl()
+   {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+
+         running = false;
+
+         sync.notify_all();
+      }
+
+      for (auto &worker: workers)
+      {
+         worker.join();
+      }
+   }
+
+   void run()
+   {
+      std::unique_lock<std::mutex> lock(mutex);
+
+      while (true)
+      {
+         sync.wait(lock, [this] { return !jobs.empty() || !running; });
+
+         // pending jobs are completed before exit
+         if (jobs.empty())
+            break;
+
+         auto job = std::move(jobs.front());
+
+         jobs.pop_front();
+
+         lock.unlock();
+
+         job();
+
+         lock.lock();
+      }
+   }
+};
+
+CodecPool::CodecPool(int threads) : impl(std::make_shared<Impl>(threads))
+{
+}
+
+int CodecPool::threads() const
+{
+   return (int) impl->workers.size();
+}
+
+void CodecPool::post(std::function<void()> job)
+{
+   std::lock_guard<std::mutex> lock(impl->mutex);
+
+   impl->jobs.push_back(std::move(job));
+
+   impl->sync.notify_one();
+}
+
+}
@@ -0,0 +1,80 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef SDR_SAMPLECODEC_H
+#define SDR_SAMPLECODEC_H
+
+#include <vector>
+#include <future>
+#include <functional>
+
+namespace sdr {
+
+/*
+ * Lossless codec for 16 bit PCM chunks, fixed linear prediction per channel and Rice coded residuals
+ */
+struct SampleCodec
+{
+   // compress interleaved samples, appends encoded data to output
+   static void encode(const short *samples, unsigned int frames, unsigned int channels, std::vector<unsigned char> &output);
+
+   // decompress chunk into interleaved samples, returns false if data is corrupted
+   static bool decode(const unsigned char *data, unsigned int size, short *samples, unsigned int frames, unsigned int channels);
+};
+
+/*
+ * Fixed size thread pool for chunk compression and decompression
+ */
+class CodecPool
+{
+      struct Impl;
+
+   public:
+
+      explicit CodecPool(int threads = 0);
+
+      int threads() const;
+
+      template<typename R>
+      std::future<R> submit(std::function<R()> job)
+      {
+         auto task = std::make_shared<std::packaged_task<R()>>(std::move(job));
+
+         auto future = task->get_future();
+
+         post([task] { (*task)(); });
+
+         return future;
+      }
+
+   private:
+
+      void post(std::function<void()> job);
+
+      std::shared_ptr<Impl> impl;
+};
+
+}
+
+#endif
@@ -31,25 +31,33 @@ struct SignalBuffer::Impl
    long samplerate;
    long decimation;
    long offset;
+   long long captureTime = 0;
+   long long publishTime = 0;
 
    explicit Impl(long samplerate, long decimation, long offset) : samplerate(samplerate), decimation(decimation), offset(offset)
    {
    }
 };
 
-SignalBuffer::SignalBuffer() : impl(std::make_shared<Impl>(0, 0, 0))
+SignalBuffer::SignalBuffer()
 {
 }
 
-SignalBuffer::SignalBuffer(unsigned int length, unsigned int stride, unsigned int samplerate, unsigned int offset, unsigned int decimation, int type, void *context) : Buffer<float>(length, type, stride, context), impl(std::make_shared<Impl>(samplerate, decimation, offset))
+SignalBuffer::SignalBuffer(unsigned int length, unsigned int stride, unsigned int samplerate, unsigned int offset, unsigned int decimation, int type, void *context) : Buffer<float>(length, type, stride, context, sizeof(Impl))
 {
+   new(extension()) Impl(samplerate, decimation, offset);
 }
 
-SignalBuffer::SignalBuffer(float *data, unsigned int length, unsigned int stride, unsigned int samplerate, unsigned int offset, unsigned int decimation, int type, void *context) : Buffer<float>(data, length, type, stride, context), impl(std::make_shared<Impl>(samplerate, decimation, offset))
+SignalBuffer::SignalBuffer(float *data, unsigned int length, unsigned int stride, unsigned int samplerate, unsigned int offset, unsigned int decimation, int type, void *context) : Buffer<float>(data, length, type, stride, context, sizeof(Impl))
 {
+   new(extension()) Impl(samplerate, decimation, offset);
 }
 
-SignalBuffer::SignalBuffer(const SignalBuffer &other) : Buffer(other), impl(other.impl)
+SignalBuffer::SignalBuffer(const SignalBuffer &other) : Buffer(other)
+{
+}
+
+SignalBuffer::SignalBuffer(const rt::Buffer<float> &view) : Buffer(view)
 {
 }
 
@@ -60,24 +68,66 @@ SignalBuffer &SignalBuffer::operator=(const SignalBuffer &other)
 
    rt::Buffer<float>::operator=(other);
 
-   impl = other.impl;
-
    return *this;
 }
 
 unsigned int SignalBuffer::offset() const
 {
-   return impl->offset;
+   return stride() ? impl()->offset + origin() / stride() : impl()->offset;
 }
 
 unsigned int SignalBuffer::decimation() const
 {
-   return impl->decimation;
+   return impl()->decimation;
 }
 
 unsigned int SignalBuffer::sampleRate() const
 {
-   return impl->samplerate;
+   return impl()->samplerate;
+}
+
+long long SignalBuffer::captureTime() const
+{
+   return impl()->captureTime;
+}
+
+void SignalBuffer::setCaptureTime(long long time)
+{
+   if (auto ptr = impl())
+      ptr->captureTime = time;
+}
+
+long long SignalBuffer::publishTime() const
+{
+   return impl()->publishTime;
+}
+
+void SignalBuffer::setPublishTime(long long time)
+{
+   if (auto ptr = impl())
+      ptr->publishTime = time;
+}
+
+SignalBuffer SignalBuffer::slice(unsigned int from, unsigned int to) const
+{
+   return SignalBuffer(Buffer::slice(from, to));
+}
+
+const SignalBuffer::Impl *SignalBuffer::impl() const
+{
+   // metadata for empty buffers
+   static const Impl empty {0, 0, 0};
+
+   if (auto ptr = extension())
+      return static_cast<const Impl *>(ptr);
+
+   return &empty;
+}
+
+SignalBuffer::Impl *SignalBuffer::impl()
+{
+   // no metadata for empty buffers
+   return static_cast<Impl *>(extension());
 }
 
 }
@@ -0,0 +1,373 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+#include <x86intrin.h>
+#endif
+
+#include <cmath>
+#include <atomic>
+#include <string>
+#include <cstdlib>
+
+#include <rt/Logger.h>
+
+#include <sdr/SignalType.h>
+#include <sdr/SignalKernel.h>
+
+#include "SimdKernel.h"
+
+namespace sdr {
+
+namespace {
+
+/*
+ * Generic kernels, reference for other variants and fallback for non x86 builds
+ */
+template<typename T>
+void convertGeneric(const T *src, float *dst, unsigned int count, float scale)
+{
+   for (unsigned int i = 0; i < count; i++)
+      dst[i] = (float) src[i] * scale;
+}
+
+void magnitudeGeneric(const float *iq, float *magnitude, unsigned int count)
+{
+   for (unsigned int i = 0; i < count; i++)
+      magnitude[i] = std::sqrt(iq[i * 2] * iq[i * 2] + iq[i * 2 + 1] * iq[i * 2 + 1]);
+}
+
+void windowGeneric(const float *iq, const float *window, float *result, unsigned int count, unsigned int stride)
+{
+   for (unsigned int i = 0; i < count; i++)
+   {
+      result[i * 2 + 0] = iq[i * stride * 2 + 0] * window[i];
+      result[i * 2 + 1] = iq[i * stride * 2 + 1] * window[i];
+   }
+}
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+
+/*
+ * SSE2 kernels, baseline for all x86-64 processors
+ */
+void convertSse(const char *src, float *dst, unsigned int count, float scale)
+{
+   unsigned int i = 0;
+
+   __m128 k = _mm_set1_ps(scale);
+
+   for (; i + 16 <= count; i += 16)
+   {
+      __m128i a = _mm_loadu_si128((const __m128i *) (src + i));
+
+      // sign extend 8 bit to 16 bit
+      __m128i l = _mm_srai_epi16(_mm_unpacklo_epi8(a, a), 8);
+      __m128i h = _mm_srai_epi16(_mm_unpackhi_epi8(a, a), 8);
+
+      // sign extend 16 bit to 32 bit, convert and scale
+      _mm_storeu_ps(dst + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(l, l), 16)), k));
+      _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(l, l), 16)), k));
+      _mm_storeu_ps(dst + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(h, h), 16)), k));
+      _mm_storeu_ps(dst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(h, h), 16)), k));
+   }
+
+   convertGeneric(src + i, dst + i, count - i, scale);
+}
+
+void convertSse(const short *src, float *dst, unsigned int count, float scale)
+{
+   unsigned int i = 0;
+
+   __m128 k = _mm_set1_ps(scale);
+
+   for (; i + 8 <= count; i += 8)
+   {
+      __m128i a = _mm_loadu_si128((const __m128i *) (src + i));
+
+      // sign extend 16 bit to 32 bit, convert and scale
+      _mm_storeu_ps(dst + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16)), k));
+      _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(a, a), 16)), k));
+   }
+
+   convertGeneric(src + i, dst + i, count - i, scale);
+}
+
+void convertSse(const int *src, float *dst, unsigned int count, float scale)
+{
+   unsigned int i = 0;
+
+   __m128 k = _mm_set1_ps(scale);
+
+   for (; i + 4 <= count; i += 4)
+   {
+      _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) (src + i))), k));
+   }
+
+   convertGeneric(src + i, dst + i, count - i, scale);
+}
+
+// I^2 + Q^2 square root for 4 I/Q pairs
+inline __m128 magnitudeSse(__m128 a, __m128 b)
+{
+   __m128 p1 = _mm_mul_ps(a, a);
+   __m128 p2 = _mm_mul_ps(b, b);
+
+   return _mm_sqrt_ps(_mm_add_ps(_mm_shuffle_ps(p1, p2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(3, 1, 3, 1))));
+}
+
+void magnitudeSse(const float *iq, float *magnitude, unsigned int count)
+{
+   unsigned int i = 0;
+
+   for (; i + 8 <= count; i += 8)
+   {
+      _mm_storeu_ps(magnitude + i + 0, magnitudeSse(_mm_loadu_ps(iq + i * 2 + 0), _mm_loadu_ps(iq + i * 2 + 4)));
+      _mm_storeu_ps(magnitude + i + 4, magnitudeSse(_mm_loadu_ps(iq + i * 2 + 8), _mm_loadu_ps(iq + i * 2 + 12)));
+   }
+
+   magnitudeGeneric(iq + i * 2, magnitude + i, count - i);
+}
+
+void windowSse(const float *iq, const float *window, float *result, unsigned int count, unsigned int stride)
+{
+   unsigned int i = 0;
+
+   for (; i + 4 <= count; i += 4)
+   {
+      __m128 w = _mm_loadu_ps(window + i);
+
+      // each window value applies to I and Q components
+      __m128 w1 = _mm_unpacklo_ps(w, w); // W0, W0, W1, W1
+      __m128 w2 = _mm_unpackhi_ps(w, w); // W2, W2, W3, W3
+
+      __m128 a1, a2;
+
+      if (stride == 1)
+      {
+         a1 = _mm_loadu_ps(iq + i * 2 + 0);
+         a2 = _mm_loadu_ps(iq + i * 2 + 4);
+      }
+      else
+      {
+         // gather I/Q pairs as 64 bit values
+         const float *p = iq + i * stride * 2;
+
+         a1 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) (p + 0 * stride)), (const __m64 *) (p + 2 * stride));
+         a2 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) (p + 4 * stride)), (const __m64 *) (p + 6 * stride));
+      }
+
+      _mm_storeu_ps(result + i * 2 + 0, _mm_mul_ps(a1, w1));
+      _mm_storeu_ps(result + i * 2 + 4, _mm_mul_ps(a2, w2));
+   }
+
+   windowGeneric(iq + i * stride * 2, window + i, result + i * 2, count - i, stride);
+}
+
+#endif
+
+/*
+ * Kernel selection, CPU features are read once and may be overridden with NFC_SIMD environment variable
+ */
+struct Dispatch
+{
+   rt::Logger log {"SignalKernel"};
+
+   int supported = SignalKernel::Generic;
+
+   std::atomic<int> level {SignalKernel::Generic};
+
+   std::atomic<const SimdKernel *> kernel {&genericKernel};
+
+   Dispatch()
+   {
+#if defined(__SSE2__) && defined(USE_SSE2)
+      supported = SignalKernel::SSE;
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+      __builtin_cpu_init();
+
+#if defined(USE_AVX2)
+      if (__builtin_cpu_supports("avx2"))
+         supported = SignalKernel::AVX2;
+#endif
+
+#if defined(USE_AVX512)
+      if (__builtin_cpu_supports("avx512f"))
+         supported = SignalKernel::AVX512;
+#endif
+#endif
+
+      int requested = supported;
+
+      if (const char *value = std::getenv("NFC_SIMD"))
+      {
+         for (int i = SignalKernel::Generic; i <= SignalKernel::AVX512; i++)
+         {
+            if (std::string(value) == SignalKernel::name(i))
+               requested = i;
+         }
+      }
+
+      select(requested);
+
+      log.info("using {} signal kernels, supported {}", {std::string(SignalKernel::name(level)), std::string(SignalKernel::name(supported))});
+   }
+
+   int select(int value)
+   {
+      value = value < SignalKernel::Generic ? SignalKernel::Generic : value > supported ? supported : value;
+
+      switch (value)
+      {
+#if defined(USE_AVX512)
+         case SignalKernel::AVX512:
+            kernel = &avx512Kernel;
+            break;
+#endif
+#if defined(USE_AVX2)
+         case SignalKernel::AVX2:
+            kernel = &avx2Kernel;
+            break;
+#endif
+#if defined(__SSE2__) && defined(USE_SSE2)
+         case SignalKernel::SSE:
+            kernel = &sseKernel;
+            break;
+#endif
+         default:
+            kernel = &genericKernel;
+            break;
+      }
+
+      level = value;
+
+      return value;
+   }
+
+   static Dispatch &instance()
+   {
+      static Dispatch dispatch;
+
+      return dispatch;
+   }
+};
+
+inline const SimdKernel *active()
+{
+   return Dispatch::instance().kernel.load(std::memory_order_relaxed);
+}
+
+}
+
+const SimdKernel genericKernel {
+      convertGeneric<char>,
+      convertGeneric<short>,
+      convertGeneric<int>,
+      magnitudeGeneric,
+      windowGeneric
+};
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+
+const SimdKernel sseKernel {
+      convertSse,
+      convertSse,
+      convertSse,
+      magnitudeSse,
+      windowSse
+};
+
+#endif
+
+void SignalKernel::convert(const char *src, float *dst, unsigned int count, float scale)
+{
+   active()->convert8(src, dst, count, scale);
+}
+
+void SignalKernel::convert(const short *src, float *dst, unsigned int count, float scale)
+{
+   active()->convert16(src, dst, count, scale);
+}
+
+void SignalKernel::convert(const int *src, float *dst, unsigned int count, float scale)
+{
+   active()->convert32(src, dst, count, scale);
+}
+
+void SignalKernel::magnitude(const float *iq, float *magnitude, unsigned int count)
+{
+   active()->magnitude(iq, magnitude, count);
+}
+
+SignalBuffer SignalKernel::magnitude(const SignalBuffer &iq)
+{
+   auto input = iq.readable();
+
+   SignalBuffer result(input.size() / 2, 1, iq.sampleRate(), iq.offset(), 0, SignalType::SAMPLE_REAL);
+
+   active()->magnitude(input.data(), result.pull(input.size() / 2), input.size() / 2);
+
+   result.flip();
+
+   return result;
+}
+
+void SignalKernel::window(const float *iq, const float *window, float *result, unsigned int count, unsigned int stride)
+{
+   active()->window(iq, window, result, count, stride);
+}
+
+int SignalKernel::level()
+{
+   return Dispatch::instance().level;
+}
+
+int SignalKernel::supported()
+{
+   return Dispatch::instance().supported;
+}
+
+int SignalKernel::select(int level)
+{
+   return Dispatch::instance().select(level);
+}
+
+const char *SignalKernel::name(int level)
+{
+   switch (level)
+   {
+      case SSE:
+         return "sse";
+      case AVX2:
+         return "avx2";
+      case AVX512:
+         return "avx512";
+      default:
+         return "generic";
+   }
+}
+
+}
@@ -0,0 +1,153 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#if defined(__AVX2__) && defined(USE_AVX2)
+
+#include <immintrin.h>
+#include <math.h>
+
+#include "SimdKernel.h"
+
+namespace sdr {
+
+namespace {
+
+/*
+ * AVX2 kernels, 8 samples per vector
+ */
+inline __m256i load8(const char *src)
+{
+   return _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *) src));
+}
+
+inline __m256i load8(const short *src)
+{
+   return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) src));
+}
+
+inline __m256i load8(const int *src)
+{
+   return _mm256_loadu_si256((const __m256i *) src);
+}
+
+// I^2 + Q^2 square root for 8 I/Q pairs
+inline __m256 magnitude8(__m256 a, __m256 b)
+{
+   __m256 p1 = _mm256_mul_ps(a, a); // I0, Q0, I1, Q1 | I2, Q2, I3, Q3
+   __m256 p2 = _mm256_mul_ps(b, b); // I4, Q4, I5, Q5 | I6, Q6, I7, Q7
+
+   // in-lane shuffle gives pairs 0, 1, 4, 5 | 2, 3, 6, 7
+   __m256 r = _mm256_add_ps(_mm256_shuffle_ps(p1, p2, _MM_SHUFFLE(2, 0, 2, 0)), _mm256_shuffle_ps(p1, p2, _MM_SHUFFLE(3, 1, 3, 1)));
+
+   // restore pair order crossing lanes
+   r = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(r), _MM_SHUFFLE(3, 1, 2, 0)));
+
+   return _mm256_sqrt_ps(r);
+}
+
+template<typename T>
+void convertAvx2(const T *src, float *dst, unsigned int count, float scale)
+{
+   unsigned int i = 0;
+
+   __m256 k = _mm256_set1_ps(scale);
+
+   for (; i + 16 <= count; i += 16)
+   {
+      _mm256_storeu_ps(dst + i + 0, _mm256_mul_ps(_mm256_cvtepi32_ps(load8(src + i + 0)), k));
+      _mm256_storeu_ps(dst + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(load8(src + i + 8)), k));
+   }
+
+   for (; i < count; i++)
+      dst[i] = (float) src[i] * scale;
+}
+
+void magnitudeAvx2(const float *iq, float *magnitude, unsigned int count)
+{
+   unsigned int i = 0;
+
+   for (; i + 8 <= count; i += 8)
+   {
+      _mm256_storeu_ps(magnitude + i, magnitude8(_mm256_loadu_ps(iq + i * 2 + 0), _mm256_loadu_ps(iq + i * 2 + 8)));
+   }
+
+   for (; i < count; i++)
+      magnitude[i] = sqrtf(iq[i * 2] * iq[i * 2] + iq[i * 2 + 1] * iq[i * 2 + 1]);
+}
+
+void windowAvx2(const float *iq, const float *window, float *result, unsigned int count, unsigned int stride)
+{
+   unsigned int i = 0;
+
+   // duplicate each window value for I and Q components
+   __m256i d1 = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+   __m256i d2 = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+
+   // offset of each I/Q pair, as 64 bit elements
+   __m128i g = _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32((int) stride));
+
+   for (; i + 8 <= count; i += 8)
+   {
+      __m256 w = _mm256_loadu_ps(window + i);
+
+      __m256 a1, a2;
+
+      if (stride == 1)
+      {
+         a1 = _mm256_loadu_ps(iq + i * 2 + 0);
+         a2 = _mm256_loadu_ps(iq + i * 2 + 8);
+      }
+      else
+      {
+         // gather I/Q pairs as 64 bit values
+         const double *p = (const double *) (iq + i * stride * 2);
+
+         a1 = _mm256_castpd_ps(_mm256_i32gather_pd(p, g, 8));
+         a2 = _mm256_castpd_ps(_mm256_i32gather_pd(p + 4 * stride, g, 8));
+      }
+
+      _mm256_storeu_ps(result + i * 2 + 0, _mm256_mul_ps(a1, _mm256_permutevar8x32_ps(w, d1)));
+      _mm256_storeu_ps(result + i * 2 + 8, _mm256_mul_ps(a2, _mm256_permutevar8x32_ps(w, d2)));
+   }
+
+   for (; i < count; i++)
+   {
+      result[i * 2 + 0] = iq[i * stride * 2 + 0] * window[i];
+      result[i * 2 + 1] = iq[i * stride * 2 + 1] * window[i];
+   }
+}
+
+}
+
+const SimdKernel avx2Kernel {
+      convertAvx2<char>,
+      convertAvx2<short>,
+      convertAvx2<int>,
+      magnitudeAvx2,
+      windowAvx2
+};
+
+}
+
+#endif
@@ -0,0 +1,150 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#if defined(__AVX512F__) && defined(USE_AVX512)
+
+#include <immintrin.h>
+#include <math.h>
+
+#include "SimdKernel.h"
+
+namespace sdr {
+
+namespace {
+
+/*
+ * AVX-512 kernels, 16 samples per vector
+ */
+inline __m512i load16(const char *src)
+{
+   return _mm512_cvtepi8_epi32(_mm_loadu_si128((const __m128i *) src));
+}
+
+inline __m512i load16(const short *src)
+{
+   return _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i *) src));
+}
+
+inline __m512i load16(const int *src)
+{
+   return _mm512_loadu_si512(src);
+}
+
+// I^2 + Q^2 square root for 16 I/Q pairs
+inline __m512 magnitude16(__m512 a, __m512 b)
+{
+   __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+   __m512i odd = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+
+   __m512 p1 = _mm512_mul_ps(a, a);
+   __m512 p2 = _mm512_mul_ps(b, b);
+
+   return _mm512_sqrt_ps(_mm512_add_ps(_mm512_permutex2var_ps(p1, even, p2), _mm512_permutex2var_ps(p1, odd, p2)));
+}
+
+template<typename T>
+void convertAvx512(const T *src, float *dst, unsigned int count, float scale)
+{
+   unsigned int i = 0;
+
+   __m512 k = _mm512_set1_ps(scale);
+
+   for (; i + 32 <= count; i += 32)
+   {
+      _mm512_storeu_ps(dst + i + 0, _mm512_mul_ps(_mm512_cvtepi32_ps(load16(src + i + 0)), k));
+      _mm512_storeu_ps(dst + i + 16, _mm512_mul_ps(_mm512_cvtepi32_ps(load16(src + i + 16)), k));
+   }
+
+   for (; i < count; i++)
+      dst[i] = (float) src[i] * scale;
+}
+
+void magnitudeAvx512(const float *iq, float *magnitude, unsigned int count)
+{
+   unsigned int i = 0;
+
+   for (; i + 16 <= count; i += 16)
+   {
+      _mm512_storeu_ps(magnitude + i, magnitude16(_mm512_loadu_ps(iq + i * 2 + 0), _mm512_loadu_ps(iq + i * 2 + 16)));
+   }
+
+   for (; i < count; i++)
+      magnitude[i] = sqrtf(iq[i * 2] * iq[i * 2] + iq[i * 2 + 1] * iq[i * 2 + 1]);
+}
+
+void windowAvx512(const float *iq, const float *window, float *result, unsigned int count, unsigned int stride)
+{
+   unsigned int i = 0;
+
+   // duplicate each window value for I and Q components
+   __m512i d1 = _mm512_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7);
+   __m512i d2 = _mm512_setr_epi32(8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 14, 14, 15, 15);
+
+   // offset of each I/Q pair, as 64 bit elements
+   __m256i g = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32((int) stride));
+
+   for (; i + 16 <= count; i += 16)
+   {
+      __m512 w = _mm512_loadu_ps(window + i);
+
+      __m512 a1, a2;
+
+      if (stride == 1)
+      {
+         a1 = _mm512_loadu_ps(iq + i * 2 + 0);
+         a2 = _mm512_loadu_ps(iq + i * 2 + 16);
+      }
+      else
+      {
+         // gather I/Q pairs as 64 bit values
+         const double *p = (const double *) (iq + i * stride * 2);
+
+         a1 = _mm512_castpd_ps(_mm512_i32gather_pd(g, p, 8));
+         a2 = _mm512_castpd_ps(_mm512_i32gather_pd(g, p + 8 * stride, 8));
+      }
+
+      _mm512_storeu_ps(result + i * 2 + 0, _mm512_mul_ps(a1, _mm512_permutexvar_ps(d1, w)));
+      _mm512_storeu_ps(result + i * 2 + 16, _mm512_mul_ps(a2, _mm512_permutexvar_ps(d2, w)));
+   }
+
+   for (; i < count; i++)
+   {
+      result[i * 2 + 0] = iq[i * stride * 2 + 0] * window[i];
+      result[i * 2 + 1] = iq[i * stride * 2 + 1] * window[i];
+   }
+}
+
+}
+
+const SimdKernel avx512Kernel {
+      convertAvx512<char>,
+      convertAvx512<short>,
+      convertAvx512<int>,
+      magnitudeAvx512,
+      windowAvx512
+};
+
+}
+
+#endif
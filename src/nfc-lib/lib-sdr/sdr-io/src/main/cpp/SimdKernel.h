@@ -0,0 +1,59 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef SDR_SIMDKERNEL_H
+#define SDR_SIMDKERNEL_H
+
+/*
+ * Kernel variants are built in separate units with their own instruction set flags,
+ * do not include headers with inline code here or it may be emitted with wider instructions
+ */
+namespace sdr {
+
+struct SimdKernel
+{
+   void (*convert8)(const char *src, float *dst, unsigned int count, float scale);
+   void (*convert16)(const short *src, float *dst, unsigned int count, float scale);
+   void (*convert32)(const int *src, float *dst, unsigned int count, float scale);
+   void (*magnitude)(const float *iq, float *magnitude, unsigned int count);
+   void (*window)(const float *iq, const float *window, float *result, unsigned int count, unsigned int stride);
+};
+
+extern const SimdKernel genericKernel;
+
+#if defined(__SSE2__) && defined(USE_SSE2)
+extern const SimdKernel sseKernel;
+#endif
+
+#if defined(USE_AVX2)
+extern const SimdKernel avx2Kernel;
+#endif
+
+#if defined(USE_AVX512)
+extern const SimdKernel avx512Kernel;
+#endif
+
+}
+
+#endif
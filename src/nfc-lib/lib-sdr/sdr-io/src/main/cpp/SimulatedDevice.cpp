@@ -0,0 +1,813 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include <cmath>
+#include <queue>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <cstdlib>
+
+#include <rt/Logger.h>
+
+#include <sdr/SignalType.h>
+#include <sdr/SignalBuffer.h>
+#include <sdr/RecordDevice.h>
+#include <sdr/SimulatedDevice.h>
+
+#define DEFAULT_SAMPLE_RATE 10000000
+#define DEFAULT_TRANSFER_SIZE 65536
+#define NOISE_TABLE_SIZE (1 << 20)
+
+#define MAX_QUEUE_SIZE 4
+#define DEFAULT_TRANSFER_LAG 4
+
+namespace sdr {
+
+struct SimulatedDevice::Impl
+{
+   rt::Logger log {"SimulatedDevice"};
+
+   std::string deviceName;
+   std::string deviceVersion = "simulator";
+   std::string sourceName;
+   int centerFreq = 13560000;
+   int sampleRate = DEFAULT_SAMPLE_RATE;
+   int sampleSize = 32;
+   int gainMode = 0;
+   int gainValue = 0;
+   int tunerAgc = 0;
+   int mixerAgc = 0;
+   int biasTee = 0;
+   int decimation = 0;
+   int testMode = 0;
+   int streamTime = 0;
+
+   // stream configuration
+   unsigned int transferSize = DEFAULT_TRANSFER_SIZE;
+   unsigned int dropPeriod = 0;
+   float dropChance = 0;
+   unsigned int jitterMax = 0;
+   unsigned int lagMax = DEFAULT_TRANSFER_LAG;
+   float carrierLevel = 0.5f;
+   float noiseLevel = 0.01f;
+
+   // signal source, file or generator
+   bool deviceOpen = false;
+   std::shared_ptr<RecordDevice> sourceFile;
+   SignalBuffer sourceBuffer;
+   std::vector<float> noiseTable;
+   std::mt19937 random {12345};
+
+   std::mutex streamMutex;
+   std::queue<SignalBuffer> streamQueue;
+   RadioDevice::StreamHandler streamCallback;
+
+   std::thread workerThread;
+   std::atomic_bool workerStreaming {false};
+
+   std::atomic<long> samplesReceived {0};
+   std::atomic<long> samplesDropped {0};
+
+   explicit Impl(std::string name) : deviceName(std::move(name))
+   {
+      log.debug("created SimulatedDevice for name [{}]", {this->deviceName});
+
+      configure();
+   }
+
+   ~Impl()
+   {
+      log.debug("destroy SimulatedDevice");
+
+      close();
+   }
+
+   static std::vector<std::string> listDevices()
+   {
+      std::vector<std::string> result;
+
+      if (const char *names = std::getenv("NFC_SIM_DEVICE"))
+      {
+         std::string list(names);
+
+         for (std::string::size_type start = 0, end; start < list.size(); start = end + 1)
+         {
+            if ((end = list.find(';', start)) == std::string::npos)
+               end = list.size();
+
+            std::string name = list.substr(start, end - start);
+
+            if (name.rfind("sim://", 0) == 0)
+               result.emplace_back(name);
+         }
+      }
+
+      return result;
+   }
+
+   void configure()
+   {
+      if (deviceName.rfind("sim://", 0) != 0)
+         return;
+
+      std::string spec = deviceName.substr(6);
+      std::string::size_type query = spec.find('?');
+
+      sourceName = spec.substr(0, query);
+
+      if (query == std::string::npos)
+         return;
+
+      std::string options = spec.substr(query + 1);
+
+      for (std::string::size_type start = 0, end; start < options.size(); start = end + 1)
+      {
+         if ((end = options.find('&', start)) == std::string::npos)
+            end = options.size();
+
+         std::string option = options.substr(start, end - start);
+         std::string::size_type equal = option.find('=');
+
+         if (equal == std::string::npos)
+            continue;
+
+         std::string key = option.substr(0, equal);
+         double value = std::strtod(option.c_str() + equal + 1, nullptr);
+
+         if (key == "rate" && value > 0)
+            sampleRate = (int) value;
+         else if (key == "transfer" && value >= 16)
+            transferSize = (unsigned int) value & ~15u;
+         else if (key == "drop")
+            dropPeriod = (unsigned int) value;
+         else if (key == "loss")
+            dropChance = (float) value;
+         else if (key == "jitter")
+            jitterMax = (unsigned int) value;
+         else if (key == "lag")
+            lagMax = (unsigned int) value;
+         else if (key == "level")
+            carrierLevel = (float) value;
+         else if (key == "noise")
+            noiseLevel = (float) value;
+         else
+            log.warn("unknown option [{}] for device {}", {key, deviceName});
+      }
+   }
+
+   bool open(SignalDevice::OpenMode mode)
+   {
+      if (deviceName.rfind("sim://", 0) != 0)
+      {
+         log.warn("invalid device name [{}]", {deviceName});
+         return false;
+      }
+
+      if (mode != SignalDevice::Read)
+      {
+         log.warn("invalid open mode {} for device {}", {mode, deviceName});
+         return false;
+      }
+
+      close();
+
+      if (!sourceName.empty() && sourceName != "generator")
+      {
+         auto file = std::make_shared<RecordDevice>(sourceName);
+
+         if (!file->open(SignalDevice::Read))
+         {
+            log.warn("unable to open source file [{}]", {sourceName});
+            return false;
+         }
+
+         if (file->channelCount() > 2)
+         {
+            log.warn("too many channels in source file [{}]", {sourceName});
+            return false;
+         }
+
+         sourceFile = file;
+      }
+      else
+      {
+         std::normal_distribution<float> gauss(0, noiseLevel);
+
+         noiseTable.resize(NOISE_TABLE_SIZE);
+
+         for (auto &value: noiseTable)
+            value = gauss(random);
+      }
+
+      deviceOpen = true;
+
+      log.info("openned simulated device {}, source {}, rate {} transfer {}", {deviceName, sourceFile ? sourceName : "generator", sampleRate, transferSize});
+
+      return true;
+   }
+
+   void close()
+   {
+      if (deviceOpen)
+      {
+         stop();
+
+         log.info("close device {}", {deviceName});
+
+         sourceFile.reset();
+         sourceBuffer = {};
+         noiseTable.clear();
+
+         deviceOpen = false;
+      }
+   }
+
+   int start(RadioDevice::StreamHandler handler)
+   {
+      if (deviceOpen && !workerStreaming)
+      {
+         // release previous delivery thread, if any
+         stop();
+
+         log.info("start streaming for device {}", {deviceName});
+
+         // clear counters
+         samplesDropped = 0;
+         samplesReceived = 0;
+
+         // reset stream status
+         streamCallback = std::move(handler);
+         streamQueue = std::queue<SignalBuffer>();
+
+         // start delivery thread
+         workerStreaming = true;
+         workerThread = std::thread([this] { streamWorker(); });
+
+         // sets stream start time
+         streamTime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+         return 0;
+      }
+
+      return -1;
+   }
+
+   int stop()
+   {
+      // delivery thread finishes by itself when source is exhausted
+      if (workerStreaming || workerThread.joinable())
+      {
+         log.info("stop streaming for device {}", {deviceName});
+
+         workerStreaming = false;
+
+         if (workerThread.joinable())
+            workerThread.join();
+
+         // disable stream callback and queue
+         streamCallback = nullptr;
+         streamQueue = std::queue<SignalBuffer>();
+         streamTime = 0;
+
+         return 0;
+      }
+
+      return -1;
+   }
+
+   /*
+    * Delivery thread, each transfer is due at its exact position in the sample clock so the average rate
+    * does not drift with jitter or callback time. When delivery falls behind more than lagMax
+    * transfers the overdue ones are discarded and counted as dropped, as real hardware would do
+    */
+   void streamWorker()
+   {
+      std::uniform_real_distribution<float> chance(0, 1);
+      std::uniform_int_distribution<unsigned int> jitter(0, jitterMax);
+
+      auto streamStart = std::chrono::steady_clock::now();
+      auto transferTime = std::chrono::duration<double>(double(transferSize) / sampleRate);
+
+      long transferCount = 0;
+
+      while (workerStreaming)
+      {
+         auto due = streamStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(transferTime * (transferCount + 1));
+
+         if (jitterMax > 0)
+            due += std::chrono::microseconds(jitter(random));
+
+         std::this_thread::sleep_until(due);
+
+         // stream position in samples, counting dropped transfers
+         long offset = transferCount * transferSize;
+
+         transferCount++;
+
+         // discard transfers too late to be delivered
+         if (lagMax > 0 && std::chrono::steady_clock::now() - due > transferTime * lagMax)
+         {
+            samplesDropped += transferSize;
+            skip(transferSize);
+            continue;
+         }
+
+         // injected drop patterns
+         if ((dropPeriod > 0 && transferCount % dropPeriod == 0) || (dropChance > 0 && chance(random) < dropChance))
+         {
+            samplesDropped += transferSize;
+            skip(transferSize);
+            continue;
+         }
+
+         SignalBuffer buffer(transferSize * 2, 2, sampleRate, offset, 0, SignalType::SAMPLE_IQ);
+
+         if (!fill(buffer))
+         {
+            log.warn("source exhausted for device {}", {deviceName});
+            break;
+         }
+
+         buffer.flip();
+
+         // transfer is captured at its due time, as real hardware would complete it
+         buffer.setCaptureTime(std::chrono::duration_cast<std::chrono::nanoseconds>(due.time_since_epoch()).count());
+
+         samplesReceived += transferSize;
+
+         deliver(buffer);
+      }
+
+      workerStreaming = false;
+   }
+
+   void deliver(SignalBuffer &buffer)
+   {
+      // stream to buffer callback
+      if (streamCallback)
+      {
+         streamCallback(buffer);
+      }
+
+         // or store buffer in receive queue
+      else
+      {
+         std::lock_guard<std::mutex> lock(streamMutex);
+
+         // discard oldest buffers
+         if (streamQueue.size() >= MAX_QUEUE_SIZE)
+         {
+            samplesDropped += streamQueue.front().elements();
+            streamQueue.pop();
+         }
+
+         streamQueue.push(buffer);
+      }
+   }
+
+   // fill buffer with next I/Q samples from source
+   bool fill(SignalBuffer &buffer)
+   {
+      if (!sourceFile)
+      {
+         generate(buffer);
+         return true;
+      }
+
+      unsigned int pending = transferSize;
+
+      while (pending > 0)
+      {
+         if (!sourceBuffer.isValid() || sourceBuffer.available() == 0)
+         {
+            if (!readSource())
+               return false;
+         }
+
+         unsigned int stride = sourceBuffer.stride();
+         unsigned int count = std::min(pending, sourceBuffer.available() / stride);
+
+         float *src = sourceBuffer.pull(count * stride);
+         float *dst = buffer.pull(count * 2);
+
+         if (stride == 2)
+         {
+            std::copy(src, src + count * 2, dst);
+         }
+         else
+         {
+            for (unsigned int i = 0; i < count; i++)
+            {
+               dst[i * 2 + 0] = src[i];
+               dst[i * 2 + 1] = 0;
+            }
+         }
+
+         pending -= count;
+      }
+
+      return true;
+   }
+
+   // discard next samples from source to keep stream position in sync
+   void skip(unsigned int samples)
+   {
+      if (!sourceFile)
+         return;
+
+      while (samples > 0)
+      {
+         if (!sourceBuffer.isValid() || sourceBuffer.available() == 0)
+         {
+            if (!readSource())
+               return;
+         }
+
+         unsigned int stride = sourceBuffer.stride();
+         unsigned int count = std::min(samples, sourceBuffer.available() / stride);
+
+         sourceBuffer.pull(count * stride);
+
+         samples -= count;
+      }
+   }
+
+   // read next block from source file, rewinding at end of file
+   bool readSource()
+   {
+      int channels = sourceFile->channelCount();
+
+      for (int retry = 0; retry < 2; retry++)
+      {
+         if (sourceFile->isEof())
+            sourceFile->seek(0);
+
+         sourceBuffer = SignalBuffer(DEFAULT_TRANSFER_SIZE * channels, channels, sampleRate, 0, 0, channels == 2 ? SignalType::SAMPLE_IQ : SignalType::SAMPLE_REAL);
+
+         if (sourceFile->read(sourceBuffer) > 0 && sourceBuffer.available() > 0)
+            return true;
+      }
+
+      return false;
+   }
+
+   // carrier with gaussian noise taken from a precomputed table at random offset
+   void generate(SignalBuffer &buffer)
+   {
+      std::uniform_int_distribution<unsigned int> start(0, NOISE_TABLE_SIZE - 1);
+
+      const float *noise = noiseTable.data();
+      unsigned int index = start(random);
+
+      float *dst = buffer.pull(transferSize * 2);
+
+      for (unsigned int i = 0; i < transferSize * 2; i += 2)
+      {
+         dst[i + 0] = carrierLevel + noise[index];
+         dst[i + 1] = noise[(index + 1) & (NOISE_TABLE_SIZE - 1)];
+
+         index = (index + 2) & (NOISE_TABLE_SIZE - 1);
+      }
+   }
+
+   std::map<int, std::string> supportedSampleRates() const
+   {
+      std::map<int, std::string> result;
+
+      for (int rate: {2400000, 3200000, 6000000, 10000000, 20000000})
+         result[rate] = std::to_string(rate);
+
+      result[sampleRate] = std::to_string(sampleRate);
+
+      return result;
+   }
+
+   std::map<int, std::string> supportedGainModes() const
+   {
+      std::map<int, std::string> result;
+
+      result[0] = "Auto";
+      result[1] = "Manual";
+
+      return result;
+   }
+
+   std::map<int, std::string> supportedGainValues() const
+   {
+      std::map<int, std::string> result;
+
+      for (int i = 0; i < 8; i++)
+      {
+         char buffer[64];
+
+         snprintf(buffer, sizeof(buffer), "%d db", i);
+
+         result[i] = buffer;
+      }
+
+      return result;
+   }
+
+   int read(SignalBuffer &buffer)
+   {
+      // lock buffer access
+      std::lock_guard<std::mutex> lock(streamMutex);
+
+      if (!streamQueue.empty())
+      {
+         buffer = streamQueue.front();
+
+         streamQueue.pop();
+
+         return buffer.limit();
+      }
+
+      return -1;
+   }
+
+   int write(SignalBuffer &buffer)
+   {
+      log.warn("write not supported on this device!");
+
+      return -1;
+   }
+};
+
+SimulatedDevice::SimulatedDevice(const std::string &name) : impl(std::make_shared<Impl>(name))
+{
+}
+
+std::vector<std::string> SimulatedDevice::listDevices()
+{
+   return Impl::listDevices();
+}
+
+const std::string &SimulatedDevice::name()
+{
+   return impl->deviceName;
+}
+
+const std::string &SimulatedDevice::version()
+{
+   return impl->deviceVersion;
+}
+
+bool SimulatedDevice::open(OpenMode mode)
+{
+   return impl->open(mode);
+}
+
+void SimulatedDevice::close()
+{
+   impl->close();
+}
+
+int SimulatedDevice::start(StreamHandler handler)
+{
+   return impl->start(handler);
+}
+
+int SimulatedDevice::stop()
+{
+   return impl->stop();
+}
+
+bool SimulatedDevice::isOpen() const
+{
+   return impl->deviceOpen;
+}
+
+bool SimulatedDevice::isEof() const
+{
+   return !impl->workerStreaming;
+}
+
+bool SimulatedDevice::isReady() const
+{
+   return impl->deviceOpen;
+}
+
+bool SimulatedDevice::isStreaming() const
+{
+   return impl->workerStreaming;
+}
+
+int SimulatedDevice::sampleSize() const
+{
+   return impl->sampleSize;
+}
+
+int SimulatedDevice::setSampleSize(int value)
+{
+   impl->log.warn("setSampleSize has no effect!");
+
+   return -1;
+}
+
+long SimulatedDevice::sampleRate() const
+{
+   return impl->sampleRate;
+}
+
+int SimulatedDevice::setSampleRate(long value)
+{
+   if (impl->workerStreaming)
+   {
+      impl->log.warn("setSampleRate has no effect while streaming!");
+
+      return -1;
+   }
+
+   impl->sampleRate = value;
+
+   return 0;
+}
+
+int SimulatedDevice::sampleType() const
+{
+   return Float;
+}
+
+int SimulatedDevice::setSampleType(int value)
+{
+   impl->log.warn("setSampleType has no effect!");
+
+   return -1;
+}
+
+long SimulatedDevice::streamTime() const
+{
+   return impl->streamTime;
+}
+
+int SimulatedDevice::setStreamTime(long value)
+{
+   return 0;
+}
+
+long SimulatedDevice::centerFreq() const
+{
+   return impl->centerFreq;
+}
+
+int SimulatedDevice::setCenterFreq(long value)
+{
+   impl->centerFreq = value;
+
+   return 0;
+}
+
+int SimulatedDevice::tunerAgc() const
+{
+   return impl->tunerAgc;
+}
+
+int SimulatedDevice::setTunerAgc(int value)
+{
+   impl->tunerAgc = value;
+
+   return 0;
+}
+
+int SimulatedDevice::mixerAgc() const
+{
+   return impl->mixerAgc;
+}
+
+int SimulatedDevice::setMixerAgc(int value)
+{
+   impl->mixerAgc = value;
+
+   return 0;
+}
+
+int SimulatedDevice::biasTee() const
+{
+   return impl->biasTee;
+}
+
+int SimulatedDevice::setBiasTee(int value)
+{
+   impl->biasTee = value;
+
+   return 0;
+}
+
+int SimulatedDevice::gainMode() const
+{
+   return impl->gainMode;
+}
+
+int SimulatedDevice::setGainMode(int value)
+{
+   impl->gainMode = value;
+
+   return 0;
+}
+
+int SimulatedDevice::gainValue() const
+{
+   return impl->gainValue;
+}
+
+int SimulatedDevice::setGainValue(int value)
+{
+   impl->gainValue = value;
+
+   return 0;
+}
+
+int SimulatedDevice::decimation() const
+{
+   return impl->decimation;
+}
+
+int SimulatedDevice::setDecimation(int value)
+{
+   impl->decimation = value;
+
+   return 0;
+}
+
+int SimulatedDevice::testMode() const
+{
+   return impl->testMode;
+}
+
+int SimulatedDevice::setTestMode(int value)
+{
+   impl->testMode = value;
+
+   return 0;
+}
+
+int SimulatedDevice::directSampling() const
+{
+   return 0;
+}
+
+int SimulatedDevice::setDirectSampling(int value)
+{
+   return 0;
+}
+
+long SimulatedDevice::samplesReceived()
+{
+   return impl->samplesReceived;
+}
+
+long SimulatedDevice::samplesDropped()
+{
+   return impl->samplesDropped;
+}
+
+std::map<int, std::string> SimulatedDevice::supportedSampleRates() const
+{
+   return impl->supportedSampleRates();
+}
+
+std::map<int, std::string> SimulatedDevice::supportedGainModes() const
+{
+   return impl->supportedGainModes();
+}
+
+std::map<int, std::string> SimulatedDevice::supportedGainValues() const
+{
+   return impl->supportedGainValues();
+}
+
+int SimulatedDevice::read(SignalBuffer &buffer)
+{
+   return impl->read(buffer);
+}
+
+int SimulatedDevice::write(SignalBuffer &buffer)
+{
+   return impl->write(buffer);
+}
+
+}
@@ -0,0 +1,93 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef SDR_DEVICEMONITOR_H
+#define SDR_DEVICEMONITOR_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+namespace sdr {
+
+/*
+ * Keeps a cached list of available devices, enumeration only runs after bus changes are notified by the backend,
+ * or periodically for backends without hotplug support
+ */
+class DeviceMonitor
+{
+      struct Impl;
+
+   public:
+
+      enum Event
+      {
+         Attach = 1, Detach = 2
+      };
+
+      typedef std::function<void(int event, const std::string &name)> EventHandler;
+
+      /*
+       * Device enumeration backend
+       */
+      struct Backend
+      {
+         virtual ~Backend() = default;
+
+         // true if bus changes are notified, otherwise devices are polled
+         virtual bool hotplug() = 0;
+
+         // wait up to timeout milliseconds for bus changes, returns true if any change happened
+         virtual bool wait(int timeout) = 0;
+
+         // list currently available devices
+         virtual std::vector<std::string> enumerate() = 0;
+      };
+
+   public:
+
+      // default backend uses libusb hotplug notifications and DeviceFactory enumeration
+      explicit DeviceMonitor(std::shared_ptr<Backend> backend = nullptr, int pollInterval = 5000, int settleTime = 250);
+
+      // cached device list, does not enumerate
+      std::vector<std::string> deviceList() const;
+
+      // true if backend notifies bus changes
+      bool isHotplug() const;
+
+      // process bus changes, calls handler for each attached or detached device and returns number of events
+      int update(const EventHandler &handler, int timeout = 0);
+
+      // number of enumerations done
+      long enumerations() const;
+
+   private:
+
+      std::shared_ptr<Impl> impl;
+};
+
+}
+
+#endif
@@ -0,0 +1,65 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef SDR_IQCONVERTER_H
+#define SDR_IQCONVERTER_H
+
+#include <memory>
+#include <vector>
+
+namespace sdr {
+
+/*
+ * Real to complex converter for receivers sampling at twice the output rate with the band of interest centered at Fs/4 (Airspy),
+ * performs DC removal, Fs/4 translation, half-band decimation and magnitude in a single pass over the raw samples
+ */
+class IqConverter
+{
+      struct Impl;
+
+   public:
+
+      // raw sample scale and initial DC offset, defaults for signed 16 bit samples
+      explicit IqConverter(float scale = 1.0f / 32768, float offset = 0);
+
+      // convert count real samples into count / 2 interleaved I/Q values and its magnitude, magnitude may be null
+      unsigned int process(const short *samples, unsigned int count, float *iq, float *magnitude);
+
+      // clear filter state and DC estimation
+      void reset();
+
+      // current DC offset estimation, in raw sample units
+      float offset() const;
+
+      // half-band filter kernel, applied at input sample rate
+      static const std::vector<float> &kernel();
+
+   private:
+
+      std::shared_ptr<Impl> impl;
+};
+
+}
+
+#endif
@@ -0,0 +1,57 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef SDR_LOOKUPCONVERTER_H
+#define SDR_LOOKUPCONVERTER_H
+
+#include <memory>
+
+namespace sdr {
+
+/*
+ * Unsigned 8 bit I/Q samples to float conversion through a lookup table, computing magnitude in the same pass (RTL-SDR)
+ */
+class LookupConverter
+{
+      struct Impl;
+
+   public:
+
+      // each sample value is converted as (value - offset) * scale + bias, defaults match RTL-SDR devices
+      explicit LookupConverter(float scale = 1.0f / 256, float offset = 128, float bias = 0.0025f);
+
+      // convert count bytes into count floats and count / 2 magnitudes, magnitude may be null
+      unsigned int process(const unsigned char *samples, unsigned int count, float *iq, float *magnitude) const;
+
+      // converted value for single sample
+      float value(unsigned char sample) const;
+
+   private:
+
+      std::shared_ptr<Impl> impl;
+};
+
+}
+
+#endif
@@ -29,6 +29,7 @@
 #include <vector>
 
 #include <sdr/SignalDevice.h>
+#include <sdr/SignalBuffer.h>
 
 namespace sdr {
 
@@ -36,6 +36,8 @@ namespace sdr {
 
 class RealtekDevice : public RadioDevice
 {
+   public:
+
       struct Impl;
 
    public:
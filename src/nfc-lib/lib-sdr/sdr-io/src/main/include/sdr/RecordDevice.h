@@ -33,12 +33,15 @@
 
 namespace sdr {
 
+class RecordIndex;
+
 class RecordDevice : public SignalDevice
 {
       struct Impl;
 
    public:
 
+      // name is "record://<file>", files with ".nfcz" extension are stored as lossless compressed chunks
       explicit RecordDevice(const std::string &name);
 
       const std::string &name() override;
@@ -57,9 +60,29 @@ class RecordDevice : public SignalDevice
 
       bool isStreaming() const override;
 
-      int sampleCount() const;
+      long long sampleCount() const;
+
+      long long sampleOffset() const;
+
+      // bytes queued for writing but not yet stored
+      long long writeBacklog() const;
+
+      // average write rate in bytes per second
+      double writeRate() const;
+
+      // move read position to given sample (per channel), returns 0 on success
+      int seek(long long sample);
+
+      // move read position to given time in seconds from start of file, returns 0 on success
+      int seekTime(double time);
+
+      // block index for random access, loaded from sidecar file or built on first call in read mode
+      const RecordIndex &index() const;
+
+      bool isIndexEnabled() const;
 
-      int sampleOffset() const;
+      // enable sidecar index file when recording or building index, enabled by default
+      void setIndexEnabled(bool enabled);
 
       int sampleSize() const override;
 
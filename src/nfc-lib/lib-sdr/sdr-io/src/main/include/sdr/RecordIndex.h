@@ -0,0 +1,101 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef SDR_RECORDINDEX_H
+#define SDR_RECORDINDEX_H
+
+#include <string>
+#include <memory>
+#include <vector>
+
+namespace sdr {
+
+/*
+ * Block index for signal recordings, maps sample offsets to file offsets and keeps per-block envelope statistics
+ */
+class RecordIndex
+{
+      struct Impl;
+
+   public:
+
+      enum Flags
+      {
+         Carrier = 1
+      };
+
+      struct Entry
+      {
+         long long sampleOffset; // first sample of block, per channel
+         long long byteOffset; // file offset of first sample
+         float minimum; // minimum signal envelope
+         float maximum; // maximum signal envelope
+         float average; // mean signal envelope
+         unsigned int flags; // block flags
+      };
+
+   public:
+
+      RecordIndex();
+
+      RecordIndex(unsigned int blockSize, unsigned int channelCount, unsigned int sampleSize, unsigned int sampleRate, long long dataStart);
+
+      bool isEmpty() const;
+
+      unsigned int blockSize() const;
+
+      long long sampleCount() const;
+
+      const std::vector<Entry> &entries() const;
+
+      // index entry containing given sample, or -1 if out of range
+      int find(long long sample) const;
+
+      // first sample from given one in a block with carrier present, or -1 if none
+      long long nextCarrier(long long sample) const;
+
+      // accumulate interleaved float samples from current end of index
+      void update(const float *samples, unsigned int count);
+
+      // close last partial block
+      void finish();
+
+      void clear();
+
+      // load index from file, fails if it does not match the expected recording layout
+      bool load(const std::string &file, long long sampleCount);
+
+      bool save(const std::string &file) const;
+
+      // sidecar file name for recording
+      static std::string path(const std::string &file);
+
+   private:
+
+      std::shared_ptr<Impl> impl;
+};
+
+}
+
+#endif
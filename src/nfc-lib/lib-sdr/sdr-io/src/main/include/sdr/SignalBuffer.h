@@ -53,9 +53,27 @@ class SignalBuffer : public rt::Buffer<float>
 
       unsigned int sampleRate() const;
 
+      // monotonic time in nanoseconds when buffer was captured by device, 0 if not traced
+      long long captureTime() const;
+
+      void setCaptureTime(long long time);
+
+      // monotonic time in nanoseconds when buffer was published by receiver, 0 if not traced
+      long long publishTime() const;
+
+      void setPublishTime(long long time);
+
+      // view of elements [from, to) sharing the same samples, offset() is adjusted to the first sample of the view
+      SignalBuffer slice(unsigned int from, unsigned int to) const;
+
    private:
 
-      std::shared_ptr<Impl> impl;
+      explicit SignalBuffer(const rt::Buffer<float> &view);
+
+      // signal metadata is stored in buffer allocation extension area, shared by all views of the same samples
+      const Impl *impl() const;
+
+      Impl *impl();
 };
 
 }
@@ -0,0 +1,79 @@
+/*
+
+  Copyright (c) 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#ifndef SDR_SIGNALKERNEL_H
+#define SDR_SIGNALKERNEL_H
+
+#include <sdr/SignalBuffer.h>
+
+namespace sdr {
+
+/*
+ * Vectorized signal kernels, variant for each instruction set selected at startup from CPU features
+ */
+class SignalKernel
+{
+   public:
+
+      enum Level
+      {
+         Generic = 0,
+         SSE = 1,
+         AVX2 = 2,
+         AVX512 = 3
+      };
+
+   public:
+
+      // PCM to float conversion, scale is 1 / full range
+      static void convert(const char *src, float *dst, unsigned int count, float scale);
+
+      static void convert(const short *src, float *dst, unsigned int count, float scale);
+
+      static void convert(const int *src, float *dst, unsigned int count, float scale);
+
+      // magnitude of interleaved float I/Q pairs
+      static void magnitude(const float *iq, float *magnitude, unsigned int count);
+
+      // new real buffer with magnitude of remaining I/Q samples
+      static SignalBuffer magnitude(const SignalBuffer &iq);
+
+      // apply real window to count I/Q pairs taken every stride pairs
+      static void window(const float *iq, const float *window, float *result, unsigned int count, unsigned int stride);
+
+      // current kernel level
+      static int level();
+
+      // highest level supported by this build and CPU
+      static int supported();
+
+      // force kernel level for testing, limited to supported level, returns selected level
+      static int select(int level);
+
+      static const char *name(int level);
+};
+
+}
+
+#endif
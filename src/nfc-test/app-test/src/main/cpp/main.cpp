@@ -22,34 +22,62 @@
 
 */
 
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+#include <chrono>
+#include <complex>
+#include <iomanip>
 #include <iostream>
 #include <fstream>
-#include <iomanip>
-#include <nlohmann/json.hpp>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include <random>
 
 #include <rt/Logger.h>
+#include <rt/Buffer.h>
 #include <rt/FileSystem.h>
+#include <rt/Executor.h>
+#include <rt/Subject.h>
+#include <rt/Event.h>
 
 #include <sdr/SignalType.h>
 #include <sdr/RecordDevice.h>
+#include <sdr/RecordIndex.h>
+#include <sdr/IqConverter.h>
+#include <sdr/LookupConverter.h>
+#include <sdr/SignalKernel.h>
+#include <sdr/DeviceMonitor.h>
 
+#include <nfc/Nfc.h>
 #include <nfc/NfcFrame.h>
 #include <nfc/NfcDecoder.h>
+#include <nfc/NfcEncoder.h>
+#include <nfc/JsonFrameReader.h>
+#include <nfc/JsonFrameWriter.h>
+#include <nfc/FrameStore.h>
+#include <nfc/FrameHistory.h>
+#include <nfc/FrameDecoderTask.h>
+#include <nfc/SignalReceiverTask.h>
+
+#include <nlohmann/json.hpp>
 
 using namespace rt;
-using namespace nlohmann;
 
 Logger logger {"main"};
 
 /*
- * Read frames from JSON storage
+ * Read frames from JSON storage, parsed independently from JsonFrameReader to be used as reference
  */
 bool readFrames(const std::string &path, std::list<nfc::NfcFrame> &list)
 {
    if (!rt::FileSystem::exists(path))
       return false;
 
-   json data;
+   nlohmann::json data;
 
    // open file
    std::ifstream input(path);
@@ -60,6 +88,9 @@ bool readFrames(const std::string &path, std::list<nfc::NfcFrame> &list)
    if (!data.contains("frames"))
       return false;
 
+   // non finite values are stored as null
+   auto number = [](const nlohmann::json &value) { return value.is_null() ? NAN : value.get<double>(); };
+
    // read frames from file
    for (const auto &entry: data["frames"])
    {
@@ -70,8 +101,8 @@ bool readFrames(const std::string &path, std::list<nfc::NfcFrame> &list)
       frame.setFramePhase(entry["framePhase"]);
       frame.setFrameFlags(entry["frameFlags"]);
       frame.setFrameRate(entry["frameRate"]);
-      frame.setTimeStart(entry["timeStart"]);
-      frame.setTimeEnd(entry["timeEnd"]);
+      frame.setTimeStart(number(entry["timeStart"]));
+      frame.setTimeEnd(number(entry["timeEnd"]));
       frame.setSampleStart(entry["sampleStart"]);
       frame.setSampleEnd(entry["sampleEnd"]);
 
@@ -95,7 +126,7 @@ bool readFrames(const std::string &path, std::list<nfc::NfcFrame> &list)
  */
 bool writeFrames(const std::string &path, std::list<nfc::NfcFrame> &list)
 {
-   json frames = json::array();
+   nlohmann::json frames = nlohmann::json::array();
 
    for (const auto &frame: list)
    {
@@ -122,7 +153,7 @@ bool writeFrames(const std::string &path, std::list<nfc::NfcFrame> &list)
       }
    }
 
-   json info({{"frames", frames}});
+   nlohmann::json info({{"frames", frames}});
 
    std::ofstream output(path);
 
@@ -132,9 +163,9 @@ bool writeFrames(const std::string &path, std::list<nfc::NfcFrame> &list)
 }
 
 /*
- * Read frames from WAV file
+ * Read frames from WAV file, real samples may be rotated into I/Q buffers to test decoder I/Q input
  */
-bool readSignal(const std::string &path, std::list<nfc::NfcFrame> &list)
+bool readSignal(const std::string &path, std::list<nfc::NfcFrame> &list, bool iq = false)
 {
    if (!rt::FileSystem::exists(path))
       return false;
@@ -159,6 +190,20 @@ bool readSignal(const std::string &path, std::list<nfc::NfcFrame> &list)
 
       if (source.read(samples) > 0)
       {
+         if (iq && source.channelCount() == 1)
+         {
+            sdr::SignalBuffer rotated(samples.elements() * 2, 2, source.sampleRate(), 0, 0, sdr::SignalType::SAMPLE_IQ);
+
+            for (unsigned int i = 0; i < samples.elements(); i++)
+            {
+               rotated.put(samples[i] * std::cos(0.7f)).put(samples[i] * std::sin(0.7f));
+            }
+
+            rotated.flip();
+
+            samples = rotated;
+         }
+
          for (const nfc::NfcFrame &frame: decoder.nextFrames(samples))
          {
             if (frame.isPollFrame() || frame.isListenFrame())
@@ -172,78 +217,1575 @@ bool readSignal(const std::string &path, std::list<nfc::NfcFrame> &list)
    return true;
 }
 
-int testFile(const std::string &signal)
+/*
+ * Synthesize frames with encoder and decode the resulting signal
+ */
+bool encodeSignal(const std::list<nfc::NfcFrame> &frames, std::list<nfc::NfcFrame> &list, int sampleType)
 {
-   size_t pos1 = signal.find(".wav");
-   size_t pos2 = signal.rfind("/");
+   nfc::NfcEncoder encoder;
+   nfc::NfcDecoder decoder;
 
-   if (pos1 == std::string::npos)
-      return -1;
+   encoder.setSampleType(sampleType);
 
-   std::string target = signal.substr(0, pos1) + ".json";
-   std::string filename = signal;
+   decoder.setEnableNfcA(true);
+   decoder.setEnableNfcB(true);
+   decoder.setEnableNfcF(true);
+   decoder.setEnableNfcV(true);
 
-   if (pos2 != std::string::npos)
-      filename = signal.substr(pos2 + 1, pos1 - 4);
+   encoder.encode(frames);
 
-   std::list<nfc::NfcFrame> list1;
-   std::list<nfc::NfcFrame> list2;
+   // synthesize all frames plus some idle carrier so decoder can finish last one
+   long end = std::lround((encoder.queueTime() + 1E-3) * encoder.sampleRate());
 
-   // decode frames from signal
-   if (readSignal(signal, list1))
+   while (encoder.pendingFrames() > 0 || encoder.sampleOffset() < end)
    {
-      // read frames from json file
-      if (readFrames(target, list2))
+      for (const nfc::NfcFrame &frame: decoder.nextFrames(encoder.nextSamples(65536)))
       {
-         // show result
-         std::cout << "TEST FILE " << filename << ": " << (list1 == list2 ? "PASS" : "FAIL") << std::endl;
+         if (frame.isPollFrame() || frame.isListenFrame())
+         {
+            list.push_back(frame);
+         }
       }
-      else
-      {
-         // or create json file if not exists at first time
-         writeFrames(target, list1);
+   }
 
-         std::cout << "TEST FILE " << filename << ": TEST UPDATED!" << std::endl;
-      }
+   return true;
+}
+
+/*
+ * Compare frame content, ignoring timing and parity errors
+ */
+bool sameContent(const std::list<nfc::NfcFrame> &list1, const std::list<nfc::NfcFrame> &list2)
+{
+   if (list1.size() != list2.size())
+      return false;
+
+   for (auto a = list1.begin(), b = list2.begin(); a != list1.end(); a++, b++)
+   {
+      if (a->techType() != b->techType() || a->frameType() != b->frameType() || a->frameRate() != b->frameRate())
+         return false;
+
+      // frames do not keep parity bits, encoder always generates valid parity
+      if ((a->frameFlags() & ~nfc::FrameFlags::ParityError) != (b->frameFlags() & ~nfc::FrameFlags::ParityError))
+         return false;
+
+      if (a->limit() != b->limit() || !std::equal(a->data(), a->data() + a->limit(), b->data()))
+         return false;
    }
 
-   return 0;
+   return true;
 }
 
-int testPath(const std::string &path)
+/*
+ * Temporary file path for tests
+ */
+std::string tempFile(const std::string &name)
 {
-   for (const auto &entry: rt::FileSystem::directoryList(path))
+   for (const char *env: {"TMPDIR", "TEMP", "TMP"})
    {
-      if (entry.name.find(".wav") != std::string::npos)
-      {
-         testFile(entry.name);
-      }
+      if (const char *value = std::getenv(env))
+         return std::string(value) + "/" + name;
+   }
+
+   return "/tmp/" + name;
+}
+
+/*
+ * Synthetic frames with all attributes set and variable payload size, including empty payloads
+ */
+std::vector<nfc::NfcFrame> makeFrames(int count)
+{
+   std::vector<nfc::NfcFrame> frames;
+
+   for (int i = 0; i < count; i++)
+   {
+      double time = i * 1E-3;
+
+      nfc::NfcFrame frame(nfc::TechType::NfcA + i % 4, i % 2 ? nfc::FrameType::ListenFrame : nfc::FrameType::PollFrame, time, time + 5E-4);
+
+      frame.setFramePhase(i % 3);
+      frame.setFrameFlags(i % 7 ? 0 : nfc::FrameFlags::CrcError);
+      frame.setFrameRate(106000 << (i % 3));
+      frame.setDateTime(1.6E9 + time);
+      frame.setSampleStart(i * 10000);
+      frame.setSampleEnd(i * 10000 + 5000);
+
+      for (int j = 0; j < i % 40; j++)
+         frame.put((unsigned char) (i + j));
+
+      frame.flip();
+
+      frames.push_back(frame);
+   }
+
+   return frames;
+}
+
+bool sameFrame(const nfc::NfcFrame &a, const nfc::NfcFrame &b)
+{
+   return a == b && a.techType() == b.techType() && a.timeStart() == b.timeStart() && a.timeEnd() == b.timeEnd() && a.dateTime() == b.dateTime();
+}
+
+bool checkStore(const std::string &path, const std::vector<nfc::NfcFrame> &frames)
+{
+   nfc::FrameStore store(path);
+
+   if (!store.open(nfc::FrameStore::Read) || store.count() != (long) frames.size())
+      return false;
+
+   for (long i = 0; i < store.count(); i++)
+   {
+      if (!sameFrame(store.frame(i), frames[i]))
+         return false;
+   }
+
+   return store.find(frames[frames.size() / 2].timeStart()) == (long) frames.size() / 2 && store.find(1E9) == store.count();
+}
+
+/*
+ * Test binary frame store round trip across several segments, recovery of files flushed but not closed and
+ * rejection of corrupt payload offsets
+ */
+int testBuffer()
+{
+   bool pass = true;
+
+   rt::Buffer<float> buffer(100);
+
+   for (int i = 0; i < 100; i++)
+      buffer.put(float(i));
+
+   buffer.flip();
+
+   {
+      // view has its own position and limit over shared elements
+      auto view = buffer.slice(10, 30);
+
+      pass &= view.position() == 0 && view.limit() == 20 && view.capacity() == 20 && view.origin() == 10;
+      pass &= view.data()[0] == 10 && view.data()[19] == 29 && buffer.references() == 2;
+
+      view.advance(5);
+
+      pass &= view.position() == 5 && buffer.position() == 0;
+
+      // view of remaining elements
+      auto rest = view.slice();
+
+      pass &= rest.origin() == 15 && rest.limit() == 15 && rest.data()[0] == 15;
+
+      // out of range views are empty
+      pass &= !buffer.slice(50, 101) && !buffer.slice(30, 10);
+
+      // shared allocation is not resized
+      buffer.resize(1000);
+      rest.resize(1000);
+
+      pass &= buffer.capacity() == 100 && rest.capacity() == 15 && view.data()[0] == 10;
    }
 
+   buffer.resize(200);
+
+   pass &= buffer.capacity() == 200 && buffer.limit() == 100 && buffer.data()[99] == 99;
+
+   // signal views keep stream sample offset
+   sdr::SignalBuffer signal(128, 2, 10000000, 1000, 0, sdr::SignalType::SAMPLE_IQ);
+
+   for (int i = 0; i < 128; i++)
+      signal.put(float(i));
+
+   signal.flip();
+
+   auto part = signal.slice(20, 40);
+
+   pass &= part.offset() == 1010 && part.elements() == 10 && part.stride() == 2 && part.sampleRate() == 10000000;
+   pass &= part[0] == 20 && part.type() == sdr::SignalType::SAMPLE_IQ;
+
+   std::cout << "TEST BUFFER slice: " << (pass ? "PASS" : "FAIL") << std::endl;
+
    return 0;
 }
 
-int main(int argc, char *argv[])
+/*
+ * Write samples to recording file
+ */
+bool writeRecord(const std::string &path, int sampleSize, int channels, const std::vector<float> &samples)
 {
-   logger.info("***********************************************************************");
-   logger.info("NFC laboratory, 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>");
-   logger.info("***********************************************************************");
+   sdr::RecordDevice target(path);
 
-   for (int i = 1; i < argc; i++)
+   target.setSampleRate(10000000);
+   target.setChannelCount(channels);
+   target.setSampleSize(sampleSize);
+
+   if (!target.open(sdr::RecordDevice::OpenMode::Write))
+      return false;
+
+   sdr::SignalBuffer buffer(samples.size(), channels, 10000000, 0, 0, channels == 2 ? sdr::SignalType::SAMPLE_IQ : sdr::SignalType::SAMPLE_REAL);
+
+   buffer.put(samples.data(), samples.size()).flip();
+
+   bool done = target.write(buffer) == samples.size();
+
+   target.close();
+
+   return done;
+}
+
+/*
+ * Read all samples from recording file
+ */
+bool readRecord(const std::string &path, std::vector<float> &samples)
+{
+   sdr::RecordDevice source(path);
+
+   if (!source.open(sdr::RecordDevice::OpenMode::Read))
+      return false;
+
+   while (!source.isEof())
    {
-      std::string path {argv[i]};
+      sdr::SignalBuffer buffer(65536 * source.channelCount(), source.channelCount(), source.sampleRate(), 0, 0, sdr::SignalType::SAMPLE_REAL);
 
-      if (rt::FileSystem::isDirectory(path))
+      if (source.read(buffer) > 0)
+         samples.insert(samples.end(), buffer.data(), buffer.data() + buffer.limit());
+   }
+
+   return true;
+}
+
+int testRecord()
+{
+   std::string path = tempFile("nfc-test-record.wav");
+
+   bool pass = true;
+
+   // full scale and out of range values, long enough to use vector conversion
+   std::vector<float> samples;
+
+   for (int i = 0; i < 64; i++)
+      samples.push_back(std::vector<float> {1.0f, -1.0f, 0.5f, 2.0f, -2.0f, 0.0f, -0.5f, 1.5f}[i % 8]);
+
+   for (int size: {8, 16, 32})
+   {
+      std::vector<float> result;
+
+      pass &= writeRecord(path, size, 1, samples) && readRecord(path, result) && result.size() == samples.size();
+
+      for (int i = 0; pass && i < samples.size(); i++)
       {
-         logger.info("processing path {}", {path});
+         // values saturate to nearest representable sample
+         float expected = std::clamp(samples[i], -1.0f, 1.0f);
 
-         testPath(path);
+         pass &= std::fabs(result[i] - expected) <= std::max(2.0f / float(1u << (size - 1)), 1E-6f);
       }
-      else if (rt::FileSystem::isRegularFile(path))
+   }
+
+   rt::FileSystem::removeFile(path);
+
+   std::cout << "TEST RECORD fullscale: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+   pass = true;
+
+   // RF64 file, 32 bit sizes are 0xFFFFFFFF and real sizes are taken from ds64 chunk
+   {
+      std::vector<short> pcm(1000);
+
+      for (int i = 0; i < pcm.size(); i++)
+         pcm[i] = short(i * 32 - 16000);
+
+      unsigned int dataSize = pcm.size() * sizeof(short);
+
+      std::ofstream output(path, std::ios::binary | std::ios::trunc);
+
+      auto tag = [&output](const char *id) { output.write(id, 4); };
+      auto u16 = [&output](unsigned short value) { output.write(reinterpret_cast<const char *>(&value), sizeof(value)); };
+      auto u32 = [&output](unsigned int value) { output.write(reinterpret_cast<const char *>(&value), sizeof(value)); };
+
+      tag("RF64"); u32(0xFFFFFFFF); tag("WAVE");
+      tag("ds64"); u32(28); u32(dataSize + 72); u32(0); u32(dataSize); u32(0); u32(pcm.size()); u32(0); u32(0);
+      tag("fmt "); u32(16); u16(1); u16(1); u32(10000000); u32(20000000); u16(2); u16(16);
+      tag("data"); u32(0xFFFFFFFF);
+      output.write(reinterpret_cast<const char *>(pcm.data()), dataSize);
+   }
+
+   {
+      sdr::RecordDevice source(path);
+
+      pass &= source.open(sdr::RecordDevice::OpenMode::Read) && source.sampleCount() == 1000 && source.channelCount() == 1 && source.sampleSize() == 16;
+   }
+
+   std::vector<float> result;
+
+   pass &= readRecord(path, result) && result.size() == 1000;
+
+   for (int i = 0; pass && i < result.size(); i++)
+      pass &= result[i] == float(short(i * 32 - 16000)) / 32768.0f;
+
+   rt::FileSystem::removeFile(path);
+
+   std::cout << "TEST RECORD rf64: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+   pass = true;
+
+   // index sidecar with corrupted entry count must be rejected and rebuilt
+   {
+      std::vector<float> signal(100000);
+
+      for (int i = 0; i < signal.size(); i++)
+         signal[i] = std::sin(float(i) * 0.1f) * 0.5f;
+
+      pass &= writeRecord(path, 16, 1, signal);
+
+      size_t blocks = 0;
+
       {
-         logger.info("processing file {}", {path});
+         sdr::RecordDevice source(path);
+
+         pass &= source.open(sdr::RecordDevice::OpenMode::Read);
+
+         blocks = source.index().entries().size();
+      }
+
+      pass &= blocks > 1;
+
+      for (long long count: {(long long) blocks + 1, -1LL, 1LL << 60})
+      {
+         std::fstream sidecar(sdr::RecordIndex::path(path), std::ios::in | std::ios::out | std::ios::binary);
+
+         // entry count follows magic, 5 layout fields and sample count
+         sidecar.seekp(32);
+         sidecar.write(reinterpret_cast<const char *>(&count), sizeof(count));
+         sidecar.close();
+
+         sdr::RecordDevice source(path);
+
+         pass &= source.open(sdr::RecordDevice::OpenMode::Read) && source.index().entries().size() == blocks;
+      }
+
+      rt::FileSystem::removeFile(sdr::RecordIndex::path(path));
+   }
+
+   rt::FileSystem::removeFile(path);
+
+   std::cout << "TEST RECORD index: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+   pass = true;
+
+   // random and full scale signals, 16 bit mono and IQ, stored as wav and compressed chunks
+   std::string packed = tempFile("nfc-test-record.nfcz");
+
+   std::mt19937 random(1234);
+   std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+   for (int channels: {1, 2})
+   {
+      std::vector<float> noise(150000 * channels);
+      std::vector<float> square(150000 * channels);
+
+      for (int i = 0; i < noise.size(); i++)
+      {
+         noise[i] = uniform(random);
+         square[i] = (i / 100) % 2 ? 1.0f : -1.0f;
+      }
+
+      for (const auto &signal: {noise, square})
+      {
+         std::vector<float> plain, compressed;
+
+         pass &= writeRecord(path, 16, channels, signal) && readRecord(path, plain) && plain.size() == signal.size();
+         pass &= writeRecord(packed, 16, channels, signal) && readRecord(packed, compressed) && compressed == plain;
+
+         for (int i = 0; pass && i < signal.size(); i++)
+            pass &= std::fabs(plain[i] - signal[i]) <= 2.0f / 32768.0f;
+
+         // random access, including positions inside second and last chunk
+         for (long long sample: {0LL, 70000LL, 149990LL})
+         {
+            sdr::RecordDevice source(packed);
+
+            sdr::SignalBuffer buffer(10 * channels, channels, 10000000, 0, 0, sdr::SignalType::SAMPLE_REAL);
+
+            pass &= source.open(sdr::RecordDevice::OpenMode::Read) && source.seek(sample) == 0 && source.read(buffer) == buffer.limit() && buffer.limit() == 10 * channels;
+            pass &= std::equal(buffer.data(), buffer.data() + buffer.limit(), plain.begin() + sample * channels);
+         }
+      }
+   }
+
+   rt::FileSystem::removeFile(sdr::RecordIndex::path(path));
+
+   std::cout << "TEST RECORD roundtrip: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+   pass = true;
+
+   // compressed file not closed or with corrupted table must recover all chunks by scanning
+   {
+      std::vector<float> signal(150000), expected;
+
+      for (int i = 0; i < signal.size(); i++)
+         signal[i] = uniform(random);
+
+      pass &= writeRecord(packed, 16, 1, signal) && readRecord(packed, expected) && expected.size() == signal.size();
+
+      // table offset and chunk count as if not closed, out of file and huge table
+      std::vector<std::pair<long long, unsigned int>> damages {{0, 0}, {1LL << 40, 3}, {-1, 0xFFFFFFF0}};
+
+      for (const auto &damage: damages)
+      {
+         std::vector<float> result;
+
+         pass &= writeRecord(packed, 16, 1, signal);
+
+         rt::FileSystem::removeFile(sdr::RecordIndex::path(packed));
+
+         {
+            std::fstream stream(packed, std::ios::in | std::ios::out | std::ios::binary);
+
+            long long tableOffset = damage.first;
+            unsigned int chunkCount = damage.second;
+
+            // table offset follows format, stream and sample count fields, -1 keeps current one
+            if (tableOffset < 0)
+            {
+               stream.seekg(32);
+               stream.read(reinterpret_cast<char *>(&tableOffset), sizeof(tableOffset));
+            }
+
+            stream.seekp(32);
+            stream.write(reinterpret_cast<const char *>(&tableOffset), sizeof(tableOffset));
+            stream.write(reinterpret_cast<const char *>(&chunkCount), sizeof(chunkCount));
+         }
+
+         pass &= readRecord(packed, result) && result == expected;
+      }
+   }
+
+   rt::FileSystem::removeFile(sdr::RecordIndex::path(packed));
+   rt::FileSystem::removeFile(packed);
+
+   std::cout << "TEST RECORD recovery: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+   return 0;
+}
 
-         testFile(path);
+int testFrameStore()
+{
+   std::string path = tempFile("nfc-test-store.nfcd");
+
+   auto frames = makeFrames(10000);
+
+   bool pass = true;
+
+   {
+      nfc::FrameStore store(path);
+
+      pass &= store.open(nfc::FrameStore::Write);
+
+      for (const auto &frame: frames)
+         pass &= store.append(frame);
+
+      store.close();
+   }
+
+   pass &= nfc::FrameStore::isFrameFile(path) && checkStore(path, frames);
+
+   std::cout << "TEST FRAMESTORE roundtrip: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+   pass = true;
+
+   {
+      nfc::FrameStore store(path);
+
+      pass &= store.open(nfc::FrameStore::Write);
+
+      for (const auto &frame: frames)
+         pass &= store.append(frame);
+
+      // index is not written until close, segments are scanned
+      pass &= store.flush() && checkStore(path, frames);
+   }
+
+   std::cout << "TEST FRAMESTORE recovery: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+   pass = true;
+
+   {
+      std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+
+      // second payload offset of first segment, placed after header and columns of 4096 frames
+      unsigned int offset = 0xfffffff0;
+
+      file.seekp(64 + 32 + 4096 * (8 * 3 + 8 * 2 + 4 * 2) + 4);
+      file.write(reinterpret_cast<const char *>(&offset), sizeof(offset));
+      file.close();
+
+      nfc::FrameStore store(path);
+
+      pass &= !store.open(nfc::FrameStore::Read);
+   }
+
+   std::cout << "TEST FRAMESTORE corrupt: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+   rt::FileSystem::removeFile(path);
+
+   return 0;
+}
+
+/*
+ * Test JSON frame writer output is read back with same values, non finite values are written as null
+ */
+int testJsonWriter()
+{
+   std::string path = tempFile("nfc-test-frames.json");
+
+   auto frames = makeFrames(1000);
+
+   nfc::NfcFrame invalid(nfc::TechType::NfcA, nfc::FrameType::PollFrame, 1.0, NAN);
+
+   invalid.flip();
+
+   bool pass = true;
+
+   {
+      nfc::JsonFrameWriter writer(path);
+
+      pass &= writer.open();
+
+      for (const auto &frame: frames)
+         pass &= writer.append(frame);
+
+      pass &= writer.append(invalid);
+
+      writer.close();
+   }
+
+   std::list<nfc::NfcFrame> list;
+
+   pass &= readFrames(path, list) && list.size() == frames.size() + 1;
+
+   auto frame = list.begin();
+
+   for (int i = 0; pass && i < frames.size(); i++, frame++)
+      pass &= *frame == frames[i] && frame->timeStart() == frames[i].timeStart() && frame->timeEnd() == frames[i].timeEnd();
+
+   std::ifstream input(path);
+   std::string text((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+   pass &= text.find("\"timeStart\": 1.0") != std::string::npos && text.find("\"timeEnd\": null") != std::string::npos;
+
+   rt::FileSystem::removeFile(path);
+
+   std::cout << "TEST JSON writer: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+   return 0;
+}
+
+/*
+ * Test JSON frame reader gives same frames as reference parser
+ */
+int testJsonReader(const std::string &target)
+{
+   size_t pos1 = target.find(".json");
+   size_t pos2 = target.rfind("/");
+
+   if (pos1 == std::string::npos)
+      return -1;
+
+   std::string filename = target;
+
+   if (pos2 != std::string::npos)
+      filename = target.substr(pos2 + 1, pos1 - pos2 - 1);
+
+   std::list<nfc::NfcFrame> list1;
+   std::list<nfc::NfcFrame> list2;
+
+   if (!readFrames(target, list1))
+      return -1;
+
+   nfc::JsonFrameReader reader(target);
+
+   bool pass = reader.read([&list2](const nfc::NfcFrame &frame) {
+      list2.push_back(frame);
+      return true;
+   });
+
+   pass &= list1.size() == list2.size();
+
+   for (auto a = list1.begin(), b = list2.begin(); pass && a != list1.end(); a++, b++)
+   {
+      pass &= *a == *b && a->techType() == b->techType() && a->frameType() == b->frameType() && a->framePhase() == b->framePhase() && a->frameFlags() == b->frameFlags() && a->frameRate() == b->frameRate();
+      pass &= a->timeStart() == b->timeStart() && a->timeEnd() == b->timeEnd() && a->sampleStart() == b->sampleStart() && a->sampleEnd() == b->sampleEnd();
+   }
+
+   std::cout << "TEST JSON reader " << filename << ": " << (pass ? "PASS" : "FAIL") << std::endl;
+
+   return 0;
+}
+
+int testFrameHistory()
+{
+   std::string path = tempFile("nfc-test-history");
+   std::string stale = path + "/999999999-0/frames-000042.nfcd";
+
+   auto frames = makeFrames(5000);
+
+   bool pass = true;
+
+   // spool session left by a process no longer running, without and with its unlocked lock file
+   for (bool locked: {false, true})
+   {
+      rt::FileSystem::truncateFile(stale);
+
+      if (locked)
+         rt::FileSystem::truncateFile(path + "/999999999-0/owner.lock");
+
+      nfc::FrameHistory history;
+
+      history.setSpoolPath(path);
+
+      pass &= !rt::FileSystem::exists(stale) && !rt::FileSystem::exists(path + "/999999999-0");
+   }
+
+   {
+      // history running at same time with same spool path
+      nfc::FrameHistory other;
+
+      other.setMemoryFrames(10);
+      other.setSpoolPath(path);
+
+      for (const auto &frame: makeFrames(100))
+         other.append(frame);
+
+      nfc::FrameHistory history;
+
+      history.setMemoryFrames(1000);
+      history.setSpoolPath(path);
+
+      long count = 0;
+
+      other.forEach([&count](const nfc::NfcFrame &) { count++; });
+
+      pass &= count == 100;
+
+      for (const auto &frame: frames)
+      {
+         history.append(frame);
+
+         pass &= history.memorySize() <= 1000;
+      }
+
+      pass &= history.size() == frames.size();
+
+      std::vector<nfc::NfcFrame> visited;
+
+      history.forEach([&visited](const nfc::NfcFrame &frame) {
+         visited.push_back(frame);
+      });
+
+      pass &= visited.size() == frames.size();
+
+      for (int i = 0; pass && i < frames.size(); i++)
+         pass &= sameFrame(visited[i], frames[i]);
+
+      count = 0;
+
+      other.forEach([&count](const nfc::NfcFrame &) { count++; });
+
+      pass &= count == 100;
+
+      history.clear();
+
+      pass &= history.size() == 0 && rt::FileSystem::exists(path);
+
+      other.clear();
+
+      pass &= !rt::FileSystem::exists(path);
+   }
+
+   std::cout << "TEST FRAMEHISTORY memory: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+   pass = true;
+
+   {
+      nfc::FrameHistory history;
+
+      history.setMemoryFrames(100);
+      history.setSpoolPath(path);
+      history.setRetentionBytes(1);
+
+      // retention is checked every 4096 frames, active spool file counts toward disk limit
+      for (int i = 0; i < 4; i++)
+      {
+         for (const auto &frame: makeFrames(4096))
+            history.append(frame);
+
+         pass &= history.spoolBytes() <= 1 && history.memorySize() == 100;
+      }
+   }
+
+   pass &= !rt::FileSystem::exists(path);
+
+   std::cout << "TEST FRAMEHISTORY retention: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+   return 0;
+}
+
+int testFile(const std::string &signal)
+{
+   size_t pos1 = signal.find(".wav");
+   size_t pos2 = signal.rfind("/");
+
+   if (pos1 == std::string::npos)
+      return -1;
+
+   std::string target = signal.substr(0, pos1) + ".json";
+   std::string filename = signal;
+
+   if (pos2 != std::string::npos)
+      filename = signal.substr(pos2 + 1, pos1 - 4);
+
+   std::list<nfc::NfcFrame> list1;
+   std::list<nfc::NfcFrame> list2;
+
+   // decode frames from signal
+   if (readSignal(signal, list1))
+   {
+      // read frames from json file
+      if (readFrames(target, list2))
+      {
+         // show result
+         std::cout << "TEST FILE " << filename << ": " << (list1 == list2 ? "PASS" : "FAIL") << std::endl;
+
+         std::list<nfc::NfcFrame> list3;
+
+         // same signal decoded from I/Q buffers
+         if (readSignal(signal, list3, true))
+         {
+            std::cout << "TEST FILE IQ " << filename << ": " << (list3 == list2 ? "PASS" : "FAIL") << std::endl;
+         }
+      }
+      else
+      {
+         // or create json file if not exists at first time
+         writeFrames(target, list1);
+
+         std::cout << "TEST FILE " << filename << ": TEST UPDATED!" << std::endl;
+      }
+   }
+
+   return 0;
+}
+
+int testEncoder(const std::string &target)
+{
+   size_t pos1 = target.find(".json");
+   size_t pos2 = target.rfind("/");
+
+   if (pos1 == std::string::npos)
+      return -1;
+
+   std::string filename = target;
+
+   if (pos2 != std::string::npos)
+      filename = target.substr(pos2 + 1, pos1 - pos2 - 1);
+
+   std::list<nfc::NfcFrame> list1;
+
+   if (!readFrames(target, list1))
+      return -1;
+
+   std::list<nfc::NfcFrame> list2;
+   std::list<nfc::NfcFrame> list3;
+
+   // encode frames as magnitude signal and decode back
+   if (encodeSignal(list1, list2, sdr::SignalType::SAMPLE_REAL))
+   {
+      std::cout << "TEST ENCODER " << filename << ": " << (sameContent(list1, list2) ? "PASS" : "FAIL") << std::endl;
+   }
+
+   // same frames encoded as I/Q signal
+   if (encodeSignal(list1, list3, sdr::SignalType::SAMPLE_IQ))
+   {
+      std::cout << "TEST ENCODER IQ " << filename << ": " << (sameContent(list1, list3) ? "PASS" : "FAIL") << std::endl;
+   }
+
+   return 0;
+}
+
+/*
+ * Compare converter output against direct complex convolution, samples are processed in the given block sizes
+ */
+bool checkIqConverter(const std::vector<unsigned short> &samples, const std::vector<unsigned int> &blocks, float scale, float offset)
+{
+   const std::vector<float> &kernel = sdr::IqConverter::kernel();
+
+   sdr::IqConverter converter(scale, offset);
+
+   std::vector<float> iq(samples.size());
+   std::vector<float> magnitude(samples.size() / 2);
+   std::vector<std::complex<double>> shifted(samples.size());
+
+   double dc = offset;
+   double error = 0;
+   double elapsed = 0;
+
+   unsigned int input = 0;
+   unsigned int output = 0;
+
+   for (unsigned int i = 0; input < samples.size(); i++)
+   {
+      unsigned int count = std::min((unsigned int) samples.size() - input, blocks[i % blocks.size()]) & ~1;
+
+      if (count == 0)
+         break;
+
+      auto start = std::chrono::steady_clock::now();
+
+      unsigned int length = converter.process((const short *) samples.data() + input, count, iq.data() + output * 2, magnitude.data() + output);
+
+      elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      if (length != count / 2)
+         return false;
+
+      // Fs/4 translation, -1, -j, 1, j
+      static const std::complex<double> rotation[] = {{-1, 0}, {0, -1}, {1, 0}, {0, 1}};
+
+      double sum = 0;
+
+      for (unsigned int n = input; n < input + count; n++)
+      {
+         shifted[n] = rotation[n & 3] * ((samples[n] - dc) * scale);
+         sum += samples[n];
+      }
+
+      dc += (sum / count - dc) * 0.25;
+
+      // decimated half-band filter output
+      for (unsigned int m = output; m < output + length; m++)
+      {
+         std::complex<double> value;
+
+         for (int k = 0; k < kernel.size(); k++)
+         {
+            if (m * 2 >= k)
+               value += double(kernel[k]) * shifted[m * 2 - k];
+         }
+
+         error = std::max(error, std::abs(value.real() - iq[m * 2 + 0]));
+         error = std::max(error, std::abs(value.imag() - iq[m * 2 + 1]));
+         error = std::max(error, std::abs(std::abs(value) - magnitude[m]));
+      }
+
+      input += count;
+      output += length;
+   }
+
+   logger.info("converter max error {} throughput {.2} Msps", {error, output / elapsed / 1E6});
+
+   return error < 1E-4;
+}
+
+/*
+ * Test real to I/Q converter with synthetic signal, 100% ASK modulated carrier at Fs/4 + 1MHz
+ */
+int testIqConverter()
+{
+   std::vector<unsigned short> samples(1 << 20);
+
+   for (int n = 0; n < samples.size(); n++)
+   {
+      double level = (n / 1500) % 8 == 0 ? 0 : 1200;
+
+      samples[n] = (unsigned short) std::lround(2051 + level * std::cos(2 * M_PI * (0.25 + 1 / 20.0) * n));
+   }
+
+   // odd sizes force scalar tails and rotation phase changes between blocks
+   bool pass = checkIqConverter(samples, {65536, 1002, 4098, 131072, 6}, 1.0f / 2048, 2048);
+
+   std::cout << "TEST CONVERTER iq: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+   return 0;
+}
+
+/*
+ * Test real to I/Q converter with raw Airspy samples (airspy_rx -t 4), 12 bit unsigned little endian
+ */
+int testIqConverter(const std::string &file)
+{
+   size_t pos = file.rfind('/');
+
+   std::string filename = pos != std::string::npos ? file.substr(pos + 1) : file;
+
+   std::ifstream stream(file, std::ios::binary);
+
+   if (!stream)
+      return -1;
+
+   std::vector<unsigned char> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+   std::vector<unsigned short> samples(data.size() / 2);
+
+   for (size_t i = 0; i < samples.size(); i++)
+      samples[i] = data[i * 2] | data[i * 2 + 1] << 8;
+
+   // same transfer size as libairspy
+   bool pass = checkIqConverter(samples, {131072}, 1.0f / 2048, 2048);
+
+   std::cout << "TEST CONVERTER " << filename << ": " << (pass ? "PASS" : "FAIL") << std::endl;
+
+   return 0;
+}
+
+/*
+ * Compare lookup conversion against direct formula, also measures throughput of both methods
+ */
+bool checkLookupConverter(const std::vector<unsigned char> &samples)
+{
+   sdr::LookupConverter converter;
+
+   std::vector<float> iq1(samples.size()), iq2(samples.size());
+   std::vector<float> magnitude1(samples.size() / 2), magnitude2(samples.size() / 2);
+
+   // direct conversion, as previous RTL-SDR reader followed by magnitude
+   auto start = std::chrono::steady_clock::now();
+
+   for (size_t i = 0; i < samples.size(); i++)
+      iq1[i] = float((samples[i] - 128) / 256.0) + 0.0025f;
+
+   for (size_t i = 0; i < samples.size() / 2; i++)
+      magnitude1[i] = std::sqrt(iq1[i * 2] * iq1[i * 2] + iq1[i * 2 + 1] * iq1[i * 2 + 1]);
+
+   double elapsed1 = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+   // lookup conversion, same transfer size as RTL-SDR reader
+   start = std::chrono::steady_clock::now();
+
+   for (size_t i = 0; i < samples.size(); i += 131072)
+   {
+      unsigned int count = std::min(samples.size() - i, (size_t) 131072);
+
+      converter.process(samples.data() + i, count, iq2.data() + i, magnitude2.data() + i / 2);
+   }
+
+   double elapsed2 = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+   logger.info("lookup throughput {.2} Msps, direct throughput {.2} Msps", {samples.size() / 2 / elapsed2 / 1E6, samples.size() / 2 / elapsed1 / 1E6});
+
+   return iq1 == iq2 && magnitude1 == magnitude2;
+}
+
+/*
+ * Test lookup converter with all possible I/Q pairs
+ */
+int testLookupConverter()
+{
+   std::vector<unsigned char> samples(1 << 22);
+
+   for (size_t i = 0; i < samples.size(); i++)
+      samples[i] = (unsigned char) (i & 1 ? i >> 9 : i >> 1);
+
+   bool pass = checkLookupConverter(samples);
+
+   std::cout << "TEST CONVERTER lookup: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+   return 0;
+}
+
+/*
+ * Test lookup converter with RTL-SDR u8 I/Q dump (rtl_sdr output)
+ */
+int testLookupConverter(const std::string &file)
+{
+   size_t pos = file.rfind('/');
+
+   std::string filename = pos != std::string::npos ? file.substr(pos + 1) : file;
+
+   std::ifstream stream(file, std::ios::binary);
+
+   if (!stream)
+      return -1;
+
+   std::vector<unsigned char> samples((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+   bool pass = checkLookupConverter(samples);
+
+   std::cout << "TEST CONVERTER " << filename << ": " << (pass ? "PASS" : "FAIL") << std::endl;
+
+   return 0;
+}
+
+/*
+ * Run all signal kernels with current level, odd sizes to exercise vector tails
+ */
+std::vector<std::vector<float>> runKernels(const std::vector<short> &pcm, const std::vector<float> &window)
+{
+   unsigned int count = pcm.size() / 2;
+
+   std::vector<char> pcm8(pcm.size());
+   std::vector<int> pcm32(pcm.size());
+
+   for (size_t i = 0; i < pcm.size(); i++)
+   {
+      pcm8[i] = (char) (pcm[i] >> 8);
+      pcm32[i] = (int) pcm[i] << 16;
+   }
+
+   std::vector<std::vector<float>> result(6);
+
+   for (auto &r: result)
+      r.resize(pcm.size());
+
+   sdr::SignalKernel::convert(pcm8.data(), result[0].data(), pcm.size(), 1.0f / 128);
+   sdr::SignalKernel::convert(pcm.data(), result[1].data(), pcm.size(), 1.0f / 32768);
+   sdr::SignalKernel::convert(pcm32.data(), result[2].data(), pcm.size(), 1.0f / 2147483648.0f);
+   sdr::SignalKernel::magnitude(result[1].data(), result[3].data(), count);
+   sdr::SignalKernel::window(result[1].data(), window.data(), result[4].data(), window.size(), 1);
+   sdr::SignalKernel::window(result[1].data(), window.data(), result[5].data(), window.size(), 16);
+
+   return result;
+}
+
+/*
+ * Test each supported kernel variant gives same results as generic kernels
+ */
+int testKernel()
+{
+   int supported = sdr::SignalKernel::supported();
+
+   std::vector<short> pcm(2 * 65536 + 2 * 13);
+   std::vector<float> window(pcm.size() / 2 / 16 - 3);
+
+   for (size_t i = 0; i < pcm.size(); i++)
+      pcm[i] = (short) (32767 * std::sin(0.01 * i) * std::cos(0.0003 * i) + (i & 1 ? 7 : -5));
+
+   for (size_t i = 0; i < window.size(); i++)
+      window[i] = (float) std::pow(std::sin(M_PI * i / window.size()), 2);
+
+   sdr::SignalKernel::select(sdr::SignalKernel::Generic);
+
+   auto reference = runKernels(pcm, window);
+
+   for (int level = sdr::SignalKernel::Generic + 1; level <= supported; level++)
+   {
+      sdr::SignalKernel::select(level);
+
+      bool pass = runKernels(pcm, window) == reference;
+
+      std::cout << "TEST KERNEL " << sdr::SignalKernel::name(level) << ": " << (pass ? "PASS" : "FAIL") << std::endl;
+   }
+
+   sdr::SignalKernel::select(supported);
+
+   return 0;
+}
+
+/*
+ * Scripted enumeration backend for device monitor tests
+ */
+struct MockBackend : sdr::DeviceMonitor::Backend
+{
+   bool notify;
+   bool changed = false;
+   std::vector<std::string> devices;
+
+   explicit MockBackend(bool notify) : notify(notify)
+   {
+   }
+
+   bool hotplug() override
+   {
+      return notify;
+   }
+
+   bool wait(int timeout) override
+   {
+      bool result = changed;
+      changed = false;
+      return result;
+   }
+
+   std::vector<std::string> enumerate() override
+   {
+      return devices;
+   }
+
+   // simulate bus change
+   void plug(const std::vector<std::string> &list)
+   {
+      devices = list;
+      changed = true;
+   }
+};
+
+/*
+ * Run one monitor update and compare generated events
+ */
+bool checkMonitor(sdr::DeviceMonitor &monitor, const std::vector<std::pair<int, std::string>> &expected)
+{
+   std::vector<std::pair<int, std::string>> events;
+
+   monitor.update([&events](int event, const std::string &name) {
+      events.emplace_back(event, name);
+   });
+
+   return events == expected;
+}
+
+/*
+ * Test device discovery driven by hotplug notifications and by polling fallback
+ */
+int testMonitor()
+{
+   bool pass = true;
+
+   // hotplug backend, enumeration only after notified changes
+   auto hotplug = std::make_shared<MockBackend>(true);
+
+   sdr::DeviceMonitor monitor1(hotplug, 5000, 0);
+
+   hotplug->devices = {"airspy://1"};
+
+   pass &= checkMonitor(monitor1, {{sdr::DeviceMonitor::Attach, "airspy://1"}});
+
+   for (int i = 0; i < 10; i++)
+      pass &= checkMonitor(monitor1, {});
+
+   pass &= monitor1.enumerations() == 1;
+
+   hotplug->plug({"airspy://1", "rtlsdr://2"});
+
+   pass &= checkMonitor(monitor1, {{sdr::DeviceMonitor::Attach, "rtlsdr://2"}});
+
+   hotplug->plug({"rtlsdr://2"});
+
+   pass &= checkMonitor(monitor1, {{sdr::DeviceMonitor::Detach, "airspy://1"}});
+
+   pass &= monitor1.deviceList() == std::vector<std::string> {"rtlsdr://2"};
+
+   // changes unrelated to radio devices does not generate events
+   hotplug->plug({"rtlsdr://2"});
+
+   pass &= checkMonitor(monitor1, {});
+
+   pass &= monitor1.enumerations() == 4;
+
+   // enumeration is delayed until bus is quiet during settle time
+   sdr::DeviceMonitor monitor2(hotplug, 5000, 50);
+
+   pass &= checkMonitor(monitor2, {{sdr::DeviceMonitor::Attach, "rtlsdr://2"}});
+
+   hotplug->plug({"rtlsdr://2", "airspy://3"});
+
+   pass &= checkMonitor(monitor2, {});
+
+   std::this_thread::sleep_for(std::chrono::milliseconds(60));
+
+   pass &= checkMonitor(monitor2, {{sdr::DeviceMonitor::Attach, "airspy://3"}});
+
+   pass &= monitor2.enumerations() == 2;
+
+   std::cout << "TEST MONITOR hotplug: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+   pass = true;
+
+   // polling backend, enumeration on each interval without notifications
+   auto polling = std::make_shared<MockBackend>(false);
+
+   sdr::DeviceMonitor monitor3(polling, 50, 0);
+
+   polling->devices = {"airspy://1"};
+
+   pass &= checkMonitor(monitor3, {{sdr::DeviceMonitor::Attach, "airspy://1"}});
+
+   polling->devices = {};
+
+   pass &= checkMonitor(monitor3, {});
+
+   pass &= monitor3.enumerations() == 1;
+
+   std::this_thread::sleep_for(std::chrono::milliseconds(60));
+
+   pass &= checkMonitor(monitor3, {{sdr::DeviceMonitor::Detach, "airspy://1"}});
+
+   pass &= monitor3.enumerations() == 2;
+
+   std::cout << "TEST MONITOR polling: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+   return 0;
+}
+
+/*
+ * Decode same signal streamed from two simulated receivers with different transfer size and delivery jitter, each
+ * receiver must decode the frames of a single decoder and merged stream must be ordered by aligned receiver time
+ */
+int testReceivers(const std::string &signal)
+{
+   size_t pos1 = signal.find(".wav");
+   size_t pos2 = signal.rfind("/");
+
+   if (pos1 == std::string::npos)
+      return -1;
+
+   std::string filename = signal;
+
+   if (pos2 != std::string::npos)
+      filename = signal.substr(pos2 + 1, pos1 - 4);
+
+   sdr::RecordDevice source(signal);
+
+   if (!source.open(sdr::RecordDevice::OpenMode::Read) || source.channelCount() != 1)
+      return -1;
+
+   std::list<nfc::NfcFrame> expected;
+
+   if (!readSignal(signal, expected, true))
+      return -1;
+
+   std::string rate = std::to_string(source.sampleRate());
+   // late transfers are delivered instead of dropped, so busy test hosts decode the whole signal
+   std::string devices = "sim://" + signal + "?rate=" + rate + "&transfer=16384&lag=0;sim://" + signal + "?rate=" + rate + "&transfer=65536&jitter=2000&lag=0";
+
+#ifdef __WIN32
+   _putenv_s("NFC_SIM_DEVICE", devices.c_str());
+#else
+   setenv("NFC_SIM_DEVICE", devices.c_str(), 1);
+#endif
+
+   std::mutex mutex;
+   std::atomic_int receivers {0};
+   std::list<nfc::NfcFrame> frames[3];
+   long long publishTraced = 0;
+   long long frameTraced[2] = {0, 0};
+
+   auto receiverStatusStream = rt::Subject<rt::Event>::name("receiver.status");
+   auto receiverCommandStream = rt::Subject<rt::Event>::name("receiver.command");
+   auto decoderStatusStream = rt::Subject<rt::Event>::name("decoder.status");
+   auto decoderCommandStream = rt::Subject<rt::Event>::name("decoder.command");
+
+   auto receiverStatusSubscription = receiverStatusStream->subscribe([&](const rt::Event &event) {
+      auto status = nlohmann::json::parse(event.get<std::string>("data").value());
+      receivers = status.contains("receivers") ? (int) status["receivers"].size() : 0;
+      std::lock_guard<std::mutex> lock(mutex);
+      if (status.contains("latency"))
+         publishTraced = std::max(publishTraced, status["latency"]["publish"]["count"].get<long long>());
+   });
+
+   // latency histograms per receiver, from device capture to merged frame emit
+   auto decoderStatusSubscription = decoderStatusStream->subscribe([&](const rt::Event &event) {
+      auto status = nlohmann::json::parse(event.get<std::string>("data").value());
+      std::lock_guard<std::mutex> lock(mutex);
+      for (const auto &channel: status.value("channels", nlohmann::json::array()))
+      {
+         int index = channel["index"];
+         if (index < 2)
+            frameTraced[index] = std::max(frameTraced[index], channel["latency"]["total"]["count"].get<long long>());
+      }
+   });
+
+   // per receiver streams, and merged stream last
+   std::vector<rt::Subject<nfc::NfcFrame>::Subscription> frameSubscriptions;
+
+   for (int i = 0; i < 3; i++)
+   {
+      auto stream = rt::Subject<nfc::NfcFrame>::name(i < 2 ? "decoder.frame." + std::to_string(i) : "decoder.frame");
+
+      frameSubscriptions.push_back(stream->subscribe([&, i](const nfc::NfcFrame &frame) {
+         std::lock_guard<std::mutex> lock(mutex);
+         if (frame.isPollFrame() || frame.isListenFrame())
+            frames[i].push_back(frame);
+      }));
+   }
+
+   bool pass = true;
+
+   {
+      rt::Executor executor {4, 4};
+
+      executor.submit(nfc::FrameDecoderTask::construct());
+      executor.submit(nfc::SignalReceiverTask::construct());
+
+      // wait until both devices are attached
+      for (int i = 0; i < 200 && receivers < 2; i++)
+         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+      pass &= receivers == 2;
+
+      std::atomic_bool started {false};
+
+      // overload control disabled, all buffers must be decoded
+      decoderCommandStream->next({nfc::FrameDecoderTask::Configure, {{"data", std::string(R"({"overload":{"enabled":false}})")}}});
+      decoderCommandStream->next({nfc::FrameDecoderTask::Start, [&]() { started = true; }});
+
+      // receivers start once decoder is listening
+      for (int i = 0; i < 200 && !started; i++)
+         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+      receiverCommandStream->next({nfc::SignalReceiverTask::Start});
+
+      // signal is repeated by devices, wait for two full rounds
+      std::this_thread::sleep_for(std::chrono::milliseconds(500 + 2000 * source.sampleCount() / source.sampleRate()));
+
+      std::atomic_bool stopped {false};
+
+      receiverCommandStream->next({nfc::SignalReceiverTask::Stop});
+      decoderCommandStream->next({nfc::FrameDecoderTask::Stop, [&]() { stopped = true; }});
+
+      for (int i = 0; i < 200 && !stopped; i++)
+         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+      pass &= stopped;
+   }
+
+   std::lock_guard<std::mutex> lock(mutex);
+
+   // each receiver starts with the same frames as a single decoder
+   for (int i = 0; i < 2; i++)
+   {
+      auto frame = frames[i].begin();
+
+      for (const auto &reference: expected)
+      {
+         pass &= frame != frames[i].end() && *frame == reference && frame->frameSource() == i;
+
+         if (frame != frames[i].end())
+            frame++;
+      }
+   }
+
+   // merged stream contains all frames, in receiver order and ordered by aligned time within jitter tolerance
+   pass &= frames[2].size() == frames[0].size() + frames[1].size();
+
+   double last = 0;
+   std::list<nfc::NfcFrame>::iterator next[2] = {frames[0].begin(), frames[1].begin()};
+
+   for (const auto &frame: frames[2])
+   {
+      unsigned int source = frame.frameSource();
+
+      if (source > 1 || next[source] == frames[source].end() || *next[source] != frame)
+      {
+         pass = false;
+         break;
+      }
+
+      // emit hop traced on merged stream only, receiver stream copy is not changed after delivery
+      pass &= next[source]->traceTime(nfc::TraceHop::FrameEmit) == 0;
+
+      next[source]++;
+
+      // receivers start at nearly same time, so aligned time follows signal time within start skew of both devices
+      pass &= frame.timeStart() > last - 0.05;
+
+      // each hop traced in pipeline order
+      pass &= frame.traceTime(nfc::TraceHop::DeviceCapture) > 0;
+      pass &= frame.traceTime(nfc::TraceHop::DeviceCapture) <= frame.traceTime(nfc::TraceHop::ReceiverPublish);
+      pass &= frame.traceTime(nfc::TraceHop::ReceiverPublish) <= frame.traceTime(nfc::TraceHop::DecoderDequeue);
+      pass &= frame.traceTime(nfc::TraceHop::DecoderDequeue) <= frame.traceTime(nfc::TraceHop::FrameEmit);
+
+      last = std::max(last, frame.timeStart());
+   }
+
+   // latency reported in status events
+   pass &= publishTraced > 0 && frameTraced[0] > 0 && frameTraced[1] > 0;
+
+   std::cout << "TEST RECEIVERS " << filename << ": " << (pass ? "PASS" : "FAIL") << std::endl;
+
+   return 0;
+}
+
+/*
+ * Stream from a simulated device much faster than decoder can process, overload control must degrade decoding
+ * step by step, keep queue bounded and report dropped signal with gap frames
+ */
+int testOverload()
+{
+#ifdef __WIN32
+   _putenv_s("NFC_SIM_DEVICE", "sim://generator?rate=10000000&lag=0");
+#else
+   setenv("NFC_SIM_DEVICE", "sim://generator?rate=10000000&lag=0", 1);
+#endif
+
+   std::mutex mutex;
+   std::atomic_int receivers {0};
+   std::atomic_bool stall {true};
+   nlohmann::json overload;
+   int maxLevel = 0;
+   int maxQueue = 0;
+   int gaps = 0;
+
+   auto receiverStatusStream = rt::Subject<rt::Event>::name("receiver.status");
+   auto receiverCommandStream = rt::Subject<rt::Event>::name("receiver.command");
+   auto decoderStatusStream = rt::Subject<rt::Event>::name("decoder.status");
+   auto decoderCommandStream = rt::Subject<rt::Event>::name("decoder.command");
+   auto frameStream = rt::Subject<nfc::NfcFrame>::name("decoder.frame.0");
+   auto signalStream = rt::Subject<sdr::SignalBuffer>::name("signal.raw");
+
+   auto receiverStatusSubscription = receiverStatusStream->subscribe([&](const rt::Event &event) {
+      auto status = nlohmann::json::parse(event.get<std::string>("data").value());
+      receivers = status.contains("receivers") ? (int) status["receivers"].size() : 0;
+   });
+
+   auto decoderStatusSubscription = decoderStatusStream->subscribe([&](const rt::Event &event) {
+      auto status = nlohmann::json::parse(event.get<std::string>("data").value());
+      std::lock_guard<std::mutex> lock(mutex);
+      if (status.contains("channels"))
+      {
+         auto channel = status["channels"][0];
+         overload = channel["overload"];
+         maxLevel = std::max(maxLevel, overload["level"].get<int>());
+         maxQueue = std::max(maxQueue, channel["queueSize"].get<int>());
+      }
+   });
+
+   auto frameSubscription = frameStream->subscribe([&](const nfc::NfcFrame &frame) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (frame.isCarrierOff() && frame.hasSyncError())
+         gaps++;
+   });
+
+   // buffers are delivered at half real time speed while stalled, so decoding lag grows at any host speed
+   auto signalSubscription = signalStream->subscribe([&](const sdr::SignalBuffer &buffer) {
+      if (stall && buffer.isValid())
+         std::this_thread::sleep_for(std::chrono::microseconds(long(2E6 * buffer.elements() / buffer.sampleRate())));
+   });
+
+   auto reached = [&](const std::function<bool()> &condition) {
+      for (int i = 0; i < 1000; i++)
+      {
+         {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (condition())
+               return true;
+         }
+
+         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+
+      return false;
+   };
+
+   bool pass = true;
+
+   {
+      rt::Executor executor {4, 4};
+
+      executor.submit(nfc::FrameDecoderTask::construct());
+      executor.submit(nfc::SignalReceiverTask::construct());
+
+      for (int i = 0; i < 200 && receivers < 1; i++)
+         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+      pass &= receivers == 1;
+
+      decoderCommandStream->next({nfc::FrameDecoderTask::Configure, {{"data", std::string(R"({"overload":{"queueLimit":16,"lagLimit":50}})")}}});
+      decoderCommandStream->next({nfc::FrameDecoderTask::Start});
+      receiverCommandStream->next({nfc::SignalReceiverTask::Start});
+
+      // stalled signal raises all levels, once released backlog is dropped until decoder catches up and reports the gap
+      pass &= reached([&] { return maxLevel == 4; });
+
+      stall = false;
+
+      pass &= reached([&] { return gaps > 0; });
+
+      std::atomic_bool stopped {false};
+
+      receiverCommandStream->next({nfc::SignalReceiverTask::Stop});
+      decoderCommandStream->next({nfc::FrameDecoderTask::Stop, [&]() { stopped = true; }});
+
+      for (int i = 0; i < 200 && !stopped; i++)
+         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+      pass &= stopped;
+   }
+
+   std::lock_guard<std::mutex> lock(mutex);
+
+   // all levels reached in order, each one counted
+   pass &= maxLevel == 4 && overload["escalations"] >= 4;
+   pass &= overload["shedBuffers"] > 0 && overload["decimatedBuffers"] > 0 && overload["droppedBuffers"] > 0;
+
+   // queue bounded by hard limit, dropped signal reported
+   pass &= maxQueue <= 16 * 4 + 1 && gaps > 0;
+
+   std::cout << "TEST OVERLOAD: " << (pass ? "PASS" : "FAIL") << std::endl;
+
+   return 0;
+}
+
+int testPath(const std::string &path)
+{
+   for (const auto &entry: rt::FileSystem::directoryList(path))
+   {
+      if (entry.name.find(".wav") != std::string::npos)
+      {
+         testFile(entry.name);
+         testReceivers(entry.name);
+      }
+      else if (entry.name.find(".json") != std::string::npos)
+      {
+         testJsonReader(entry.name);
+         testEncoder(entry.name);
+      }
+      else if (entry.name.find(".raw") != std::string::npos)
+      {
+         testIqConverter(entry.name);
+      }
+      else if (entry.name.find(".cu8") != std::string::npos)
+      {
+         testLookupConverter(entry.name);
+      }
+   }
+
+   return 0;
+}
+
+int main(int argc, char *argv[])
+{
+   logger.info("***********************************************************************");
+   logger.info("NFC laboratory, 2021 Jose Vicente Campos Martinez - <josevcm@gmail.com>");
+   logger.info("***********************************************************************");
+
+   testBuffer();
+
+   testIqConverter();
+
+   testLookupConverter();
+
+   testKernel();
+
+   testMonitor();
+
+   testOverload();
+
+   testRecord();
+
+   testFrameStore();
+
+   testJsonWriter();
+
+   testFrameHistory();
+
+   for (int i = 1; i < argc; i++)
+   {
+      std::string path {argv[i]};
+
+      if (rt::FileSystem::isDirectory(path))
+      {
+         logger.info("processing path {}", {path});
+
+         testPath(path);
+      }
+      else if (rt::FileSystem::isRegularFile(path))
+      {
+         logger.info("processing file {}", {path});
+
+         if (path.find(".raw") != std::string::npos)
+            testIqConverter(path);
+         else if (path.find(".cu8") != std::string::npos)
+            testLookupConverter(path);
+         else
+         {
+            testFile(path);
+            testReceivers(path);
+         }
       }
    }
 